@@ -0,0 +1,51 @@
+#pragma once
+// streambuf های بدون کپی برای cereal: OutputBuffer مستقیم در یک std::string می‌نویسد که بعد با move به
+// Net::Payload می‌رسد (بدون ss.str())، و InputView همان بافر دریافتی (مثلاً m.payload بعد از سرآیند) را می‌خواند
+#include <algorithm>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace Bytes {
+    // برای چند سریال‌سازی پشت سر هم؛ اندازه محتوای قبلی از اول رزرو می‌شود تا رشد بافر دوباره کپی نکند
+    class OutputBuffer : public std::streambuf {
+    public:
+        // headroom بایت صفر اول جای سرآیندی است که فرستنده بعداً در جا می‌نویسد (مثل نسخه)
+        void begin(size_t headroom = 0) {
+            data.clear();
+            data.reserve(std::max(expected, headroom));
+            data.resize(headroom, '\0');
+        }
+
+        // محتوا بدون کپی بیرون می‌آید؛ بعد از آن begin لازم است
+        std::string take() {
+            expected = data.size() + data.size() / 8;
+            return std::move(data);
+        }
+
+    protected:
+        std::streamsize xsputn(const char *s, std::streamsize n) override {
+            data.append(s, (size_t)n);
+            return n;
+        }
+
+        int_type overflow(int_type c) override {
+            if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+            data.push_back(traits_type::to_char_type(c));
+            return c;
+        }
+
+    private:
+        std::string data;
+        size_t expected = 0;
+    };
+
+    // فقط خواندن پشت سر هم؛ بافر باید تا پایان خواندن زنده بماند
+    class InputView : public std::streambuf {
+    public:
+        explicit InputView(std::string_view bytes) {
+            char *p = const_cast<char *>(bytes.data());
+            setg(p, p, p + bytes.size());
+        }
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+// فشرده‌سازی سریع بلوکی به سبک LZ4 بدون وابستگی بیرونی؛ برای پیام‌های شبکه (آرشیو مدار و نتیجه‌ها)
+// قالب: اندازه اصلی (u32) و بعد دنباله‌ها: توکن (۴ بیت طول literal، ۴ بیت طول match منهای ۴)،
+// بایت‌های اضافه طول (۲۵۵ یعنی ادامه دارد)، literal ها، فاصله match (u16) و بایت‌های اضافه طول match.
+// آخرین دنباله فقط literal دارد. پنجره ۶۴ کیلوبایت و حداقل match چهار بایت است
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Compression {
+    const size_t minMatch = 4;
+    const size_t window = 65535;
+
+    namespace detail {
+        inline std::uint32_t read32(const unsigned char *p) {
+            std::uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        inline std::uint32_t hash(std::uint32_t v) { return (v * 2654435761u) >> 18; }   // ۱۴ بیت
+
+        inline void writeLength(std::string &out, size_t n) {
+            for (; n >= 255; n -= 255) out.push_back((char)255);
+            out.push_back((char)n);
+        }
+
+        inline void emit(std::string &out, const unsigned char *literals, size_t literalLength, size_t offset, size_t matchLength) {
+            size_t m = matchLength ? matchLength - minMatch : 0;
+            out.push_back((char)(((literalLength < 15 ? literalLength : 15) << 4) | (m < 15 ? m : 15)));
+            if (literalLength >= 15) writeLength(out, literalLength - 15);
+            out.append((const char *)literals, literalLength);
+            if (!matchLength) return;
+            out.push_back((char)(offset & 0xff));
+            out.push_back((char)(offset >> 8));
+            if (m >= 15) writeLength(out, m - 15);
+        }
+    }
+
+    inline std::string compress(const char *data, size_t size) {
+        using namespace detail;
+        const unsigned char *src = (const unsigned char *)data;
+        std::string out;
+        out.reserve(size / 2 + 16);
+        for (int i = 0; i < 4; ++i) out.push_back((char)((size >> (8 * i)) & 0xff));
+
+        std::vector<std::uint32_t> table(1 << 14, 0);     // موقعیت + ۱؛ صفر یعنی خالی
+        size_t anchor = 0, i = 0, misses = 0;
+        while (size >= minMatch && i + minMatch <= size) {
+            std::uint32_t seq = read32(src + i);
+            std::uint32_t &slot = table[hash(seq)];
+            size_t ref = slot;
+            slot = (std::uint32_t)(i + 1);
+            if (ref && i - (ref - 1) <= window && read32(src + ref - 1) == seq) {
+                --ref;
+                size_t length = minMatch;
+                while (i + length < size && src[ref + length] == src[i + length]) ++length;
+                emit(out, src + anchor, i - anchor, i - ref, length);
+                i += length;
+                anchor = i;
+                misses = 0;
+            }
+            else {
+                // داده فشرده‌نشدنی را سریع‌تر رد می‌کند
+                i += 1 + (misses++ >> 6);
+            }
+        }
+        emit(out, src + anchor, size - anchor, 0, 0);
+        return out;
+    }
+
+    inline std::string compress(const std::string &data) { return compress(data.data(), data.size()); }
+
+    // false اگر داده خراب باشد (هر طول یا فاصله بیرون از محدوده) یا اندازه اصلی از limit بیشتر باشد
+    inline bool decompress(const char *data, size_t size, std::string &out, size_t limit = (size_t)-1) {
+        const unsigned char *p = (const unsigned char *)data, *end = p + size;
+        if (size < 4) return false;
+        size_t original = 0;
+        for (int i = 3; i >= 0; --i) original = (original << 8) | p[i];
+        p += 4;
+        // هر بایت ورودی حداکثر ۲۵۵ بایت خروجی می‌سازد؛ اندازه ادعایی بیشتر از آن ممکن نیست. بقیه بافر با پیش‌رفتن
+        // خروجی بزرگ می‌شود تا قاب چند بایتی با اندازه ادعایی بزرگ حافظه زیادی نگیرد
+        if (original > limit || original > (size - 4) * 255) return false;
+        out.clear();
+        out.reserve(original < (size - 4) * 16 ? original : (size - 4) * 16);
+        auto readLength = [&](size_t &n) {
+            unsigned char b;
+            do {
+                if (p >= end) return false;
+                b = *p++;
+                n += b;
+            } while (b == 255);
+            return true;
+        };
+        while (p < end) {
+            unsigned char token = *p++;
+            size_t literals = token >> 4;
+            if (literals == 15 && !readLength(literals)) return false;
+            if ((size_t)(end - p) < literals || out.size() + literals > original) return false;
+            out.append((const char *)p, literals);
+            p += literals;
+            if (p == end) break;
+            if (end - p < 2) return false;
+            size_t offset = p[0] | (p[1] << 8);
+            p += 2;
+            size_t length = token & 15;
+            if (length == 15 && !readLength(length)) return false;
+            length += minMatch;
+            if (offset == 0 || offset > out.size() || out.size() + length > original) return false;
+            size_t from = out.size() - offset;
+            if (offset >= length) out.append(out, from, length);
+            else {
+                for (size_t k = 0; k < length; ++k) out.push_back(out[from + k]);
+            }
+        }
+        return out.size() == original;
+    }
+}
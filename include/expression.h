@@ -0,0 +1,383 @@
+#pragma once
+// عبارت پروب (مثل V(out)/V(in) یا dB(V(out)(amp))) یک بار به بایت‌کد روی اندیس ستون‌ها کامپایل می‌شود
+// و هر دستور روی کل ستون اجرا می‌شود (حلقه‌های ساده که کامپایلر برداری می‌کند)
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "units.h"
+
+namespace Expressions {
+    enum class Op {
+        Column, Constant,
+        Add, Sub, Mul, Div, Min, Max,       // دوتایی، نمونه به نمونه
+        Neg, Abs, Sqrt, Log10, Db,          // یکتایی، نمونه به نمونه
+        MinOf, MaxOf,                       // کمینه/بیشینه کل ستون
+        Derivative, Integral, MovingAverage // وابسته به نمونه‌های قبلی و ستون زمان
+    };
+
+    struct Instruction {
+        Op op;
+        int column = -1;    // برای Op::Column
+        double value = 0.0; // برای Op::Constant و طول پنجره Op::MovingAverage
+    };
+
+    class Program {
+    public:
+        std::vector<Instruction> code;     // postfix
+        std::vector<std::string> signals;  // signals[i] نام سیگنال ستون i (مثل V(out) یا I(R1)(amp))
+        int maxDepth = 0;
+
+        bool needsTime() const {
+            for (const Instruction &ins : code) {
+                if (ins.op == Op::Derivative || ins.op == Op::Integral) return true;
+            }
+            return false;
+        }
+
+        // columns[i] داده سیگنال signals[i] با حداقل count نمونه؛ nullptr یعنی ستون صفر (مثل V(N00))
+        // time محور افقی (زمان یا فرکانس) برای derivative و integral
+        void evaluate(const std::vector<const double *> &columns, const double *time, size_t count,
+                      std::vector<double> &out) const {
+            if (columns.size() < signals.size()) throw std::runtime_error("Missing signal columns");
+            if (!time && needsTime()) throw std::runtime_error("derivative/integral need a time column");
+            std::vector<std::vector<double>> scratch(maxDepth);
+            std::vector<const double *> stack(maxDepth);
+            auto buffer = [&](int slot) {
+                scratch[slot].resize(count);
+                return scratch[slot].data();
+            };
+            // نتیجه کرنل‌هایی که نمونه‌های قبلی را می‌خوانند در بافر جدا ساخته می‌شود
+            auto replace = [&](int slot, std::vector<double> &result) {
+                scratch[slot].swap(result);
+                stack[slot] = scratch[slot].data();
+            };
+            int top = -1;
+            for (const Instruction &ins : code) {
+                switch (ins.op) {
+                    case Op::Column: {
+                        ++top;
+                        const double *column = columns[ins.column];
+                        if (column) {
+                            stack[top] = column;
+                        }
+                        else {
+                            double *r = buffer(top);
+                            std::fill(r, r + count, 0.0);
+                            stack[top] = r;
+                        }
+                        break;
+                    }
+                    case Op::Constant: {
+                        ++top;
+                        double *r = buffer(top);
+                        std::fill(r, r + count, ins.value);
+                        stack[top] = r;
+                        break;
+                    }
+                    case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Min: case Op::Max: {
+                        const double *a = stack[top - 1];
+                        const double *b = stack[top];
+                        double *r = buffer(top - 1);
+                        switch (ins.op) {
+                            case Op::Add: for (size_t i = 0; i < count; ++i) r[i] = a[i] + b[i]; break;
+                            case Op::Sub: for (size_t i = 0; i < count; ++i) r[i] = a[i] - b[i]; break;
+                            case Op::Mul: for (size_t i = 0; i < count; ++i) r[i] = a[i] * b[i]; break;
+                            case Op::Div: for (size_t i = 0; i < count; ++i) r[i] = a[i] / b[i]; break;
+                            case Op::Min: for (size_t i = 0; i < count; ++i) r[i] = a[i] < b[i] ? a[i] : b[i]; break;
+                            default: for (size_t i = 0; i < count; ++i) r[i] = a[i] > b[i] ? a[i] : b[i]; break;
+                        }
+                        stack[--top] = r;
+                        break;
+                    }
+                    case Op::Neg: case Op::Abs: case Op::Sqrt: case Op::Log10: case Op::Db: {
+                        const double *a = stack[top];
+                        double *r = buffer(top);
+                        switch (ins.op) {
+                            case Op::Neg: for (size_t i = 0; i < count; ++i) r[i] = -a[i]; break;
+                            case Op::Abs: for (size_t i = 0; i < count; ++i) r[i] = std::fabs(a[i]); break;
+                            case Op::Sqrt: for (size_t i = 0; i < count; ++i) r[i] = std::sqrt(a[i]); break;
+                            case Op::Log10: for (size_t i = 0; i < count; ++i) r[i] = std::log10(a[i]); break;
+                            default: for (size_t i = 0; i < count; ++i) r[i] = 20.0 * std::log10(std::fabs(a[i])); break;
+                        }
+                        stack[top] = r;
+                        break;
+                    }
+                    case Op::MinOf: case Op::MaxOf: {
+                        const double *a = stack[top];
+                        double m = std::numeric_limits<double>::quiet_NaN();
+                        for (size_t i = 0; i < count; ++i) {
+                            if (std::isnan(a[i])) continue;
+                            if (std::isnan(m) || (ins.op == Op::MinOf ? a[i] < m : a[i] > m)) m = a[i];
+                        }
+                        double *r = buffer(top);
+                        std::fill(r, r + count, m);
+                        stack[top] = r;
+                        break;
+                    }
+                    case Op::Derivative: {
+                        // تفاضل عقب‌رو؛ گام زمانی صفر (نقطه تکراری) شیب قبلی را نگه می‌دارد
+                        const double *a = stack[top];
+                        std::vector<double> r(count, 0.0);
+                        for (size_t i = 1; i < count; ++i) {
+                            double dt = time[i] - time[i - 1];
+                            r[i] = dt != 0.0 ? (a[i] - a[i - 1]) / dt : r[i - 1];
+                        }
+                        if (count > 1) r[0] = r[1];
+                        replace(top, r);
+                        break;
+                    }
+                    case Op::Integral: {
+                        // انتگرال تجمعی ذوزنقه‌ای از اولین نمونه
+                        const double *a = stack[top];
+                        std::vector<double> r(count, 0.0);
+                        for (size_t i = 1; i < count; ++i) {
+                            r[i] = r[i - 1] + 0.5 * (a[i] + a[i - 1]) * (time[i] - time[i - 1]);
+                        }
+                        replace(top, r);
+                        break;
+                    }
+                    case Op::MovingAverage: {
+                        // میانگین ins.value نمونه آخر با جمع لغزان
+                        const double *a = stack[top];
+                        size_t window = (size_t)ins.value;
+                        std::vector<double> r(count);
+                        double sum = 0.0;
+                        for (size_t i = 0; i < count; ++i) {
+                            sum += a[i];
+                            if (i >= window) sum -= a[i - window];
+                            r[i] = sum / (double)std::min(i + 1, window);
+                        }
+                        replace(top, r);
+                        break;
+                    }
+                }
+            }
+            out.assign(stack[0], stack[0] + count);
+        }
+    };
+
+    namespace detail {
+        // ورودی پشته عملگرها در shunting-yard
+        struct Pending {
+            enum Kind { Binary, Unary, Paren, Function } kind;
+            char symbol;         // Binary/Unary: + - * /
+            std::string name;    // Function
+            int args = 1;        // Function: تعداد آرگومان‌های دیده شده
+
+            Pending(Kind kind, char symbol = 0, std::string name = "") : kind(kind), symbol(symbol), name(std::move(name)) {}
+        };
+
+        inline int precedence(const Pending &p) {
+            if (p.kind == Pending::Unary) return 3;
+            return (p.symbol == '*' || p.symbol == '/') ? 2 : (p.symbol == '+' || p.symbol == '-') ? 1 : 0;
+        }
+
+        inline Op binaryOp(char op) {
+            switch (op) {
+                case '+': return Op::Add;
+                case '-': return Op::Sub;
+                case '*': return Op::Mul;
+                default: return Op::Div;
+            }
+        }
+
+        inline bool isFunction(const std::string &name) {
+            static const char *names[] = {"abs", "sqrt", "log10", "dB", "min", "max",
+                                          "derivative", "integral", "movavg"};
+            for (const char *n : names) {
+                if (name == n) return true;
+            }
+            return false;
+        }
+
+        // شروع نام سیگنال V(...) یا I(...) (نه تابع یا عدد)
+        inline bool isSignalAt(const std::string &expr, size_t i) {
+            return (expr[i] == 'V' || expr[i] == 'I') && i + 1 < expr.size() && expr[i + 1] == '(' &&
+                   (i == 0 || !isalnum((unsigned char)expr[i - 1]));
+        }
+
+        // V(x) با پسوند اختیاری (amp) یا (phase) تحلیل AC؛ i روی آخرین کاراکتر می‌رود
+        inline std::string readSignal(const std::string &expr, size_t &i) {
+            size_t end = expr.find(')', i);
+            if (end == std::string::npos) throw std::runtime_error("Missing ) in " + expr);
+            if (expr.compare(end + 1, 5, "(amp)") == 0) end += 5;
+            else if (expr.compare(end + 1, 7, "(phase)") == 0) end += 7;
+            std::string name = expr.substr(i, end - i + 1);
+            i = end;
+            return name;
+        }
+    }
+
+    // shunting-yard مستقیم به بایت‌کد؛ عبارت نامعتبر std::runtime_error
+    //   عملگرها: + - * / و منفی یکتایی، اعداد با توان و پسوند (1e-3، 10k، 2.2u)
+    //   توابع: abs sqrt log10 dB derivative integral، min(x)/max(x) کل ستون، min(a,b)/max(a,b) نمونه به نمونه،
+    //   movavg(x, n) با n ثابت، phase(V(x)) همان V(x)(phase)
+    inline Program compile(const std::string &expr) {
+        using detail::Pending;
+        Program program;
+        std::vector<Pending> operators;
+        int depth = 0;
+        bool expectOperand = true; // منفی یکتایی فقط جایی که عملوند انتظار می‌رود
+
+        auto emit = [&](const Instruction &ins, int operands) {
+            if (depth < operands) throw std::runtime_error("Invalid expression " + expr);
+            depth += 1 - operands;
+            program.maxDepth = std::max(program.maxDepth, depth);
+            program.code.push_back(ins);
+        };
+        auto pushSignal = [&](const std::string &name) {
+            auto it = std::find(program.signals.begin(), program.signals.end(), name);
+            int column = (int)(it - program.signals.begin());
+            if (it == program.signals.end()) program.signals.push_back(name);
+            emit({Op::Column, column}, 0);
+        };
+        auto emitFunction = [&](const Pending &f) {
+            const std::string &n = f.name;
+            if ((n == "min" || n == "max") && f.args == 2) {
+                emit({n == "min" ? Op::Min : Op::Max}, 2);
+                return;
+            }
+            if (n == "movavg") {
+                // طول پنجره باید عدد ثابت باشد و از کد برداشته می‌شود
+                if (f.args != 2 || program.code.back().op != Op::Constant || program.code.back().value < 1)
+                    throw std::runtime_error("movavg(x, n) needs a constant window n >= 1");
+                double window = std::floor(program.code.back().value);
+                program.code.pop_back();
+                --depth;
+                emit({Op::MovingAverage, -1, window}, 1);
+                return;
+            }
+            if (f.args != 1) throw std::runtime_error(n + "() takes one argument");
+            Op op = n == "abs" ? Op::Abs : n == "sqrt" ? Op::Sqrt : n == "log10" ? Op::Log10 :
+                    n == "dB" ? Op::Db : n == "min" ? Op::MinOf : n == "max" ? Op::MaxOf :
+                    n == "derivative" ? Op::Derivative : Op::Integral;
+            emit({op}, 1);
+        };
+        auto popOperator = [&]() {
+            Pending p = operators.back();
+            operators.pop_back();
+            if (p.kind == Pending::Unary) emit({Op::Neg}, 1);
+            else emit({detail::binaryOp(p.symbol)}, 2);
+        };
+        // تا پرانتز باز (که برداشته نمی‌شود)
+        auto popUntilParen = [&]() {
+            while (!operators.empty() && operators.back().kind != Pending::Paren) popOperator();
+            if (operators.empty()) throw std::runtime_error("Unbalanced ) in " + expr);
+        };
+
+        for (size_t i = 0; i < expr.size(); ++i) {
+            char c = expr[i];
+            if (isspace((unsigned char)c)) continue;
+
+            if (detail::isSignalAt(expr, i)) {
+                if (!expectOperand) throw std::runtime_error("Missing operator in " + expr);
+                pushSignal(detail::readSignal(expr, i));
+                expectOperand = false;
+            }
+            else if (isdigit((unsigned char)c) || c == '.') {
+                if (!expectOperand) throw std::runtime_error("Missing operator in " + expr);
+                size_t start = i;
+                size_t j = i;
+                while (j < expr.size() && (isdigit((unsigned char)expr[j]) || expr[j] == '.')) ++j;
+                if (j < expr.size() && (expr[j] == 'e' || expr[j] == 'E')) {
+                    size_t k = j + 1;
+                    if (k < expr.size() && (expr[k] == '+' || expr[k] == '-')) ++k;
+                    if (k < expr.size() && isdigit((unsigned char)expr[k])) {
+                        j = k;
+                        while (j < expr.size() && isdigit((unsigned char)expr[j])) ++j;
+                    }
+                }
+                while (j < expr.size() && isalpha((unsigned char)expr[j])) ++j; // پسوند مهندسی
+                std::string number = expr.substr(start, j - start);
+                double value = 0.0;
+                if (!Units::parse(number, value)) throw std::runtime_error("Invalid number " + number);
+                emit({Op::Constant, -1, value}, 0);
+                i = j - 1;
+                expectOperand = false;
+            }
+            else if (isalpha((unsigned char)c)) {
+                if (!expectOperand) throw std::runtime_error("Missing operator in " + expr);
+                size_t j = i;
+                while (j < expr.size() && (isalnum((unsigned char)expr[j]) || expr[j] == '_')) ++j;
+                std::string name = expr.substr(i, j - i);
+                while (j < expr.size() && isspace((unsigned char)expr[j])) ++j;
+                if (j >= expr.size() || expr[j] != '(') throw std::runtime_error("Unknown name " + name);
+
+                if (name == "phase") {
+                    // فاز فقط از ستون (phase) خود سیگنال می‌آید
+                    size_t k = j + 1;
+                    while (k < expr.size() && isspace((unsigned char)expr[k])) ++k;
+                    if (k >= expr.size() || !detail::isSignalAt(expr, k)) throw std::runtime_error("phase() expects V(...) or I(...)");
+                    std::string signal = detail::readSignal(expr, k);
+                    if (signal.back() != ')' || signal.find("(amp)") != std::string::npos ||
+                        signal.find("(phase)") != std::string::npos) throw std::runtime_error("phase() expects V(...) or I(...)");
+                    ++k;
+                    while (k < expr.size() && isspace((unsigned char)expr[k])) ++k;
+                    if (k >= expr.size() || expr[k] != ')') throw std::runtime_error("phase() expects V(...) or I(...)");
+                    pushSignal(signal + "(phase)");
+                    i = k;
+                    expectOperand = false;
+                    continue;
+                }
+                if (!detail::isFunction(name)) throw std::runtime_error("Unknown function " + name);
+                operators.emplace_back(Pending::Function, 0, name);
+                operators.emplace_back(Pending::Paren);
+                i = j;
+                expectOperand = true;
+            }
+            else if (c == '+' || c == '-' || c == '*' || c == '/') {
+                if (expectOperand) {
+                    if (c == '+') continue;
+                    if (c != '-') throw std::runtime_error(std::string("Unexpected '") + c + "' in " + expr);
+                    operators.emplace_back(Pending::Unary, '-');
+                    continue;
+                }
+                Pending p{Pending::Binary, c};
+                while (!operators.empty() &&
+                       (operators.back().kind == Pending::Binary || operators.back().kind == Pending::Unary) &&
+                       detail::precedence(operators.back()) >= detail::precedence(p)) {
+                    popOperator();
+                }
+                operators.push_back(p);
+                expectOperand = true;
+            }
+            else if (c == '(') {
+                if (!expectOperand) throw std::runtime_error("Missing operator in " + expr);
+                operators.emplace_back(Pending::Paren);
+            }
+            else if (c == ',') {
+                if (expectOperand) throw std::runtime_error("Missing argument in " + expr);
+                popUntilParen();
+                if (operators.size() < 2 || operators[operators.size() - 2].kind != Pending::Function)
+                    throw std::runtime_error("',' outside a function call in " + expr);
+                ++operators[operators.size() - 2].args;
+                expectOperand = true;
+            }
+            else if (c == ')') {
+                if (expectOperand) throw std::runtime_error("Missing operand before ) in " + expr);
+                popUntilParen();
+                operators.pop_back();
+                if (!operators.empty() && operators.back().kind == Pending::Function) {
+                    emitFunction(operators.back());
+                    operators.pop_back();
+                }
+            }
+            else {
+                throw std::runtime_error(std::string("Unexpected character '") + c + "' in " + expr);
+            }
+        }
+        while (!operators.empty()) {
+            if (operators.back().kind != Pending::Binary && operators.back().kind != Pending::Unary)
+                throw std::runtime_error("Unbalanced ( in " + expr);
+            popOperator();
+        }
+        if (depth != 1) throw std::runtime_error("Invalid expression " + expr);
+        return program;
+    }
+}
@@ -0,0 +1,283 @@
+#pragma once
+// دفتر تغییرات برای بازیابی بعد از crash: هر رکورد (seq، طول، hash، محتوا) به انتهای فایل اضافه می‌شود
+// نوشتن فایل روی یک رشته پس‌زمینه و به ترتیب درخواست‌هاست تا رابط کاربر منتظر دیسک نماند
+// checkpoint بعد از نوشتن snapshot فایل دفتر را خالی می‌کند؛ رکورد ناقص یا خراب انتهای فایل نادیده گرفته می‌شود
+// رکوردهای هر دسته با fsync روی دیسک می‌روند تا بعد از crash سیستم‌عامل یا قطع برق هم بمانند
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "project.h"
+
+#ifndef _WIN32
+#include <sys/file.h>
+#endif
+
+namespace Journaling {
+    struct Record {
+        std::uint64_t seq = 0;
+        std::string payload;
+    };
+
+    // قفل انحصاری یک فایل تا از بین رفتن شیء یا پایان پروسه (حتی با crash)
+    // فایل قفل پاک نمی‌شود: پاک کردن آن با نمونه‌ای که همان لحظه بازش کرده مسابقه دارد
+    class FileLock {
+    public:
+        explicit FileLock(const std::string &path) {
+#ifdef _WIN32
+            handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd >= 0 && ::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+#endif
+        }
+
+        ~FileLock() {
+#ifdef _WIN32
+            if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+            if (fd >= 0) ::close(fd);
+#endif
+        }
+
+        FileLock(const FileLock &) = delete;
+        FileLock &operator=(const FileLock &) = delete;
+
+        bool held() const {
+#ifdef _WIN32
+            return handle != INVALID_HANDLE_VALUE;
+#else
+            return fd >= 0;
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // هر نمونه برنامه دفتر و snapshot خودش را دارد (prefix-N.journal و prefix-N.shirali) و prefix-N.lock را قفل نگه می‌دارد
+    // قفل آزاد یعنی صاحب قبلی بسته شده یا crash کرده؛ شماره‌ای که فایل جا مانده برای بازیابی دارد اول انتخاب می‌شود
+    class InstanceSlot {
+    public:
+        explicit InstanceSlot(const std::string &prefix, int slots = 32) : prefix(prefix) {
+            for (int i = 0; i < slots; ++i) {
+                auto candidate = std::make_unique<FileLock>(file(i, ".lock"));
+                if (!candidate->held()) continue;
+                bool leftover = std::ifstream(file(i, ".journal")).good() || std::ifstream(file(i, ".shirali")).good();
+                if (!lock || leftover) {
+                    lock = std::move(candidate);
+                    index = i;
+                }
+                if (leftover) return;
+            }
+            // همه شماره‌ها در دست نمونه‌های دیگر؛ شماره بعدی بدون قفل
+            if (!lock) index = slots;
+        }
+
+        std::string journalPath() const { return file(index, ".journal"); }
+        std::string snapshotPath() const { return file(index, ".shirali"); }
+
+    private:
+        std::string prefix;
+        std::unique_ptr<FileLock> lock;
+        int index = 0;
+
+        std::string file(int i, const char *extension) const { return prefix + "-" + std::to_string(i) + extension; }
+    };
+
+    class Journal {
+    public:
+        // firstSeq: آخرین شماره رکورد جا مانده در فایل، تا رکوردهای تازه بعد از آن شماره بگیرند
+        explicit Journal(std::string path, std::uint64_t firstSeq = 0)
+                : path(std::move(path)), lastSeq(firstSeq), writer([this]() { writerLoop(); }) {}
+
+        ~Journal() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            wake.notify_all();
+            writer.join();
+        }
+
+        Journal(const Journal &) = delete;
+        Journal &operator=(const Journal &) = delete;
+
+        // شماره رکورد را برمی‌گرداند؛ نوشتن در پس‌زمینه
+        std::uint64_t append(std::string payload) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Job job;
+            job.record.seq = ++lastSeq;
+            job.record.payload = std::move(payload);
+            jobs.push_back(std::move(job));
+            ++recordsSinceCheckpoint;
+            wake.notify_all();
+            return lastSeq;
+        }
+
+        std::uint64_t sequence() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            return lastSeq;
+        }
+
+        size_t sinceCheckpoint() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            return recordsSinceCheckpoint;
+        }
+
+        // writeSnapshot بعد از همه رکوردهای قبلی روی رشته پس‌زمینه اجرا می‌شود؛ اگر true برگرداند دفتر خالی می‌شود
+        // snapshot باید seq داده شده را نگه دارد تا بازیابی رکوردهای تا همان شماره را دوباره اعمال نکند
+        void checkpoint(std::function<bool(std::uint64_t seq)> writeSnapshot) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Job job;
+            job.record.seq = lastSeq;
+            job.snapshot = std::move(writeSnapshot);
+            jobs.push_back(std::move(job));
+            recordsSinceCheckpoint = 0;
+            wake.notify_all();
+        }
+
+        // کار دلخواه (مثل ذخیره فایل) به ترتیب بقیه نوشتن‌ها
+        void post(std::function<void()> task) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Job job;
+            job.task = std::move(task);
+            jobs.push_back(std::move(job));
+            wake.notify_all();
+        }
+
+        // تا نوشته شدن همه کارهای صف
+        void wait() {
+            std::unique_lock<std::mutex> lock(mtx);
+            idle.wait(lock, [this]() { return jobs.empty() && !busy; });
+        }
+
+        // بعد از خروج عادی دیگر چیزی برای بازیابی نیست
+        void discard() {
+            wait();
+            std::remove(path.c_str());
+        }
+
+        // رکوردهای سالم فایل به ترتیب (little-endian)؛ در اولین رکورد ناقص یا با hash نادرست متوقف می‌شود.
+        // طول سرآیند تکه‌تکه نوشته شده قابل اعتماد نیست: بیشتر از بایت‌های باقی‌مانده یعنی انتهای ناقص
+        static std::vector<Record> read(const std::string &path) {
+            std::vector<Record> records;
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            std::streamoff size = in.tellg();
+            in.seekg(0);
+            char head[20];
+            while (in.read(head, sizeof(head))) {
+                Record r;
+                r.seq = readBytes(head, 8);
+                std::uint32_t length = (std::uint32_t)readBytes(head + 8, 4);
+                std::uint64_t h = readBytes(head + 12, 8);
+                if ((std::streamoff)length > size - (std::streamoff)in.tellg()) break;
+                r.payload.resize(length);
+                if (length && !in.read(&r.payload[0], length)) break;
+                if (Project::hash(r.payload) != h) break;
+                records.push_back(std::move(r));
+            }
+            return records;
+        }
+
+    private:
+        struct Job {
+            Record record;                                      // رکورد دفتر، مگر snapshot یا task داشته باشد
+            std::function<bool(std::uint64_t)> snapshot;
+            std::function<void()> task;
+        };
+
+        std::string path;
+        mutable std::mutex mtx;
+        std::condition_variable wake, idle;
+        std::deque<Job> jobs;
+        bool busy = false, stopping = false;
+        std::uint64_t lastSeq = 0;
+        size_t recordsSinceCheckpoint = 0;
+        std::thread writer;     // آخرین عضو تا بعد از بقیه ساخته شود
+
+        void writerLoop() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true) {
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                std::deque<Job> batch;
+                batch.swap(jobs);
+                busy = true;
+                lock.unlock();
+                run(batch);
+                lock.lock();
+                busy = false;
+                if (jobs.empty()) idle.notify_all();
+            }
+        }
+
+        // رکوردهای پشت سر هم با یک بار باز کردن فایل نوشته و با یک fsync روی دیسک می‌روند
+        // خطای یک کار (cereal، فایل) گزارش می‌شود و رشته ادامه می‌دهد؛ استثنای بیرون رفته برنامه را می‌بست
+        void run(std::deque<Job> &batch) {
+            std::ofstream out;
+            auto finish = [this, &out]() {
+                if (!out.is_open()) return;
+                out.close();
+                if (!Project::syncFile(path)) std::cerr << "Journal: could not sync " << path << "\n";
+            };
+            for (Job &job : batch) {
+                try {
+                    if (job.task) {
+                        finish();
+                        job.task();
+                    }
+                    else if (job.snapshot) {
+                        finish();
+                        if (job.snapshot(job.record.seq)) std::ofstream(path, std::ios::binary | std::ios::trunc);
+                    }
+                    else {
+                        if (!out.is_open()) out.open(path, std::ios::binary | std::ios::app);
+                        writeRecord(out, job.record);
+                    }
+                }
+                catch (const std::exception &e) {
+                    std::cerr << "Journal: " << e.what() << "\n";
+                }
+                catch (...) {
+                    std::cerr << "Journal: unknown error\n";
+                }
+            }
+            finish();
+        }
+
+        static void writeRecord(std::ostream &out, const Record &r) {
+            char head[20];
+            writeBytes(head, r.seq, 8);
+            writeBytes(head + 8, r.payload.size(), 4);
+            writeBytes(head + 12, Project::hash(r.payload), 8);
+            out.write(head, sizeof(head));
+            out.write(r.payload.data(), (std::streamsize)r.payload.size());
+        }
+
+        static void writeBytes(char *p, std::uint64_t v, int n) {
+            for (int i = 0; i < n; ++i, v >>= 8) p[i] = (char)(v & 0xff);
+        }
+        static std::uint64_t readBytes(const char *p, int n) {
+            std::uint64_t v = 0;
+            for (int i = n - 1; i >= 0; --i) v = (v << 8) | (unsigned char)p[i];
+            return v;
+        }
+    };
+}
@@ -0,0 +1,376 @@
+#pragma once
+// اندازه‌گیری‌های شبیه .measure در SPICE: کاهنده‌هایی که در هر گام تحلیل یک نمونه می‌گیرند
+// و بدون نگه داشتن شکل موج یک عدد (زمان صعود، بیشینه، RMS، توان متوسط، پهنای باند و ...) می‌دهند
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "units.h"
+
+namespace Measurements {
+    enum class Kind { Max, Min, PeakToPeak, Average, Rms, Integral, FindAt, FindWhen, When, TrigTarg, Bandwidth };
+
+    // عبور سیگنال از یک مقدار: n-امین RISE، FALL یا CROSS بعد از زمان TD
+    struct Crossing {
+        enum Edge { Rise, Fall, Cross };
+        int signal = -1;
+        double value = 0.0;
+        Edge edge = Cross;
+        int count = 1;
+        double delay = -std::numeric_limits<double>::infinity();
+    };
+
+    struct Spec {
+        std::string line;       // متن اصلی برای گزارش و forAnalysis
+        std::string name;
+        std::string analysis;   // tran، ac، dc یا خالی یعنی همه
+        Kind kind = Kind::Max;
+        int signal = -1;        // اندیس در Session::signals()
+        double from = -std::numeric_limits<double>::infinity();
+        double to = std::numeric_limits<double>::infinity();
+        double at = 0.0;        // FIND ... AT=
+        Crossing trig, targ;    // WHEN و FIND ... WHEN فقط trig دارند
+    };
+
+    struct Result {
+        std::string name;
+        bool ok = false;
+        double value = 0.0;
+    };
+
+    class Session {
+    public:
+        //   [.meas[ure]] [tran|ac|dc] name MAX|MIN|PP|AVG|RMS|INTEG sig [FROM=x] [TO=x]
+        //   ... name FIND sig AT=x  |  FIND sig WHEN sig2=v [RISE|FALL|CROSS=n] [TD=x]
+        //   ... name WHEN sig=v [RISE|FALL|CROSS=n] [TD=x]
+        //   ... name TRIG sig VAL=v [RISE|FALL|CROSS=n] [TD=x] TARG sig VAL=v [RISE|FALL|CROSS=n] [TD=x]
+        //   ... name BW sig   (فرکانس -3dB نسبت به اولین نقطه جاروب AC)
+        // خطای نحوی std::runtime_error
+        void add(const std::string &line) {
+            std::vector<std::string> t = tokenize(line);
+            size_t i = 0;
+            if (i < t.size() && (lower(t[i]) == ".meas" || lower(t[i]) == ".measure")) ++i;
+            Spec s;
+            s.line = line;
+            if (i < t.size() && (lower(t[i]) == "tran" || lower(t[i]) == "ac" || lower(t[i]) == "dc")) s.analysis = lower(t[i++]);
+            if (i + 2 > t.size()) throw std::runtime_error("measure: expected name and type in '" + line + "'");
+            s.name = t[i++];
+            std::string kind = lower(t[i++]);
+
+            auto need = [&](const char *what) -> const std::string & {
+                if (i >= t.size()) throw std::runtime_error(std::string("measure ") + s.name + ": missing " + what);
+                return t[i++];
+            };
+            // KEY=value های اختیاری؛ trig برای RISE/FALL/CROSS/TD
+            auto options = [&](Crossing *crossing, bool window) {
+                while (i < t.size() && t[i].find('=') != std::string::npos) {
+                    size_t eq = t[i].find('=');
+                    std::string key = lower(t[i].substr(0, eq));
+                    double v = number(t[i].substr(eq + 1), s.name);
+                    if (window && key == "from") s.from = v;
+                    else if (window && key == "to") s.to = v;
+                    else if (crossing && (key == "rise" || key == "fall" || key == "cross")) {
+                        crossing->edge = key == "rise" ? Crossing::Rise : key == "fall" ? Crossing::Fall : Crossing::Cross;
+                        crossing->count = (int)v;
+                        if (crossing->count < 1) throw std::runtime_error("measure " + s.name + ": " + key + " must be >= 1");
+                    }
+                    else if (crossing && key == "td") crossing->delay = v;
+                    else throw std::runtime_error("measure " + s.name + ": unexpected " + t[i]);
+                    ++i;
+                }
+            };
+            // sig=v برای WHEN
+            auto condition = [&](Crossing &crossing) {
+                const std::string &token = need("condition sig=value");
+                size_t eq = token.rfind('=');
+                if (eq == std::string::npos) throw std::runtime_error("measure " + s.name + ": expected sig=value, got " + token);
+                crossing.signal = signalIndex(token.substr(0, eq));
+                crossing.value = number(token.substr(eq + 1), s.name);
+            };
+            // sig VAL=v برای TRIG و TARG
+            auto level = [&](Crossing &crossing) {
+                crossing.signal = signalIndex(need("signal"));
+                const std::string &token = need("VAL=");
+                if (lower(token).rfind("val=", 0) != 0) throw std::runtime_error("measure " + s.name + ": expected VAL=, got " + token);
+                crossing.value = number(token.substr(4), s.name);
+                options(&crossing, false);
+            };
+
+            if (kind == "max" || kind == "min" || kind == "pp" || kind == "avg" || kind == "rms" || kind == "integ" ||
+                kind == "integral") {
+                s.kind = kind == "max" ? Kind::Max : kind == "min" ? Kind::Min : kind == "pp" ? Kind::PeakToPeak :
+                         kind == "avg" ? Kind::Average : kind == "rms" ? Kind::Rms : Kind::Integral;
+                s.signal = signalIndex(need("signal"));
+                options(nullptr, true);
+            }
+            else if (kind == "find") {
+                s.signal = signalIndex(need("signal"));
+                const std::string &token = need("AT= or WHEN");
+                if (lower(token).rfind("at=", 0) == 0) {
+                    s.kind = Kind::FindAt;
+                    s.at = number(token.substr(3), s.name);
+                }
+                else if (lower(token) == "when") {
+                    s.kind = Kind::FindWhen;
+                    condition(s.trig);
+                    options(&s.trig, false);
+                }
+                else throw std::runtime_error("measure " + s.name + ": expected AT= or WHEN, got " + token);
+            }
+            else if (kind == "when") {
+                s.kind = Kind::When;
+                condition(s.trig);
+                options(&s.trig, false);
+            }
+            else if (kind == "trig") {
+                s.kind = Kind::TrigTarg;
+                level(s.trig);
+                if (lower(need("TARG")) != "targ") throw std::runtime_error("measure " + s.name + ": expected TARG");
+                level(s.targ);
+            }
+            else if (kind == "bw") {
+                s.kind = Kind::Bandwidth;
+                s.signal = signalIndex(need("signal"));
+                s.trig.signal = s.signal;
+                s.trig.edge = Crossing::Fall;
+            }
+            else throw std::runtime_error("measure " + s.name + ": unknown type " + kind);
+            if (i != t.size()) throw std::runtime_error("measure " + s.name + ": unexpected " + t[i]);
+
+            specs.push_back(s);
+            states.emplace_back();
+        }
+
+        // هر خط غیر خالی یک اندازه‌گیری؛ خطوط * توضیح‌اند
+        void addLines(const std::string &text) {
+            std::istringstream in(text);
+            std::string line;
+            while (std::getline(in, line)) {
+                size_t start = line.find_first_not_of(" \t\r");
+                if (start == std::string::npos || line[start] == '*') continue;
+                add(line.substr(start));
+            }
+        }
+
+        // اندازه‌گیری‌هایی که برای analysis (tran، ac، dc) یا بدون نوع تعریف شده‌اند
+        Session forAnalysis(const std::string &analysis) const {
+            Session r;
+            for (const Spec &s : specs) {
+                if (s.analysis.empty() || s.analysis == analysis) r.add(s.line);
+            }
+            return r;
+        }
+
+        bool empty() const { return specs.empty(); }
+        const std::vector<std::string> &signals() const { return signalNames; }
+
+        // مثلا نام شبکه‌های نت‌لیست به N0k در اجرای بدون بوم
+        void renameSignals(const std::function<std::string(const std::string &)> &rename) {
+            for (std::string &name : signalNames) name = rename(name);
+        }
+
+        void reset() {
+            for (State &st : states) st = State();
+            started = false;
+        }
+
+        // یک نقطه تحلیل؛ values[i] مقدار signals()[i] در x (زمان یا فرکانس)
+        void feed(double x, const std::vector<double> &values) {
+            for (size_t k = 0; k < specs.size(); ++k) {
+                const Spec &s = specs[k];
+                State &st = states[k];
+                if (s.signal >= 0) sample(s, st, x, values[s.signal]);
+                if (s.kind == Kind::FindAt && !st.done && (started ? prevX < s.at && s.at <= x : s.at == x)) {
+                    st.value = started ? interpolate(prevX, prevValues[s.signal], x, values[s.signal], s.at) : values[s.signal];
+                    st.done = true;
+                }
+                if (!started) continue;
+                switch (s.kind) {
+                    case Kind::Average: case Kind::Rms: case Kind::Integral:
+                        accumulate(s, st, prevX, prevValues[s.signal], x, values[s.signal]);
+                        break;
+                    case Kind::FindWhen: case Kind::When: case Kind::Bandwidth: {
+                        double xc;
+                        double level = s.kind == Kind::Bandwidth ? st.reference : s.trig.value;
+                        if (crossed(s.trig, st.trig, level, x, values, xc)) {
+                            st.value = s.kind == Kind::FindWhen ? interpolate(prevX, prevValues[s.signal], x, values[s.signal], xc) : xc;
+                            st.done = true;
+                        }
+                        break;
+                    }
+                    case Kind::TrigTarg: {
+                        double xc;
+                        if (crossed(s.trig, st.trig, s.trig.value, x, values, xc)) st.trigX = xc;
+                        if (crossed(s.targ, st.targ, s.targ.value, x, values, xc)) st.targX = xc;
+                        if (st.trig.done && st.targ.done) {
+                            st.value = st.targX - st.trigX;
+                            st.done = true;
+                        }
+                        break;
+                    }
+                    default: break;
+                }
+            }
+            prevX = x;
+            prevValues = values;
+            started = true;
+        }
+
+        std::vector<Result> results() const {
+            std::vector<Result> r;
+            for (size_t k = 0; k < specs.size(); ++k) {
+                const Spec &s = specs[k];
+                const State &st = states[k];
+                Result res;
+                res.name = s.name;
+                switch (s.kind) {
+                    case Kind::Max: res.ok = st.samples > 0; res.value = st.max; break;
+                    case Kind::Min: res.ok = st.samples > 0; res.value = st.min; break;
+                    case Kind::PeakToPeak: res.ok = st.samples > 0; res.value = st.max - st.min; break;
+                    case Kind::Average: res.ok = st.span > 0; res.value = res.ok ? st.integral / st.span : 0.0; break;
+                    case Kind::Rms: res.ok = st.span > 0; res.value = res.ok ? std::sqrt(st.integralSq / st.span) : 0.0; break;
+                    case Kind::Integral: res.ok = st.samples > 0; res.value = st.integral; break;
+                    default: res.ok = st.done; res.value = st.value; break;
+                }
+                r.push_back(res);
+            }
+            return r;
+        }
+
+        std::string summary() const {
+            std::ostringstream ss;
+            for (const Result &r : results()) {
+                ss << r.name << " = ";
+                if (r.ok) ss << r.value;
+                else ss << "FAILED";
+                ss << "\n";
+            }
+            return ss.str();
+        }
+
+        bool writeFile(const std::string &path) const {
+            std::ofstream out(path);
+            if (!out.is_open()) return false;
+            out << summary();
+            return true;
+        }
+
+    private:
+        struct CrossingState {
+            int seen = 0;
+            bool done = false;
+        };
+
+        struct State {
+            size_t samples = 0;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+            double integral = 0.0, integralSq = 0.0, span = 0.0;
+            CrossingState trig, targ;
+            double trigX = 0.0, targX = 0.0;
+            double reference = 0.0;     // BW: دامنه اولین نقطه تقسیم بر √2
+            bool done = false;
+            double value = 0.0;
+        };
+
+        std::vector<Spec> specs;
+        std::vector<State> states;
+        std::vector<std::string> signalNames;
+        bool started = false;
+        double prevX = 0.0;
+        std::vector<double> prevValues;
+
+        static std::string lower(std::string s) {
+            for (char &c : s) c = (char)tolower((unsigned char)c);
+            return s;
+        }
+
+        // فاصله دور = حذف می‌شود تا "V(out) = 0.5" یک توکن شود
+        static std::vector<std::string> tokenize(const std::string &line) {
+            std::string compact;
+            for (size_t i = 0; i < line.size(); ++i) {
+                char c = line[i];
+                if (c == ';') break;
+                if (isspace((unsigned char)c)) {
+                    size_t j = line.find_first_not_of(" \t\r", i);
+                    bool nearEqual = (!compact.empty() && compact.back() == '=') || (j != std::string::npos && line[j] == '=');
+                    if (!nearEqual && !compact.empty() && compact.back() != ' ') compact += ' ';
+                    continue;
+                }
+                compact += c;
+            }
+            std::vector<std::string> tokens;
+            std::istringstream in(compact);
+            std::string token;
+            while (in >> token) tokens.push_back(token);
+            return tokens;
+        }
+
+        static double number(const std::string &s, const std::string &name) {
+            double v = 0.0;
+            if (!Units::parse(s, v, Units::Syntax::Spice)) throw std::runtime_error("measure " + name + ": invalid number " + s);
+            return v;
+        }
+
+        // v(out) و V(out) یکی‌اند
+        int signalIndex(std::string name) {
+            if (name.size() < 4 || name[1] != '(' || name.find(')') == std::string::npos)
+                throw std::runtime_error("measure: expected V(...), I(...) or P(...), got " + name);
+            name[0] = (char)toupper((unsigned char)name[0]);
+            if (name[0] != 'V' && name[0] != 'I' && name[0] != 'P')
+                throw std::runtime_error("measure: expected V(...), I(...) or P(...), got " + name);
+            for (size_t i = 0; i < signalNames.size(); ++i) {
+                if (signalNames[i] == name) return (int)i;
+            }
+            signalNames.push_back(name);
+            return (int)signalNames.size() - 1;
+        }
+
+        static double interpolate(double x0, double y0, double x1, double y1, double x) {
+            return x1 == x0 ? y1 : y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+        }
+
+        // نقطه به نقطه: کمینه/بیشینه داخل پنجره و مرجع پهنای باند
+        static void sample(const Spec &s, State &st, double x, double y) {
+            if (s.kind == Kind::Bandwidth && st.samples++ == 0) {
+                st.reference = std::fabs(y) / std::sqrt(2.0);
+                return;
+            }
+            if (x < s.from || x > s.to) return;
+            ++st.samples;
+            if (y < st.min) st.min = y;
+            if (y > st.max) st.max = y;
+        }
+
+        // انتگرال ذوزنقه‌ای قطعه بریده شده با پنجره؛ مربع قطعه خطی دقیق انتگرال می‌شود
+        static void accumulate(const Spec &s, State &st, double x0, double y0, double x1, double y1) {
+            double a = std::max(x0, s.from), b = std::min(x1, s.to);
+            if (!(b > a)) return;
+            double ya = interpolate(x0, y0, x1, y1, a), yb = interpolate(x0, y0, x1, y1, b);
+            st.integral += 0.5 * (ya + yb) * (b - a);
+            st.integralSq += (ya * ya + ya * yb + yb * yb) / 3.0 * (b - a);
+            st.span += b - a;
+        }
+
+        bool crossed(const Crossing &c, CrossingState &cs, double level, double x, const std::vector<double> &values, double &xc) const {
+            if (cs.done) return false;
+            double y0 = prevValues[c.signal], y1 = values[c.signal];
+            bool rising = y0 < level && y1 >= level;
+            bool falling = y0 > level && y1 <= level;
+            if (!rising && !falling) return false;
+            xc = y1 == y0 ? x : prevX + (level - y0) * (x - prevX) / (y1 - y0);
+            if (xc < c.delay) return false;
+            if ((c.edge == Crossing::Rise && !rising) || (c.edge == Crossing::Fall && !falling)) return false;
+            if (++cs.seen < c.count) return false;
+            cs.done = true;
+            return true;
+        }
+    };
+}
@@ -0,0 +1,830 @@
+#pragma once
+// لایه شبکه ماندگار: یک سوکت گوش‌دهنده برای همه کلاینت‌ها و یک حلقه رویداد روی یک رشته
+// (epoll در لینوکس، WSAPoll در ویندوز). کلاینت اتصال را نگه می‌دارد
+// قاب هر پیام: سرآیند ۱۶ بایتی (طول u32، نوع u8، پرچم u8، دو بایت رزرو، شماره ترتیب u32، CRC32 محتوا) و بعد محتوا
+// شماره ترتیب هر جهت اتصال از ۱ پشت سر هم است؛ شماره یا CRC نادرست یعنی اتصال خراب و بسته می‌شود
+// اولین پیام هر اتصال hello است و فشرده‌سازی (compress.h) را برای همان اتصال روشن می‌کند اگر هر دو طرف بخواهند
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compress.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace Net {
+#ifdef _WIN32
+    using Handle = SOCKET;
+    const Handle invalidHandle = INVALID_SOCKET;
+    const int sendFlags = 0;
+    inline void closeHandle(Handle h) { closesocket(h); }
+    inline bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+    inline bool setNonBlocking(Handle h) {
+        u_long on = 1;
+        return ioctlsocket(h, FIONBIO, &on) == 0;
+    }
+#else
+    using Handle = int;
+    const Handle invalidHandle = -1;
+    const int sendFlags = MSG_NOSIGNAL;     // اتصال بسته شده SIGPIPE نفرستد
+    inline void closeHandle(Handle h) { close(h); }
+    inline bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+    inline bool setNonBlocking(Handle h) { return fcntl(h, F_SETFL, fcntl(h, F_GETFL, 0) | O_NONBLOCK) == 0; }
+#endif
+
+    // WSAStartup یک بار برای کل برنامه؛ WSACleanup هنگام خروج
+    inline void startup() {
+#ifdef _WIN32
+        struct Winsock {
+            Winsock() {
+                WSADATA wsaData;
+                WSAStartup(MAKEWORD(2, 2), &wsaData);
+            }
+            ~Winsock() { WSACleanup(); }
+        };
+        static Winsock winsock;
+#endif
+    }
+
+    inline void setNoDelay(Handle h) {
+        int on = 1;
+        setsockopt(h, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+    }
+
+    // recv بعد از timeout بدون داده شکست می‌خورد؛ صفر یعنی بدون محدودیت
+    inline void setReceiveTimeout(Handle h, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+        DWORD t = (DWORD)timeout.count();
+#else
+        timeval t{};
+        t.tv_sec = (time_t)(timeout.count() / 1000);
+        t.tv_usec = (suseconds_t)(timeout.count() % 1000 * 1000);
+#endif
+        setsockopt(h, SOL_SOCKET, SO_RCVTIMEO, (const char *)&t, sizeof(t));
+    }
+
+    // CRC-32 (چندجمله‌ای IEEE، همان zlib) با روش slicing-by-8: هشت بایت در هر دور
+    inline std::uint32_t crc32(const char *data, size_t size, std::uint32_t crc = 0) {
+        struct Tables {
+            std::uint32_t t[8][256];
+            Tables() {
+                for (std::uint32_t i = 0; i < 256; ++i) {
+                    std::uint32_t c = i;
+                    for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    t[0][i] = c;
+                }
+                for (std::uint32_t i = 0; i < 256; ++i) {
+                    for (int k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+                }
+            }
+        };
+        static const Tables tables;
+        const auto &t = tables.t;
+        const unsigned char *p = (const unsigned char *)data;
+        crc = ~crc;
+        for (; size >= 8; size -= 8, p += 8) {
+            std::uint32_t lo = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | ((std::uint32_t)p[3] << 24));
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+                  t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        }
+        while (size--) crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    struct Message {
+        std::uint8_t type = 0;
+        std::string payload;
+    };
+
+    // محتوای مشترک بین صف چند اتصال (broadcast) بدون کپی
+    using Payload = std::shared_ptr<const std::string>;
+
+    const size_t headerSize = 16;
+    const std::uint32_t maxPayload = 256u << 20;
+
+    // نوع صفر برای خود لایه شبکه است؛ محتوای hello یک بایت codec های پذیرفته است
+    const std::uint8_t helloType = 0;
+    const std::uint8_t lzCodec = 1;
+
+    const std::uint8_t compressedFlag = 1;      // محتوا با Compression فشرده شده و CRC روی همان بایت‌های فشرده است
+    const size_t compressMin = 512;             // پیام کوچک‌تر ارزش فشرده کردن ندارد
+
+    struct Header {
+        std::uint32_t length = 0;
+        std::uint8_t type = 0;
+        std::uint8_t flags = 0;
+        std::uint32_t sequence = 0;
+        std::uint32_t crc = 0;
+
+        void write(char *p) const {
+            writeU32(p, length);
+            p[4] = (char)type;
+            p[5] = (char)flags;
+            p[6] = p[7] = 0;
+            writeU32(p + 8, sequence);
+            writeU32(p + 12, crc);
+        }
+
+        // false یعنی سرآیند نامعتبر (طول بیش از maxPayload، پرچم ناشناخته یا بایت رزرو غیر صفر)
+        bool read(const char *p) {
+            length = readU32(p);
+            type = (std::uint8_t)p[4];
+            flags = (std::uint8_t)p[5];
+            sequence = readU32(p + 8);
+            crc = readU32(p + 12);
+            return length <= maxPayload && (flags & ~compressedFlag) == 0 && p[6] == 0 && p[7] == 0;
+        }
+
+        static void writeU32(char *p, std::uint32_t v) {
+            for (int i = 0; i < 4; ++i, v >>= 8) p[i] = (char)(v & 0xff);
+        }
+        static std::uint32_t readU32(const char *p) {
+            std::uint32_t v = 0;
+            for (int i = 3; i >= 0; --i) v = (v << 8) | (unsigned char)p[i];
+            return v;
+        }
+    };
+
+    // محتوای پیام دریافتی؛ false اگر محتوای فشرده خراب باشد
+    inline bool unpack(const Header &h, const char *body, std::string &out) {
+        if (!(h.flags & compressedFlag)) {
+            out.assign(body, h.length);
+            return true;
+        }
+        return Compression::decompress(body, h.length, out, maxPayload);
+    }
+
+    // محتوای فشرده فقط اگر واقعاً کوچک‌تر شود؛ وگرنه رشته خالی
+    inline std::string pack(const std::string &payload) {
+        if (payload.size() < compressMin) return "";
+        std::string packed = Compression::compress(payload);
+        return packed.size() < payload.size() ? packed : "";
+    }
+
+    // محتوای آماده ارسال: CRC و نسخه فشرده یک بار حساب می‌شوند و بین همه اتصال‌ها و ارسال‌های بعدی مشترک‌اند
+    struct Packet {
+        Payload payload, packed;        // packed خالی اگر فشرده‌سازی کمکی نکند
+        std::uint32_t crc = 0, packedCrc = 0;
+    };
+    using PacketPtr = std::shared_ptr<const Packet>;
+
+    inline PacketPtr makePacket(Payload payload, bool compress) {
+        auto packet = std::make_shared<Packet>();
+        packet->crc = crc32(payload->data(), payload->size());
+        std::string packed = compress ? pack(*payload) : std::string();
+        if (!packed.empty()) {
+            packet->packedCrc = crc32(packed.data(), packed.size());
+            packet->packed = std::make_shared<const std::string>(std::move(packed));
+        }
+        packet->payload = std::move(payload);
+        return packet;
+    }
+
+    // چند تکه پشت سر هم با یک فراخوانی (writev/WSASend)؛ بایت‌های فرستاده شده یا -1
+    struct Slice {
+        const char *data;
+        size_t size;
+    };
+
+    const size_t maxSlices = 64;
+
+    inline long long sendGather(Handle h, const Slice *slices, size_t count) {
+        count = std::min(count, maxSlices);
+#ifdef _WIN32
+        WSABUF buffers[maxSlices];
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i].buf = (CHAR *)slices[i].data;
+            buffers[i].len = (ULONG)slices[i].size;
+        }
+        DWORD sent = 0;
+        if (WSASend(h, buffers, (DWORD)count, &sent, 0, nullptr, nullptr) != 0) return -1;
+        return (long long)sent;
+#else
+        iovec vectors[maxSlices];
+        for (size_t i = 0; i < count; ++i) {
+            vectors[i].iov_base = (void *)slices[i].data;
+            vectors[i].iov_len = slices[i].size;
+        }
+        msghdr msg{};
+        msg.msg_iov = vectors;
+        msg.msg_iovlen = count;
+        return (long long)sendmsg(h, &msg, sendFlags);
+#endif
+    }
+
+    // نوشتن و خواندن کامل روی سوکت blocking
+    inline bool sendAll(Handle h, Slice *slices, size_t count) {
+        while (count > 0) {
+            long long n = sendGather(h, slices, count);
+            if (n <= 0) return false;
+            for (; count > 0 && (size_t)n >= slices->size; --count, ++slices) n -= (long long)slices->size;
+            if (count > 0) {
+                slices->data += n;
+                slices->size -= (size_t)n;
+            }
+        }
+        return true;
+    }
+
+    inline bool recvAll(Handle h, char *data, size_t size) {
+        while (size > 0) {
+            int n = recv(h, data, (int)std::min<size_t>(size, 1 << 30), 0);
+            if (n <= 0) return false;
+            data += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    // آماده بودن سوکت‌ها برای خواندن/نوشتن
+    class Poller {
+    public:
+        struct Event {
+            Handle handle = invalidHandle;
+            bool readable = false, writable = false, closed = false;
+        };
+
+#ifdef _WIN32
+        void add(Handle h, bool write) { fds.push_back({h, (SHORT)(POLLRDNORM | (write ? POLLWRNORM : 0)), 0}); }
+        void modify(Handle h, bool write) {
+            for (auto &f : fds) {
+                if (f.fd == h) f.events = (SHORT)(POLLRDNORM | (write ? POLLWRNORM : 0));
+            }
+        }
+        void remove(Handle h) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].fd == h) {
+                    fds.erase(fds.begin() + i);
+                    return;
+                }
+            }
+        }
+        std::vector<Event> wait(int timeoutMs) {
+            std::vector<Event> events;
+            if (WSAPoll(fds.data(), (ULONG)fds.size(), timeoutMs) <= 0) return events;
+            for (auto &f : fds) {
+                if (!f.revents) continue;
+                Event e;
+                e.handle = f.fd;
+                e.readable = (f.revents & POLLRDNORM) != 0;
+                e.writable = (f.revents & POLLWRNORM) != 0;
+                e.closed = (f.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+                events.push_back(e);
+            }
+            return events;
+        }
+
+    private:
+        std::vector<WSAPOLLFD> fds;
+#else
+        Poller() : epollFd(epoll_create1(0)) {}
+        ~Poller() { close(epollFd); }
+        Poller(const Poller &) = delete;
+        Poller &operator=(const Poller &) = delete;
+
+        void add(Handle h, bool write) { control(EPOLL_CTL_ADD, h, write); }
+        void modify(Handle h, bool write) { control(EPOLL_CTL_MOD, h, write); }
+        void remove(Handle h) { epoll_ctl(epollFd, EPOLL_CTL_DEL, h, nullptr); }
+        std::vector<Event> wait(int timeoutMs) {
+            epoll_event ready[64];
+            int n = epoll_wait(epollFd, ready, 64, timeoutMs);
+            std::vector<Event> events;
+            for (int i = 0; i < n; ++i) {
+                Event e;
+                e.handle = ready[i].data.fd;
+                e.readable = (ready[i].events & EPOLLIN) != 0;
+                e.writable = (ready[i].events & EPOLLOUT) != 0;
+                e.closed = (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+                events.push_back(e);
+            }
+            return events;
+        }
+
+    private:
+        int epollFd;
+
+        void control(int op, Handle h, bool write) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | (write ? (uint32_t)EPOLLOUT : 0u);
+            ev.data.fd = h;
+            epoll_ctl(epollFd, op, h, &ev);
+        }
+#endif
+    };
+
+    using ClientId = std::uint64_t;
+
+    // سرور ماندگار: handler ها روی رشته حلقه رویداد اجرا می‌شوند؛ send و broadcast از هر رشته‌ای امن‌اند
+    // و فقط پیام را در صف می‌گذارند و حلقه را بیدار می‌کنند
+    class Server {
+    public:
+        using Handler = std::function<void(ClientId, Message &)>;
+
+        Server() = default;
+        ~Server() { stop(); }
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        // قبل از start
+        void on(std::uint8_t type, Handler handler) { handlers[type] = std::move(handler); }
+        void setCompression(bool on) { compression = on; }
+        void onConnect(std::function<void(ClientId)> handler) { connectHandler = std::move(handler); }
+        void onDisconnect(std::function<void(ClientId)> handler) { disconnectHandler = std::move(handler); }
+
+        bool start(int port) {
+            if (isRunning) return true;
+            startup();
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener == invalidHandle) return false;
+            int on = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((unsigned short)port);
+            addr.sin_addr.s_addr = INADDR_ANY;
+            if (bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, SOMAXCONN) != 0 ||
+                !setNonBlocking(listener) || !openWake()) {
+                closeAll();
+                return false;
+            }
+            stopping = false;
+            isRunning = true;
+            loopThread = std::thread([this]() { loop(); });
+            return true;
+        }
+
+        void stop() {
+            if (!isRunning) return;
+            stopping = true;
+            wake();
+            loopThread.join();
+            closeAll();
+            isRunning = false;
+        }
+
+        bool running() const { return isRunning; }
+
+        size_t clientCount() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            return clientTotal;
+        }
+
+        // محتوایی که چند بار فرستاده می‌شود (انتشار برای چند کلاینت) یک بار آماده و نگه داشته می‌شود
+        PacketPtr prepare(Payload payload) const { return makePacket(std::move(payload), compression); }
+
+        // شماره ترتیب و انتخاب نسخه فشرده یا خام هنگام رفتن به صف هر اتصال
+        void send(ClientId client, std::uint8_t type, PacketPtr packet) { push(client, type, std::move(packet), (size_t)-1); }
+
+        // مثل send، ولی اگر بیش از limit بایت هنوز به این کلاینت نرسیده باشد چیزی در صف نمی‌گذارد و false می‌دهد؛
+        // فرستنده (مثلا حل‌کننده) هیچ وقت منتظر کلاینت کند نمی‌ماند
+        bool trySend(ClientId client, std::uint8_t type, PacketPtr packet, size_t limit) {
+            return push(client, type, std::move(packet), limit);
+        }
+
+        // بایت‌های پیام‌های تک‌کلاینتی که هنوز کامل به سوکت این کلاینت نرسیده‌اند
+        size_t queued(ClientId client) const {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = backlog.find(client);
+            return it == backlog.end() ? 0 : it->second;
+        }
+
+        // CRC (و نسخه فشرده، اگر کلاینتی آن را پذیرفته باشد) روی رشته فرستنده حساب می‌شود
+        void send(ClientId client, std::uint8_t type, Payload payload) {
+            send(client, type, makePacket(std::move(payload), compression && compressingClients > 0));
+        }
+
+        void send(ClientId client, std::uint8_t type, std::string payload) {
+            send(client, type, std::make_shared<const std::string>(std::move(payload)));
+        }
+
+        // به همه کلاینت‌های متصل؛ محتوا یک بار در حافظه است
+        void broadcast(std::uint8_t type, std::string payload) { send(0, type, std::move(payload)); }
+
+    private:
+        struct Outgoing {
+            std::uint8_t type = 0;
+            PacketPtr packet;
+            const std::string *body = nullptr;      // خام یا فشرده، بسته به اتصال
+            char header[headerSize];
+            size_t sent = 0;        // از سرآیند و محتوا
+            size_t charged = 0;     // سهم این پیام در backlog کلاینت
+        };
+
+        struct Connection {
+            Handle handle = invalidHandle;
+            std::string in;             // بافر دریافت؛ بعد از هر خواندن فقط بخش خوانده شده جابه‌جا می‌شود
+            std::deque<Outgoing> out;
+            std::uint32_t sendSequence = 0, receiveSequence = 0;
+            bool compress = false;      // طرف مقابل در hello فشرده‌سازی را پذیرفته
+        };
+
+        std::map<std::uint8_t, Handler> handlers;
+        std::function<void(ClientId)> connectHandler, disconnectHandler;
+        Handle listener = invalidHandle;
+        Handle wakeSocket = invalidHandle;      // UDP روی loopback که به خودش می‌فرستد
+        sockaddr_in wakeAddr{};
+        std::thread loopThread;
+        std::atomic<bool> stopping{false};
+        bool isRunning = false;
+        bool compression = true;
+        std::atomic<size_t> compressingClients{0};
+
+        mutable std::mutex mtx;
+        std::deque<std::pair<ClientId, Outgoing>> outbox;       // ClientId صفر یعنی همه
+        std::map<ClientId, size_t> backlog;
+        size_t clientTotal = 0;
+
+        // فقط روی رشته حلقه
+        std::map<ClientId, Connection> connections;
+        std::map<Handle, ClientId> byHandle;
+        ClientId nextId = 1;
+
+        bool openWake() {
+            wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+            if (wakeSocket == invalidHandle) return false;
+            wakeAddr.sin_family = AF_INET;
+            wakeAddr.sin_port = 0;
+            wakeAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len = sizeof(wakeAddr);
+            return bind(wakeSocket, (sockaddr *)&wakeAddr, sizeof(wakeAddr)) == 0 &&
+                   getsockname(wakeSocket, (sockaddr *)&wakeAddr, &len) == 0 && setNonBlocking(wakeSocket);
+        }
+
+        bool push(ClientId client, std::uint8_t type, PacketPtr packet, size_t limit) {
+            Outgoing item;
+            item.type = type;
+            item.packet = std::move(packet);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (client) {
+                    size_t &queuedBytes = backlog[client];
+                    if (queuedBytes > limit) return false;
+                    item.charged = headerSize + item.packet->payload->size();
+                    queuedBytes += item.charged;
+                }
+                outbox.push_back({client, std::move(item)});
+            }
+            wake();
+            return true;
+        }
+
+        // قفل mtx باید گرفته شده باشد
+        void release(ClientId client, size_t bytes) {
+            auto it = backlog.find(client);
+            if (it != backlog.end()) it->second -= std::min(it->second, bytes);
+        }
+
+        void wake() {
+            char b = 0;
+            sendto(wakeSocket, &b, 1, 0, (const sockaddr *)&wakeAddr, sizeof(wakeAddr));
+        }
+
+        void closeAll() {
+            for (auto &entry : connections) closeHandle(entry.second.handle);
+            connections.clear();
+            compressingClients = 0;
+            byHandle.clear();
+            if (listener != invalidHandle) closeHandle(listener);
+            if (wakeSocket != invalidHandle) closeHandle(wakeSocket);
+            listener = wakeSocket = invalidHandle;
+            std::lock_guard<std::mutex> lock(mtx);
+            outbox.clear();
+            backlog.clear();
+            clientTotal = 0;
+        }
+
+        void loop() {
+            Poller poller;
+            poller.add(listener, false);
+            poller.add(wakeSocket, false);
+            while (!stopping) {
+                for (const Poller::Event &e : poller.wait(1000)) {
+                    if (e.handle == listener) accept(poller);
+                    else if (e.handle == wakeSocket) {
+                        char drain[64];
+                        while (recv(wakeSocket, drain, sizeof(drain), 0) > 0) {}
+                    }
+                    else {
+                        auto it = byHandle.find(e.handle);
+                        if (it == byHandle.end()) continue;
+                        ClientId id = it->second;
+                        bool alive = !e.closed || e.readable;
+                        if (alive && e.readable) alive = read(id);
+                        if (alive && e.writable) alive = flush(poller, id);
+                        if (!alive) drop(poller, id);
+                    }
+                }
+                deliver(poller);
+            }
+        }
+
+        void accept(Poller &poller) {
+            while (true) {
+                Handle h = ::accept(listener, nullptr, nullptr);
+                if (h == invalidHandle) return;
+                setNonBlocking(h);
+                setNoDelay(h);
+                ClientId id = nextId++;
+                connections[id].handle = h;
+                byHandle[h] = id;
+                poller.add(h, false);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    ++clientTotal;
+                }
+                if (connectHandler) connectHandler(id);
+            }
+        }
+
+        bool read(ClientId id) {
+            Connection &c = connections[id];
+            char buffer[64 * 1024];
+            while (true) {
+                int n = recv(c.handle, buffer, sizeof(buffer), 0);
+                if (n > 0) c.in.append(buffer, (size_t)n);
+                else if (n < 0 && wouldBlock()) break;
+                else return false;
+            }
+            size_t offset = 0;
+            Message m;
+            bool valid = true;
+            while (valid && c.in.size() - offset >= headerSize) {
+                Header h;
+                if (!h.read(c.in.data() + offset) || h.sequence != c.receiveSequence + 1) {
+                    valid = false;
+                    break;
+                }
+                if (c.in.size() - offset - headerSize < h.length) break;
+                const char *body = c.in.data() + offset + headerSize;
+                if (crc32(body, h.length) != h.crc) {
+                    valid = false;
+                    break;
+                }
+                ++c.receiveSequence;
+                m.type = h.type;
+                offset += headerSize + h.length;
+                if (!unpack(h, body, m.payload)) {
+                    valid = false;
+                    break;
+                }
+                if (m.type == helloType) {
+                    hello(id, c, m);
+                    continue;
+                }
+                auto handler = handlers.find(m.type);
+                if (handler != handlers.end()) handler->second(id, m);
+            }
+            c.in.erase(0, offset);
+            return valid;
+        }
+
+        // پاسخ hello با codec های این سرور؛ از پیام بعدی هر دو جهت می‌توانند فشرده باشند
+        void hello(ClientId id, Connection &c, const Message &m) {
+            bool accepted = compression && !m.payload.empty() && (m.payload[0] & lzCodec);
+            if (accepted && !c.compress) ++compressingClients;
+            c.compress = accepted;
+            send(id, helloType, std::string(1, (char)(compression ? lzCodec : 0)));
+        }
+
+        // تا جایی که سوکت می‌پذیرد، چند پیام با یک writev؛ باقی‌مانده با آماده شدن برای نوشتن
+        bool flush(Poller &poller, ClientId id) {
+            Connection &c = connections[id];
+            size_t delivered = 0;
+            while (!c.out.empty()) {
+                Slice slices[maxSlices];
+                size_t count = 0;
+                for (auto it = c.out.begin(); it != c.out.end() && count + 2 <= maxSlices; ++it) {
+                    size_t sent = it->sent;
+                    if (sent < headerSize) slices[count++] = {it->header + sent, headerSize - sent};
+                    size_t bodySent = sent > headerSize ? sent - headerSize : 0;
+                    if (bodySent < it->body->size()) slices[count++] = {it->body->data() + bodySent, it->body->size() - bodySent};
+                }
+                long long n = sendGather(c.handle, slices, count);
+                if (n < 0 && wouldBlock()) break;
+                if (n <= 0) return false;
+                while (n > 0) {
+                    Outgoing &front = c.out.front();
+                    size_t left = headerSize + front.body->size() - front.sent;
+                    if ((size_t)n < left) {
+                        front.sent += (size_t)n;
+                        break;
+                    }
+                    n -= (long long)left;
+                    delivered += front.charged;
+                    c.out.pop_front();
+                }
+            }
+            poller.modify(c.handle, !c.out.empty());
+            if (delivered) {
+                std::lock_guard<std::mutex> lock(mtx);
+                release(id, delivered);
+            }
+            return true;
+        }
+
+        void enqueue(Connection &c, const Outgoing &item) {
+            c.out.push_back(item);
+            Outgoing &queued = c.out.back();
+            const Packet &packet = *queued.packet;
+            bool packed = c.compress && packet.packed;
+            queued.body = packed ? packet.packed.get() : packet.payload.get();
+            Header h;
+            h.length = (std::uint32_t)queued.body->size();
+            h.type = queued.type;
+            h.flags = packed ? compressedFlag : 0;
+            h.sequence = ++c.sendSequence;
+            h.crc = packed ? packet.packedCrc : packet.crc;
+            h.write(queued.header);
+        }
+
+        void deliver(Poller &poller) {
+            std::deque<std::pair<ClientId, Outgoing>> pending;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                pending.swap(outbox);
+            }
+            if (pending.empty()) return;
+            std::vector<ClientId> touched;
+            for (auto &item : pending) {
+                if (item.first == 0) {
+                    for (auto &entry : connections) {
+                        enqueue(entry.second, item.second);
+                        touched.push_back(entry.first);
+                    }
+                }
+                else if (connections.count(item.first)) {
+                    enqueue(connections[item.first], item.second);
+                    touched.push_back(item.first);
+                }
+                else {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    backlog.erase(item.first);
+                }
+            }
+            for (ClientId id : touched) {
+                if (connections.count(id) && !flush(poller, id)) drop(poller, id);
+            }
+        }
+
+        void drop(Poller &poller, ClientId id) {
+            auto it = connections.find(id);
+            if (it == connections.end()) return;
+            if (it->second.compress) --compressingClients;
+            poller.remove(it->second.handle);
+            closeHandle(it->second.handle);
+            byHandle.erase(it->second.handle);
+            connections.erase(it);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                --clientTotal;
+                backlog.erase(id);
+            }
+            if (disconnectHandler) disconnectHandler(id);
+        }
+    };
+
+    // اتصال ماندگار کلاینت با ارسال و دریافت blocking کامل
+    class Client {
+    public:
+        Client() = default;
+        ~Client() { close(); }
+        Client(const Client &) = delete;
+        Client &operator=(const Client &) = delete;
+
+        // قبل از connect؛ خاموش یعنی در hello هیچ codec ای پیشنهاد نمی‌شود
+        void setCompression(bool on) { compression = on; }
+
+        // قبل از connect؛ receive بدون داده بیشتر از timeout اتصال را می‌بندد و false برمی‌گرداند
+        void setReceiveTimeout(std::chrono::milliseconds timeout) { receiveTimeout = timeout; }
+        bool compressing() const { return peerCompress; }
+
+        // بعد از اتصال TCP، hello فرستاده و پاسخ آن خوانده می‌شود
+        bool connect(const std::string &host, int port) {
+            close();
+            startup();
+            sendSequence = receiveSequence = 0;
+            peerCompress = false;
+            // نام میزبان (localhost، نام شبکه) هم مثل آدرس عددی؛ نشانی‌ها به ترتیب resolver امتحان می‌شوند
+            addrinfo hints{}, *found = nullptr;
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_protocol = IPPROTO_TCP;
+            if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0) return false;
+            for (addrinfo *a = found; a && handle == invalidHandle; a = a->ai_next) {
+                handle = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (handle != invalidHandle && ::connect(handle, a->ai_addr, (int)a->ai_addrlen) != 0) close();
+            }
+            freeaddrinfo(found);
+            if (handle == invalidHandle) return false;
+            setNoDelay(handle);
+            if (receiveTimeout.count() > 0) Net::setReceiveTimeout(handle, receiveTimeout);
+            Message reply;
+            if (!send(helloType, std::string(1, (char)(compression ? lzCodec : 0))) || !receive(reply) || reply.type != helloType) {
+                close();
+                return false;
+            }
+            peerCompress = compression && !reply.payload.empty() && (reply.payload[0] & lzCodec);
+            return true;
+        }
+
+        // بعد از خطای send/receive سوکت باز می‌ماند ولی دیگر وصل حساب نمی‌شود تا صاحب آن close کند
+        bool connected() const { return handle != invalidHandle && !broken; }
+
+        // فقط رشته صاحب Client؛ رشته‌های دیگر فقط shutdown می‌کنند تا شماره سوکت زیر پای آن‌ها دوباره استفاده نشود
+        void close() {
+            Handle h = handle.exchange(invalidHandle);
+            if (h != invalidHandle) closeHandle(h);
+            broken = false;
+        }
+
+        // receive در حال انتظار روی رشته دیگر را برمی‌گرداند؛ بستن خود سوکت با همان رشته است
+        void shutdown() {
+            Handle h = handle;
+#ifdef _WIN32
+            if (h != invalidHandle) ::shutdown(h, SD_BOTH);
+#else
+            if (h != invalidHandle) ::shutdown(h, SHUT_RDWR);
+#endif
+        }
+
+        // سرآیند و محتوا با یک writev بدون کپی در بافر جدا (اگر فشرده نشود)
+        bool send(std::uint8_t type, const std::string &payload) {
+            if (!connected()) return false;
+            std::string packed = peerCompress ? pack(payload) : std::string();
+            const std::string &body = packed.empty() ? payload : packed;
+            Header h;
+            h.length = (std::uint32_t)body.size();
+            h.type = type;
+            h.flags = packed.empty() ? 0 : compressedFlag;
+            h.sequence = ++sendSequence;
+            h.crc = crc32(body.data(), body.size());
+            char head[headerSize];
+            h.write(head);
+            Slice slices[2] = {{head, headerSize}, {body.data(), body.size()}};
+            if (sendAll(handle, slices, body.empty() ? 1 : 2)) return true;
+            broken = true;
+            return false;
+        }
+
+        // m.payload دوباره استفاده می‌شود؛ با همان Message ظرفیت بافر از پیام قبلی می‌ماند
+        // محتوای فشرده در بافر wire خوانده و از آنجا در m.payload باز می‌شود
+        // بافر همراه داده رسیده بزرگ می‌شود، نه یک‌باره به اندازه طول سرآیند (تا ۲۵۶ مگابایت برای سرآیند دروغ)
+        bool receive(Message &m) {
+            char head[headerSize];
+            Header h;
+            if (connected() && recvAll(handle, head, headerSize) && h.read(head) && h.sequence == receiveSequence + 1) {
+                m.type = h.type;
+                std::string &body = (h.flags & compressedFlag) ? wire : m.payload;
+                body.clear();
+                bool ok = true;
+                while (ok && body.size() < h.length) {
+                    size_t got = body.size();
+                    size_t step = std::min<size_t>(h.length - got, std::max<size_t>(got, receiveStep));
+                    body.resize(got + step);
+                    ok = recvAll(handle, &body[got], step);
+                }
+                if (ok && crc32(body.data(), h.length) == h.crc && (&body == &m.payload || unpack(h, body.data(), m.payload))) {
+                    ++receiveSequence;
+                    return true;
+                }
+                if (ok) std::cerr << "Net: corrupt message from server\n";
+            }
+            broken = true;
+            return false;
+        }
+
+    private:
+        static const size_t receiveStep = 64 * 1024;
+        std::atomic<Handle> handle{invalidHandle};
+        std::atomic<bool> broken{false};
+        std::uint32_t sendSequence = 0, receiveSequence = 0;
+        bool compression = true, peerCompress = false;
+        std::chrono::milliseconds receiveTimeout{0};
+        std::string wire;
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+// زمان‌سنج‌ها و شمارنده‌های هر اجرای تحلیل
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+namespace Profiling {
+    using Clock = std::chrono::steady_clock;
+
+    struct RunReport {
+        std::string analysis;
+        double totalMs = 0;
+        std::map<std::string, double> phaseMs;
+        std::map<std::string, long long> counters;
+
+        // خلاصه کوتاه برای messageBox
+        std::string summary() const {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(2);
+            ss << analysis << ": " << totalMs << " ms\n";
+            for (const auto &p : phaseMs) {
+                ss << p.first << " " << p.second << " ms";
+                ss << (totalMs > 0 ? " (" + std::to_string((int)(100 * p.second / totalMs)) + "%)" : "") << "\n";
+            }
+            bool first = true;
+            for (const auto &c : counters) {
+                ss << (first ? "" : ", ") << c.first << "=" << c.second;
+                first = false;
+            }
+            return ss.str();
+        }
+
+        bool writeJson(const std::string &path) const {
+            std::ofstream out(path);
+            if (!out.is_open()) return false;
+            out << std::fixed << std::setprecision(4);
+            out << "{\n  \"analysis\": \"" << analysis << "\",\n  \"total_ms\": " << totalMs << ",\n";
+            out << "  \"phases_ms\": {";
+            for (auto it = phaseMs.begin(); it != phaseMs.end(); ++it) {
+                out << (it == phaseMs.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+            }
+            out << "},\n  \"counters\": {";
+            for (auto it = counters.begin(); it != counters.end(); ++it) {
+                out << (it == counters.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+            }
+            out << "}\n}\n";
+            return true;
+        }
+    };
+
+    // addTime و count فقط در بافر رشته خودشان جمع می‌شوند (قفل آن بافر رقیب ندارد) و endRun همه را یک بار ادغام می‌کند،
+    // پس نقاط AC و اجراهای .step موازی سر یک قفل صف نمی‌کشند. زمان یک بخش روی چند رشته بیشینه زمان رشته‌هاست
+    // نه جمعشان، تا جمع بخش‌ها از totalMs بیشتر نشود
+    class Profiler {
+    public:
+        static Profiler &instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        // اجرای تو در تو (مثلا op داخل DCSweep) در همان اجرای بیرونی جمع می‌شود
+        void beginRun(const std::string &analysis) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (depth++ > 0) return;
+            current = RunReport();
+            current.analysis = analysis;
+            start = Clock::now();
+            run.fetch_add(1, std::memory_order_release);
+            running.store(true, std::memory_order_release);
+        }
+
+        bool endRun(RunReport &report) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (depth == 0 || --depth > 0) return false;
+            running.store(false, std::memory_order_release);
+            merge();
+            current.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            last = current;
+            report = last;
+            return true;
+        }
+
+        void addTime(const std::string &phase, double ms) {
+            Local *l = local();
+            if (!l) return;
+            std::lock_guard<std::mutex> lock(l->mtx);
+            refresh(*l);
+            l->phaseMs[phase] += ms;
+        }
+
+        void count(const std::string &name, long long n = 1) {
+            Local *l = local();
+            if (!l) return;
+            std::lock_guard<std::mutex> lock(l->mtx);
+            refresh(*l);
+            l->counters[name] += n;
+        }
+
+        RunReport lastReport() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            return last;
+        }
+
+    private:
+        // بافر یک رشته برای اجرای run؛ mtx فقط بین صاحب رشته و merge است
+        struct Local {
+            std::mutex mtx;
+            unsigned long long run = 0;
+            std::map<std::string, double> phaseMs;
+            std::map<std::string, long long> counters;
+        };
+
+        Profiler() = default;
+        mutable std::mutex mtx;
+        int depth = 0;
+        Clock::time_point start;
+        RunReport current;
+        RunReport last;
+        std::atomic<unsigned long long> run{0};
+        std::atomic<bool> running{false};
+        std::vector<std::shared_ptr<Local>> locals;     // زیر mtx
+
+        // nullptr وقتی اجرایی در جریان نیست
+        Local *local() {
+            if (!running.load(std::memory_order_acquire)) return nullptr;
+            thread_local std::shared_ptr<Local> mine;
+            if (!mine) {
+                mine = std::make_shared<Local>();
+                std::lock_guard<std::mutex> lock(mtx);
+                locals.push_back(mine);
+            }
+            return mine.get();
+        }
+
+        // زیر قفل l؛ داده اجرای قبلی (ثبت شده بعد از endRun) کنار می‌رود
+        void refresh(Local &l) {
+            unsigned long long now = run.load(std::memory_order_acquire);
+            if (l.run == now) return;
+            l.run = now;
+            l.phaseMs.clear();
+            l.counters.clear();
+        }
+
+        // زیر mtx؛ بافر رشته‌هایی که تمام شده‌اند بعد از ادغام کنار می‌روند
+        void merge() {
+            unsigned long long now = run.load(std::memory_order_acquire);
+            for (auto it = locals.begin(); it != locals.end();) {
+                {
+                    std::lock_guard<std::mutex> lock((*it)->mtx);
+                    Local &l = **it;
+                    if (l.run == now) {
+                        for (const auto &p : l.phaseMs) current.phaseMs[p.first] = std::max(current.phaseMs[p.first], p.second);
+                        for (const auto &c : l.counters) current.counters[c.first] += c.second;
+                    }
+                    l.phaseMs.clear();
+                    l.counters.clear();
+                }
+                it = it->use_count() == 1 ? locals.erase(it) : it + 1;
+            }
+        }
+    };
+
+    // زمان یک بخش (مثلا ساخت ماتریس) را به اجرای جاری اضافه می‌کند
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char *phase) : phase(phase), start(Clock::now()) {}
+        ~ScopedTimer() { stop(); }
+
+        // پایان زودتر از انتهای scope
+        void stop() {
+            if (stopped) return;
+            stopped = true;
+            Clock::time_point end = Clock::now();
+            Profiler::instance().addTime(phase, std::chrono::duration<double, std::milli>(end - start).count());
+            Tracing::Tracer::instance().record(phase, "analysis", start, end);
+        }
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        const char *phase;
+        Clock::time_point start;
+        bool stopped = false;
+    };
+
+    // یک اجرای کامل تحلیل؛ در پایان گزارش در reportPath نوشته می‌شود
+    class ScopedRun {
+    public:
+        explicit ScopedRun(const std::string &analysis, std::string reportPath = "data/profile.json")
+                : analysis(analysis), reportPath(std::move(reportPath)), start(Clock::now()) {
+            Profiler::instance().beginRun(analysis);
+        }
+        ~ScopedRun() {
+            Tracing::Tracer::instance().record(analysis, "analysis", start, Clock::now());
+            RunReport report;
+            if (Profiler::instance().endRun(report)) {
+                report.writeJson(reportPath);
+            }
+        }
+        ScopedRun(const ScopedRun &) = delete;
+        ScopedRun &operator=(const ScopedRun &) = delete;
+
+    private:
+        std::string analysis;
+        std::string reportPath;
+        Clock::time_point start;
+    };
+}
@@ -0,0 +1,268 @@
+#pragma once
+// فایل پروژه تکه‌ای: سرآیند "CNPJ" + نسخه و بعد تکه‌ها (tag چهار حرفی، طول، hash و محتوا)
+// هر تکه مستقل نوشته می‌شود؛ ذخیره دوباره فقط تکه‌های تغییر کرده را به انتهای فایل اضافه می‌کند
+// و آخرین تکه با هر tag معتبر است. تکه ناقص انتهای فایل (قطع برق وسط ذخیره) نادیده گرفته می‌شود
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Project {
+    const char magic[4] = {'C', 'N', 'P', 'J'};
+    const std::uint32_t version = 2;        // ۲: قالب فشرده مدار؛ فایل نسخه ۱ خوانده و با ذخیره بعدی کامل بازنویسی می‌شود
+    const size_t headerSize = 8;
+    const size_t chunkHeaderSize = 16;      // tag + طول (u32) + hash (u64)
+    const std::uint64_t maxChunk = std::numeric_limits<std::uint32_t>::max();
+    const std::uint64_t hashBasis = 1469598103934665603ull;
+
+    // FNV-1a؛ برای تشخیص تغییر تکه هنگام ذخیره و خرابی آن هنگام خواندن. h قبلی ادامه hash تکه‌ای است
+    inline std::uint64_t hash(const char *data, size_t size, std::uint64_t h = hashBasis) {
+        for (size_t i = 0; i < size; ++i) {
+            h ^= (unsigned char)data[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+    inline std::uint64_t hash(const std::string &data) { return hash(data.data(), data.size()); }
+
+    // داده فایل تا خود دیسک، نه فقط cache سیستم‌عامل؛ برای ماندن بعد از قطع برق
+    inline bool syncFile(const std::string &path) {
+#ifdef _WIN32
+        HANDLE h = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        bool ok = FlushFileBuffers(h) != 0;
+        CloseHandle(h);
+        return ok;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    // جایگزینی اتمی: در هیچ لحظه‌ای مقصد حذف نشده؛ یا فایل قبلی است یا فایل جدید
+    inline bool replaceFile(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    struct Chunk {
+        std::uint64_t offset = 0;   // شروع محتوا در فایل
+        std::uint32_t length = 0;
+        std::uint64_t hash = 0;
+    };
+
+    class Container {
+    public:
+        // فهرست تکه‌ها را می‌خواند بدون خواندن محتوا؛ false یعنی فایل پروژه تکه‌ای نیست (فایل قدیمی یک‌تکه)
+        bool open(const std::string &filePath) {
+            path = filePath;
+            chunks.clear();
+            fileBytes = liveBytes = 0;
+            fileVersion = 0;
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (!in.is_open()) return false;
+            std::uint64_t size = (std::uint64_t)in.tellg();
+            in.seekg(0);
+            char head[headerSize];
+            if (!in.read(head, headerSize) || std::string(head, 4) != std::string(magic, 4)) return false;
+            fileVersion = readU32(head + 4);
+            if (fileVersion < 1 || fileVersion > version) return false;
+
+            std::uint64_t offset = headerSize;
+            char raw[chunkHeaderSize];
+            while (in.read(raw, chunkHeaderSize)) {
+                Chunk c;
+                c.length = readU32(raw + 4);
+                c.hash = readU64(raw + 8);
+                c.offset = offset + chunkHeaderSize;
+                if (c.offset + c.length > size) break;
+                chunks[std::string(raw, 4)] = c;
+                offset = c.offset + c.length;
+                in.seekg((std::streamoff)offset);
+            }
+            fileBytes = offset;
+            for (const auto &entry : chunks) liveBytes += chunkHeaderSize + entry.second.length;
+            return true;
+        }
+
+        std::uint32_t formatVersion() const { return fileVersion; }
+
+        bool has(const std::string &tag) const { return chunks.count(tag) > 0; }
+        const Chunk *find(const std::string &tag) const {
+            auto it = chunks.find(tag);
+            return it == chunks.end() ? nullptr : &it->second;
+        }
+
+        // false اگر تکه نباشد، خوانده نشود یا hash آن با محتوا نخواند (فایل خراب)
+        bool read(const std::string &tag, std::string &data) const {
+            data.clear();
+            const Chunk *c = find(tag);
+            if (!c) return false;
+            std::ifstream in(path, std::ios::binary);
+            data.resize(c->length);
+            in.seekg((std::streamoff)c->offset);
+            in.read(&data[0], c->length);
+            if (in && hash(data) == c->hash) return true;
+            data.clear();
+            return false;
+        }
+
+        // تکه نبوده یا خراب خالی برمی‌گردد
+        std::string read(const std::string &tag) const {
+            std::string data;
+            read(tag, data);
+            return data;
+        }
+
+        // محتوای یک تکه را بدون نگه داشتن کل آن در حافظه در فایل دیگری می‌ریزد؛ تکه خراب فایل خالی می‌گذارد
+        bool extract(const std::string &tag, const std::string &outPath) const {
+            const Chunk *c = find(tag);
+            std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+            if (!c || !out.is_open()) return false;
+            std::ifstream in(path, std::ios::binary);
+            in.seekg((std::streamoff)c->offset);
+            std::vector<char> buffer(1 << 16);
+            std::uint64_t h = hashBasis;
+            for (std::uint32_t left = c->length; left > 0 && in;) {
+                std::uint32_t n = std::min<std::uint32_t>(left, (std::uint32_t)buffer.size());
+                in.read(buffer.data(), n);
+                out.write(buffer.data(), in.gcount());
+                h = hash(buffer.data(), (size_t)in.gcount(), h);
+                left -= (std::uint32_t)in.gcount();
+            }
+            if (in && out && h == c->hash) return true;
+            out.close();
+            std::ofstream(outPath, std::ios::binary | std::ios::trunc);
+            return false;
+        }
+
+        // فضای تکه‌های کهنه‌ای که تکه جدیدتر جایشان را گرفته
+        std::uint64_t deadBytes() const { return fileBytes - headerSize - liveBytes; }
+
+        // تکه‌های داده شده را ذخیره می‌کند؛ تکه‌ای که hash آن تغییر نکرده نوشته نمی‌شود و tag هایی که
+        // داده نشده‌اند همان محتوای قبلی را نگه می‌دارند. اگر فضای کهنه از فضای زنده بیشتر شود فایل فشرده بازنویسی می‌شود
+        // خروجی: تعداد بایت نوشته شده، یا -1 اگر فایل باز نشد یا تکه‌ای از ۴ گیگابایت بزرگ‌تر بود (طول تکه u32 است)
+        static long long save(const std::string &filePath, const std::vector<std::pair<std::string, std::string>> &updates) {
+            for (const auto &u : updates) {
+                if (u.second.size() > maxChunk) return -1;
+            }
+            Container old;
+            bool existing = old.open(filePath);
+            bool append = existing && old.fileVersion == version;
+            std::vector<const std::pair<std::string, std::string> *> changed;
+            std::uint64_t live = 0, replaced = 0;
+            for (const auto &u : updates) {
+                const Chunk *c = append ? old.find(u.first) : nullptr;
+                if (c && c->length == u.second.size() && c->hash == hash(u.second)) continue;
+                changed.push_back(&u);
+                live += chunkHeaderSize + u.second.size();
+                if (c) replaced += chunkHeaderSize + c->length;
+            }
+            if (append && changed.empty()) return 0;
+
+            if (append) {
+                std::uint64_t newLive = old.liveBytes - replaced + live;
+                std::uint64_t newDead = old.deadBytes() + replaced;
+                if (newDead <= newLive) {
+                    // تکه ناقص ذخیره قبلی حذف می‌شود تا بعد از تکه‌های جدید به عنوان تکه خوانده نشود
+                    std::error_code ec;
+                    std::filesystem::resize_file(filePath, old.fileBytes, ec);
+                    if (ec) return -1;
+                    std::ofstream out(filePath, std::ios::binary | std::ios::in | std::ios::out);
+                    if (!out.is_open()) return -1;
+                    out.seekp((std::streamoff)old.fileBytes);
+                    long long written = 0;
+                    for (auto *u : changed) written += writeChunk(out, u->first, u->second);
+                    if (!out) return -1;
+                    out.close();
+                    return syncFile(filePath) ? written : -1;
+                }
+            }
+
+            // بازنویسی کامل: تکه‌های بدون تغییر از فایل قبلی کپی می‌شوند؛ تکه خراب قبلی (محتوایش از دست رفته) کنار گذاشته می‌شود
+            std::vector<std::pair<std::string, std::string>> all;
+            if (existing) {
+                for (const auto &entry : old.chunks) {
+                    bool updated = false;
+                    for (const auto &u : updates) updated = updated || u.first == entry.first;
+                    if (updated) continue;
+                    all.push_back({entry.first, ""});
+                    if (!old.read(entry.first, all.back().second)) all.pop_back();
+                }
+            }
+            std::string tmpPath = filePath + ".tmp";
+            long long written = (long long)headerSize;
+            {
+                std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+                if (!out.is_open()) return -1;
+                char head[headerSize];
+                std::copy(magic, magic + 4, head);
+                writeU32(head + 4, version);
+                out.write(head, headerSize);
+                for (const auto &c : all) written += writeChunk(out, c.first, c.second);
+                for (const auto &u : updates) written += writeChunk(out, u.first, u.second);
+                if (!out) return -1;
+            }
+            // فایل موقت قبل از جایگزینی روی دیسک است تا بعد از قطع برق جای فایل قبلی فایل خالی نماند
+            if (!syncFile(tmpPath) || !replaceFile(tmpPath, filePath)) {
+                std::remove(tmpPath.c_str());
+                return -1;
+            }
+            return written;
+        }
+
+    private:
+        std::string path;
+        std::map<std::string, Chunk> chunks;
+        std::uint64_t fileBytes = 0, liveBytes = 0;
+        std::uint32_t fileVersion = 0;
+
+        static long long writeChunk(std::ostream &out, const std::string &tag, const std::string &data) {
+            char raw[chunkHeaderSize];
+            for (size_t i = 0; i < 4; ++i) raw[i] = i < tag.size() ? tag[i] : ' ';
+            writeU32(raw + 4, (std::uint32_t)data.size());
+            writeU64(raw + 8, hash(data));
+            out.write(raw, chunkHeaderSize);
+            out.write(data.data(), (std::streamsize)data.size());
+            return (long long)(chunkHeaderSize + data.size());
+        }
+
+        // اعداد little-endian تا فایل بین سیستم‌ها جابه‌جا شود
+        static std::uint32_t readU32(const char *p) {
+            std::uint32_t v = 0;
+            for (int i = 3; i >= 0; --i) v = (v << 8) | (unsigned char)p[i];
+            return v;
+        }
+        static std::uint64_t readU64(const char *p) {
+            std::uint64_t v = 0;
+            for (int i = 7; i >= 0; --i) v = (v << 8) | (unsigned char)p[i];
+            return v;
+        }
+        static void writeU32(char *p, std::uint32_t v) {
+            for (int i = 0; i < 4; ++i, v >>= 8) p[i] = (char)(v & 0xff);
+        }
+        static void writeU64(char *p, std::uint64_t v) {
+            for (int i = 0; i < 8; ++i, v >>= 8) p[i] = (char)(v & 0xff);
+        }
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+// بلوک نمونه‌های تحلیل گذرا برای انتشار در حین اجرا: پشت سر هم برای هر سیگنال
+// نام (u32 طول + متن)، تعداد نمونه (u32) و زوج‌های (زمان، مقدار) به صورت f64 (little-endian)؛
+// نمونه‌های هر سیگنال به ترتیب زمان‌اند و بلوک بعدی از همان جایی ادامه می‌دهد
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Samples {
+    struct Series {
+        std::string signal;     // مثل V(N01) یا I(R1)
+        std::vector<std::pair<double, double>> points;
+    };
+
+    inline void append(std::string &block, const std::string &signal, const std::pair<double, double> *points, size_t count) {
+        auto u32 = [&](std::uint32_t v) {
+            for (int i = 0; i < 4; ++i, v >>= 8) block.push_back((char)(v & 0xff));
+        };
+        auto f64 = [&](double d) {
+            std::uint64_t v;
+            std::memcpy(&v, &d, 8);
+            for (int i = 0; i < 8; ++i, v >>= 8) block.push_back((char)(v & 0xff));
+        };
+        block.reserve(block.size() + 8 + signal.size() + count * 16);
+        u32((std::uint32_t)signal.size());
+        block += signal;
+        u32((std::uint32_t)count);
+        for (size_t i = 0; i < count; ++i) {
+            f64(points[i].first);
+            f64(points[i].second);
+        }
+    }
+
+    // خطای std::runtime_error اگر داده ناقص باشد
+    inline std::vector<Series> decode(const std::string &block) {
+        size_t pos = 0;
+        auto need = [&](size_t n) {
+            if (block.size() - pos < n) throw std::runtime_error("samples: truncated block");
+        };
+        auto u32 = [&]() {
+            need(4);
+            std::uint32_t v = 0;
+            for (int i = 3; i >= 0; --i) v = (v << 8) | (unsigned char)block[pos + i];
+            pos += 4;
+            return v;
+        };
+        auto f64 = [&]() {
+            std::uint64_t v = 0;
+            for (int i = 7; i >= 0; --i) v = (v << 8) | (unsigned char)block[pos + i];
+            pos += 8;
+            double d;
+            std::memcpy(&d, &v, 8);
+            return d;
+        };
+        std::vector<Series> series;
+        while (pos < block.size()) {
+            Series s;
+            std::uint32_t length = u32();
+            need(length);
+            s.signal = block.substr(pos, length);
+            pos += length;
+            std::uint32_t count = u32();
+            need((size_t)count * 16);
+            s.points.resize(count);
+            for (auto &point : s.points) {
+                point.first = f64();
+                point.second = f64();
+            }
+            series.push_back(std::move(s));
+        }
+        return series;
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+// منبع جریانی برای هم‌شبیه‌سازی با برنامه بیرونی: نمونه‌های (زمان، مقدار) به صورت خط متنی «t v» (مثل فایل PWL)
+// از سوکت TCP («tcp:host:port») یا فایل/pipe محلی می‌رسند. رشته خواننده آن‌ها را در بافر jitter می‌گذارد
+// و تحلیل گذرا در هر گام تا رسیدن نمونه‌ای بعد از t صبر می‌کند (حداکثر stallLimit) و بین دو نمونه درون‌یابی می‌کند
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "net.h"
+
+namespace Streaming {
+    // زمان‌ها باید صعودی باشند؛ نمونه عقب‌تر از آخرین نمونه کنار گذاشته می‌شود
+    class JitterBuffer {
+    public:
+        explicit JitterBuffer(size_t capacity = 1 << 16) : capacity(capacity) {}
+
+        // روی رشته خواننده؛ وقتی بافر پر است تا مصرف شدن نمونه‌ها (یا close) صبر می‌کند. false یعنی بسته شده
+        bool push(double t, double v) {
+            std::unique_lock<std::mutex> lock(mtx);
+            room.wait(lock, [&]() { return closed || samples.size() < capacity; });
+            if (closed) return false;
+            if (!samples.empty() && t <= samples.back().first) return true;
+            samples.emplace_back(t, v);
+            starved = false;
+            ready.notify_all();
+            return true;
+        }
+
+        // پایان داده؛ error غیرخالی یعنی منبع باز نشد یا خراب شد
+        void finish(const std::string &error = "") {
+            std::lock_guard<std::mutex> lock(mtx);
+            ended = true;
+            failure = error;
+            ready.notify_all();
+        }
+
+        // خواننده دیگر صبر نمی‌کند (منبع عوض یا متوقف شده)
+        void close() {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+            room.notify_all();
+        }
+
+        // مقدار در زمان t با درون‌یابی خطی؛ بعد از پایان داده آخرین مقدار می‌ماند. اگر تا stall نمونه‌ای بعد از t
+        // نرسد آخرین مقدار برمی‌گردد و underrun شمرده می‌شود، و تا نمونه تازه‌ای نرسد گام‌های بعدی دیگر صبر نمی‌کنند.
+        // خطای runtime_error اگر منبع شکست خورده باشد
+        double valueAt(double t, std::chrono::milliseconds stall, bool &underrun) {
+            std::unique_lock<std::mutex> lock(mtx);
+            auto deadline = std::chrono::steady_clock::now() + (starved ? std::chrono::milliseconds(0) : stall);
+            underrun = false;
+            while (true) {
+                // نمونه‌های قبل از t (جز آخرینشان) دیگر لازم نیستند؛ جا برای خواننده باز می‌شود
+                size_t dropped = 0;
+                while (samples.size() >= 2 && samples[1].first <= t) {
+                    samples.pop_front();
+                    ++dropped;
+                }
+                if (dropped) room.notify_all();
+                if (!failure.empty()) throw std::runtime_error(failure);
+                if (ended || (!samples.empty() && samples.back().first >= t)) break;
+                if (ready.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    underrun = starved = true;
+                    break;
+                }
+            }
+            if (samples.empty()) return 0.0;
+            const auto &a = samples.front();
+            if (t <= a.first || samples.size() == 1) return a.second;
+            const auto &b = samples[1];
+            return a.second + (b.second - a.second) * (t - a.first) / (b.first - a.first);
+        }
+
+    private:
+        std::mutex mtx;
+        std::condition_variable ready, room;
+        std::deque<std::pair<double, double>> samples;
+        size_t capacity;
+        bool ended = false, closed = false, starved = false;
+        std::string failure;
+    };
+
+    // یک اتصال یا فایل برای یک اجرای تحلیل؛ رشته خواننده جدا (detach) است تا pipe یا سوکت بی‌داده
+    // توقف را معطل نکند، و فقط بافر و سوکت مشترک خودش را می‌شناسد
+    class Feed {
+    public:
+        explicit Feed(const std::string &spec) : state(std::make_shared<State>()) {
+            std::shared_ptr<State> s = state;
+            std::thread([s, spec]() { read(*s, spec); }).detach();
+        }
+
+        ~Feed() {
+            state->buffer.close();
+            std::lock_guard<std::mutex> lock(state->mtx);
+            state->stopped = true;
+            if (state->socket == Net::invalidHandle) return;
+#ifdef _WIN32
+            ::shutdown(state->socket, SD_BOTH);
+#else
+            ::shutdown(state->socket, SHUT_RDWR);
+#endif
+        }
+
+        Feed(const Feed &) = delete;
+        Feed &operator=(const Feed &) = delete;
+
+        double valueAt(double t, std::chrono::milliseconds stall, bool &underrun) { return state->buffer.valueAt(t, stall, underrun); }
+
+    private:
+        struct State {
+            JitterBuffer buffer;
+            std::mutex mtx;
+            Net::Handle socket = Net::invalidHandle;
+            bool stopped = false;
+        };
+        std::shared_ptr<State> state;
+
+        // هر خط «t v»؛ خط خالی، توضیح (*) یا نادرست نادیده گرفته می‌شود
+        template <class Push>
+        static bool parseLines(std::string &pending, Push push) {
+            size_t start = 0, eol;
+            while ((eol = pending.find('\n', start)) != std::string::npos) {
+                pending[eol] = '\0';
+                const char *line = pending.c_str() + start;
+                char *end;
+                double t = std::strtod(line, &end);
+                if (end != line) {
+                    const char *rest = end;
+                    double v = std::strtod(rest, &end);
+                    if (end != rest && !push(t, v)) return false;
+                }
+                start = eol + 1;
+            }
+            pending.erase(0, start);
+            return true;
+        }
+
+        static void read(State &s, const std::string &spec) {
+            std::string pending;
+            auto push = [&s](double t, double v) { return s.buffer.push(t, v); };
+            if (spec.compare(0, 4, "tcp:") != 0) {
+                std::ifstream in(spec, std::ios::binary);
+                if (!in.is_open()) return s.buffer.finish("stream: cannot open " + spec);
+                char chunk[64 * 1024];
+                while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+                    pending.append(chunk, (size_t)in.gcount());
+                    if (!parseLines(pending, push)) return;
+                }
+                pending.push_back('\n');
+                parseLines(pending, push);
+                return s.buffer.finish();
+            }
+
+            size_t colon = spec.rfind(':');
+            std::string host = spec.substr(4, colon > 4 ? colon - 4 : 0);
+            int port = colon > 4 ? std::atoi(spec.c_str() + colon + 1) : 0;
+            Net::startup();
+            Net::Handle h = socket(AF_INET, SOCK_STREAM, 0);
+            {
+                std::lock_guard<std::mutex> lock(s.mtx);
+                if (s.stopped || h == Net::invalidHandle) {
+                    if (h != Net::invalidHandle) Net::closeHandle(h);
+                    return s.buffer.finish("stream: cannot open " + spec);
+                }
+                s.socket = h;
+            }
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((unsigned short)port);
+            addr.sin_addr.s_addr = inet_addr(host.c_str());
+            bool connected = port > 0 && ::connect(h, (sockaddr *)&addr, sizeof(addr)) == 0;
+            if (connected) {
+                char chunk[64 * 1024];
+                int n;
+                while ((n = recv(h, chunk, sizeof(chunk), 0)) > 0) {
+                    pending.append(chunk, (size_t)n);
+                    if (!parseLines(pending, push)) break;
+                }
+                pending.push_back('\n');
+                parseLines(pending, push);
+            }
+            {
+                std::lock_guard<std::mutex> lock(s.mtx);
+                Net::closeHandle(h);
+                s.socket = Net::invalidHandle;
+            }
+            s.buffer.finish(connected ? "" : "stream: cannot connect to " + spec.substr(4));
+        }
+    };
+}
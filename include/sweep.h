@@ -0,0 +1,352 @@
+#pragma once
+// جاروب پارامتر و مونت‌کارلو: مقدار المان‌ها در هر اجرا (شبکه‌ای یا تصادفی) و آمار نتیجه اجراها
+// خود شبیه‌سازی در main.cpp است؛ این فایل فقط نقطه‌های فضای پارامتر را می‌سازد و نتیجه‌ها را جمع می‌کند
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "measure.h"
+#include "units.h"
+
+namespace Sweeps {
+    enum class Kind { List, Linear, Decade, Uniform, Gauss };
+
+    struct Parameter {
+        std::string element;
+        Kind kind = Kind::List;
+        std::vector<double> values;     // نقاط List، Linear و Decade
+        double tolerance = 0.0;         // Uniform و Gauss
+        bool relative = true;           // 5% نسبت به مقدار اسمی؛ بدون % مقدار مطلق
+
+        bool random() const { return kind == Kind::Uniform || kind == Kind::Gauss; }
+    };
+
+    // میانگین و انحراف معیار به روش Welford؛ اجراهای ناموفق جدا شمرده می‌شوند
+    struct Statistics {
+        size_t count = 0, failed = 0;
+        double mean = 0.0, m2 = 0.0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+
+        void add(double x) {
+            ++count;
+            double delta = x - mean;
+            mean += delta / count;
+            m2 += delta * (x - mean);
+            if (x < min) min = x;
+            if (x > max) max = x;
+        }
+        double stddev() const { return count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0; }
+    };
+
+    // نتیجه یک اجرا: مقدار پارامترها به ترتیب Plan::elements() و نتیجه .meas ها
+    struct Run {
+        std::vector<double> values;
+        std::vector<Measurements::Result> results;
+        std::string error;      // خطای تحلیل؛ خالی یعنی اجرا کامل شد
+    };
+
+    class Plan {
+    public:
+        //   [.step] R1 list 1k 2.2k 4.7k
+        //   [.step] R1 lin 1k 10k 10       (۱۰ نقطه از 1k تا 10k)
+        //   [.step] C1 dec 1n 1u 5         (۵ نقطه در هر دهه)
+        //   [.step] R1 uniform 5%          (یکنواخت در ±5%)
+        //   [.step] R1 gauss 5%            (نرمال با 3σ برابر 5%)
+        //   [.step] runs 1000  |  [.step] seed 42
+        // اجراها حاصل‌ضرب نقاط شبکه در runs است؛ تغییر تصادفی بعد از مقدار شبکه اعمال می‌شود
+        // خطای نحوی std::runtime_error
+        void add(const std::string &line) {
+            std::vector<std::string> t = tokenize(line);
+            size_t i = 0;
+            if (i < t.size() && lower(t[i]) == ".step") ++i;
+            if (i + 2 > t.size()) throw std::runtime_error("step: expected element and sweep in '" + line + "'");
+            std::string first = lower(t[i]);
+            if (first == "runs" || first == "seed") {
+                double v = number(t[i + 1], line);
+                if (v < (first == "runs" ? 1 : 0) || v != std::floor(v)) throw std::runtime_error("step: invalid " + first + " in '" + line + "'");
+                if (first == "runs") runs = (size_t)v;
+                else seed = (std::uint64_t)v;
+                return;
+            }
+
+            Parameter p;
+            p.element = t[i++];
+            std::string kind = lower(t[i++]);
+            std::vector<double> args;
+            for (; i < t.size(); ++i) {
+                std::string token = t[i];
+                if (!token.empty() && token.back() == '%' && (kind == "uniform" || kind == "gauss")) {
+                    token.pop_back();
+                    p.relative = true;
+                    args.push_back(number(token, line) / 100.0);
+                }
+                else {
+                    p.relative = false;
+                    args.push_back(number(token, line));
+                }
+            }
+
+            if (kind == "list") {
+                if (args.empty()) throw std::runtime_error("step: list needs values in '" + line + "'");
+                p.kind = Kind::List;
+                p.values = args;
+            }
+            else if (kind == "lin") {
+                if (args.size() != 3 || args[2] < 1 || args[2] != std::floor(args[2]))
+                    throw std::runtime_error("step: lin needs start stop points in '" + line + "'");
+                p.kind = Kind::Linear;
+                int points = (int)args[2];
+                for (int k = 0; k < points; ++k) {
+                    p.values.push_back(points == 1 ? args[0] : args[0] + (args[1] - args[0]) * k / (points - 1));
+                }
+            }
+            else if (kind == "dec") {
+                if (args.size() != 3 || args[0] <= 0 || args[1] < args[0] || args[2] < 1)
+                    throw std::runtime_error("step: dec needs start stop points-per-decade in '" + line + "'");
+                p.kind = Kind::Decade;
+                double decades = std::log10(args[1] / args[0]);
+                int points = (int)std::ceil(args[2] * decades - 1e-9) + 1;
+                for (int k = 0; k < points; ++k) {
+                    p.values.push_back(std::min(args[1], args[0] * std::pow(10.0, k / args[2])));
+                }
+            }
+            else if (kind == "uniform" || kind == "gauss") {
+                if (args.size() != 1 || args[0] < 0) throw std::runtime_error("step: " + kind + " needs one tolerance in '" + line + "'");
+                p.kind = kind == "uniform" ? Kind::Uniform : Kind::Gauss;
+                p.tolerance = args[0];
+            }
+            else throw std::runtime_error("step: unknown sweep " + kind + " in '" + line + "'");
+
+            if (elementIndex(p.element) < 0) elementNames.push_back(p.element);
+            parameters.push_back(p);
+        }
+
+        // هر خط یک دستور؛ خطوط خالی و توضیح (*) نادیده گرفته می‌شوند
+        void addLines(const std::string &text) {
+            std::istringstream in(text);
+            std::string line;
+            while (std::getline(in, line)) {
+                size_t first = line.find_first_not_of(" \t\r");
+                if (first == std::string::npos || line[first] == '*') continue;
+                add(line);
+            }
+        }
+
+        bool empty() const { return parameters.empty(); }
+        const std::vector<Parameter> &params() const { return parameters; }
+        // المان‌های جاروب شده، هر کدام یک بار به ترتیب اولین ذکر
+        const std::vector<std::string> &elements() const { return elementNames; }
+
+        size_t gridSize() const {
+            size_t n = 1;
+            for (const Parameter &p : parameters) {
+                if (!p.random()) n *= p.values.size();
+            }
+            return n;
+        }
+        size_t size() const { return gridSize() * runs; }
+
+        // مقدار المان‌ها در اجرای k؛ nominal مقدار فعلی همان المان‌ها به ترتیب elements()
+        // مولد تصادفی هر اجرا فقط به seed و k بستگی دارد، پس نتیجه به ترتیب اجرای رشته‌ها وابسته نیست
+        std::vector<double> point(size_t k, const std::vector<double> &nominal) const {
+            std::vector<double> values = nominal;
+            size_t grid = k / runs;
+            for (size_t p = parameters.size(); p-- > 0;) {
+                const Parameter &param = parameters[p];
+                if (param.random()) continue;
+                values[elementIndex(param.element)] = param.values[grid % param.values.size()];
+                grid /= param.values.size();
+            }
+            std::seed_seq seq{(std::uint32_t)seed, (std::uint32_t)(seed >> 32), (std::uint32_t)k, (std::uint32_t)((std::uint64_t)k >> 32)};
+            std::mt19937_64 rng(seq);
+            for (const Parameter &param : parameters) {
+                if (!param.random()) continue;
+                double &v = values[elementIndex(param.element)];
+                double spread = param.relative ? param.tolerance * std::fabs(v) : param.tolerance;
+                if (param.kind == Kind::Uniform) v += std::uniform_real_distribution<double>(-spread, spread)(rng);
+                else v += std::normal_distribution<double>(0.0, spread / 3.0)(rng);
+            }
+            return values;
+        }
+
+    private:
+        std::vector<Parameter> parameters;
+        std::vector<std::string> elementNames;
+        size_t runs = 1;
+        std::uint64_t seed = 1;
+
+        int elementIndex(const std::string &name) const {
+            for (size_t i = 0; i < elementNames.size(); ++i) {
+                if (elementNames[i] == name) return (int)i;
+            }
+            return -1;
+        }
+
+        static std::string lower(std::string s) {
+            for (char &c : s) c = (char)tolower((unsigned char)c);
+            return s;
+        }
+
+        static std::vector<std::string> tokenize(const std::string &line) {
+            std::vector<std::string> tokens;
+            std::istringstream in(line.substr(0, line.find(';')));
+            std::string token;
+            while (in >> token) tokens.push_back(token);
+            return tokens;
+        }
+
+        static double number(const std::string &s, const std::string &line) {
+            double v = 0.0;
+            if (!Units::parse(s, v, Units::Syntax::Spice)) throw std::runtime_error("step: invalid number " + s + " in '" + line + "'");
+            return v;
+        }
+    };
+
+    // آمار هر .meas روی همه اجراها؛ names از نتیجه اولین اجرای کامل
+    inline std::vector<std::pair<std::string, Statistics>> statistics(const std::vector<Run> &runs) {
+        std::vector<std::pair<std::string, Statistics>> stats;
+        for (const Run &run : runs) {
+            if (run.results.empty()) continue;
+            for (const Measurements::Result &r : run.results) stats.push_back({r.name, Statistics()});
+            break;
+        }
+        for (const Run &run : runs) {
+            for (size_t i = 0; i < stats.size(); ++i) {
+                if (i < run.results.size() && run.results[i].ok) stats[i].second.add(run.results[i].value);
+                else ++stats[i].second.failed;
+            }
+        }
+        return stats;
+    }
+
+    // خلاصه کوتاه برای messageBox
+    inline std::string summary(const std::vector<Run> &runs) {
+        std::ostringstream ss;
+        size_t errors = 0;
+        for (const Run &run : runs) errors += run.error.empty() ? 0 : 1;
+        ss << runs.size() << " runs";
+        if (errors) ss << ", " << errors << " failed";
+        ss << "\n";
+        for (const auto &entry : statistics(runs)) {
+            const Statistics &s = entry.second;
+            ss << entry.first << ": ";
+            if (s.count == 0) ss << "FAILED";
+            else ss << "mean " << s.mean << " sd " << s.stddev() << " min " << s.min << " max " << s.max;
+            if (s.failed) ss << " (" << s.failed << " failed)";
+            ss << "\n";
+        }
+        return ss.str();
+    }
+
+    // اجراها برای فرستادن روی شبکه (جاروب توزیع شده روی کارگرها)؛ اعداد little-endian و double با بیت‌های IEEE
+    inline std::string encode(const std::vector<Run> &runs) {
+        std::string out;
+        auto u32 = [&](std::uint32_t v) {
+            for (int i = 0; i < 4; ++i, v >>= 8) out.push_back((char)(v & 0xff));
+        };
+        auto f64 = [&](double d) {
+            std::uint64_t v;
+            std::memcpy(&v, &d, 8);
+            for (int i = 0; i < 8; ++i, v >>= 8) out.push_back((char)(v & 0xff));
+        };
+        auto text = [&](const std::string &s) {
+            u32((std::uint32_t)s.size());
+            out += s;
+        };
+        u32((std::uint32_t)runs.size());
+        for (const Run &run : runs) {
+            u32((std::uint32_t)run.values.size());
+            for (double v : run.values) f64(v);
+            u32((std::uint32_t)run.results.size());
+            for (const Measurements::Result &r : run.results) {
+                text(r.name);
+                out.push_back(r.ok ? 1 : 0);
+                f64(r.value);
+            }
+            text(run.error);
+        }
+        return out;
+    }
+
+    // خطای std::runtime_error اگر داده ناقص باشد
+    inline std::vector<Run> decode(const std::string &data) {
+        size_t pos = 0;
+        auto need = [&](size_t n) {
+            if (data.size() - pos < n) throw std::runtime_error("sweep: truncated run data");
+        };
+        auto u32 = [&]() {
+            need(4);
+            std::uint32_t v = 0;
+            for (int i = 3; i >= 0; --i) v = (v << 8) | (unsigned char)data[pos + i];
+            pos += 4;
+            return v;
+        };
+        auto f64 = [&]() {
+            need(8);
+            std::uint64_t v = 0;
+            for (int i = 7; i >= 0; --i) v = (v << 8) | (unsigned char)data[pos + i];
+            pos += 8;
+            double d;
+            std::memcpy(&d, &v, 8);
+            return d;
+        };
+        auto text = [&]() {
+            std::uint32_t n = u32();
+            need(n);
+            pos += n;
+            return data.substr(pos - n, n);
+        };
+        // تعداد قبل از رزرو حافظه با حداقل اندازه هر عضو سنجیده می‌شود
+        auto count = [&](size_t minBytes) {
+            std::uint32_t n = u32();
+            need((size_t)n * minBytes);
+            return n;
+        };
+        std::vector<Run> runs(count(12));
+        for (Run &run : runs) {
+            run.values.resize(count(8));
+            for (double &v : run.values) v = f64();
+            run.results.resize(count(13));
+            for (Measurements::Result &r : run.results) {
+                r.name = text();
+                need(1);
+                r.ok = data[pos++] != 0;
+                r.value = f64();
+            }
+            run.error = text();
+        }
+        return runs;
+    }
+
+    // یک سطر برای هر اجرا: run, مقدار المان‌ها, نتیجه .meas ها (خالی برای FAILED), error
+    inline bool writeCsv(const std::string &path, const Plan &plan, const std::vector<Run> &runs) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+        auto stats = statistics(runs);
+        out << "run";
+        for (const std::string &e : plan.elements()) out << "," << e;
+        for (const auto &entry : stats) out << "," << entry.first;
+        out << ",error\n";
+        out.precision(12);
+        for (size_t k = 0; k < runs.size(); ++k) {
+            out << k;
+            for (double v : runs[k].values) out << "," << v;
+            for (size_t i = 0; i < stats.size(); ++i) {
+                out << ",";
+                if (i < runs[k].results.size() && runs[k].results[i].ok) out << runs[k].results[i].value;
+            }
+            out << ",\"" << runs[k].error << "\"\n";
+        }
+        return true;
+    }
+}
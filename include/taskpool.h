@@ -0,0 +1,200 @@
+#pragma once
+// صف کار مشترک برنامه با دزدیدن کار: تعداد ثابت رشته، یک deque برای هر رشته و یک صف عمومی
+// کار هر رشته از ته صف خودش (LIFO) برداشته می‌شود و رشته بیکار از سر صف دیگران (FIFO) می‌دزدد
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tasks {
+    using Task = std::function<void()>;
+
+    class Pool {
+    public:
+        // یک صف برای کل برنامه؛ رشته‌ای که در TaskGroup::wait منتظر است هم کار می‌کند، پس یکی کمتر از هسته‌ها
+        // و حداقل یک کارگر تا کارهای submit بدون wait هم اجرا شوند
+        static Pool &instance() {
+            static Pool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        // بدون کارگر (workers صفر) کارها فقط در TaskGroup::wait روی رشته منتظر اجرا می‌شوند
+        explicit Pool(unsigned workers) {
+            for (unsigned i = 0; i <= workers; ++i) queues.push_back(std::make_unique<Queue>());
+            for (unsigned i = 0; i < workers; ++i) threads.emplace_back([this, i]() { workerLoop(i); });
+        }
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &t : threads) t.join();
+        }
+
+        Pool(const Pool &) = delete;
+        Pool &operator=(const Pool &) = delete;
+
+        // رشته‌هایی که همزمان کار می‌کنند (کارگرها و رشته منتظر)
+        unsigned concurrency() const { return (unsigned)threads.size() + 1; }
+
+        // از داخل یک کار به صف همان رشته، وگرنه به صف عمومی
+        void submit(Task task) {
+            Queue &queue = current.pool == this ? *queues[current.index] : *queues.back();
+            {
+                std::lock_guard<std::mutex> lock(queue.mtx);
+                queue.tasks.push_back(std::move(task));
+            }
+            ++pending;
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+            }
+            wake.notify_one();
+        }
+
+        // یک کار از صف خود، صف عمومی یا رشته‌های دیگر؛ false یعنی کاری نبود
+        bool runOne() {
+            Task task;
+            if (!take(task)) return false;
+            task();
+            return true;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mtx;
+            std::deque<Task> tasks;
+        };
+
+        struct Worker {
+            Pool *pool = nullptr;
+            size_t index = 0;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;     // یکی برای هر کارگر و آخری صف عمومی
+        std::vector<std::thread> threads;
+        std::atomic<size_t> pending{0};                 // کارهای در صف که هنوز برداشته نشده‌اند
+        std::mutex sleepMtx;
+        std::condition_variable wake;
+        bool stopping = false;
+        static thread_local Worker current;
+
+        bool popBack(Queue &queue, Task &task) {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (queue.tasks.empty()) return false;
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+
+        bool popFront(Queue &queue, Task &task) {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (queue.tasks.empty()) return false;
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+
+        bool take(Task &task) {
+            if (pending == 0) return false;
+            size_t self = current.pool == this ? current.index : queues.size() - 1;
+            bool found = (self + 1 < queues.size() && popBack(*queues[self], task)) || popFront(*queues.back(), task);
+            for (size_t k = 1; !found && k < queues.size() - 1; ++k) {
+                found = popFront(*queues[(self + k) % (queues.size() - 1)], task);
+            }
+            if (found) --pending;
+            return found;
+        }
+
+        void workerLoop(size_t index) {
+            current.pool = this;
+            current.index = index;
+            while (true) {
+                if (runOne()) continue;
+                std::unique_lock<std::mutex> lock(sleepMtx);
+                wake.wait(lock, [this]() { return stopping || pending > 0; });
+                if (stopping && pending == 0) return;
+            }
+        }
+    };
+
+    inline thread_local Pool::Worker Pool::current;
+
+    // گروهی از کارها با join؛ wait تا تمام شدن همه کارها خودش هم کار می‌کند و اولین استثنا را دوباره پرتاب می‌کند
+    class TaskGroup {
+    public:
+        explicit TaskGroup(Pool &pool = Pool::instance()) : pool(pool) {}
+        ~TaskGroup() {
+            try { wait(); } catch (...) {}
+        }
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+        void run(Task task) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                ++remaining;
+            }
+            pool.submit([this, task = std::move(task)]() {
+                try {
+                    task();
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!error) error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                if (--remaining == 0) done.notify_all();
+            });
+        }
+
+        void wait() {
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (remaining == 0) break;
+                }
+                if (pool.runOne()) continue;
+                std::unique_lock<std::mutex> lock(mtx);
+                done.wait(lock, [this]() { return remaining == 0; });
+            }
+            std::exception_ptr e;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                std::swap(e, error);
+            }
+            if (e) std::rethrow_exception(e);
+        }
+
+    private:
+        Pool &pool;
+        std::mutex mtx;
+        std::condition_variable done;
+        size_t remaining = 0;
+        std::exception_ptr error;
+    };
+
+    // body(begin, end) روی تکه‌های [0, count)؛ grain صفر یعنی حدود چهار تکه برای هر رشته
+    template <class Body>
+    void parallelFor(size_t count, Body body, size_t grain = 0, Pool &pool = Pool::instance()) {
+        if (count == 0) return;
+        if (grain == 0) grain = std::max<size_t>(1, count / (4 * pool.concurrency()));
+        if (count <= grain) {
+            body(size_t(0), count);
+            return;
+        }
+        TaskGroup group(pool);
+        for (size_t begin = 0; begin < count; begin += grain) {
+            size_t end = std::min(count, begin + grain);
+            group.run([&body, begin, end]() { body(begin, end); });
+        }
+        group.wait();
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+// ثبت رویدادهای زمانی با فرمت Chrome trace-event (قابل باز شدن در chrome://tracing و Perfetto)
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Tracing {
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent {
+        std::string name;
+        std::string category;
+        long long ts = 0;   // میکروثانیه از شروع ضبط
+        long long dur = 0;
+        int tid = 0;
+    };
+
+    class Tracer {
+    public:
+        static Tracer &instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        void start() {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto it = buffers.begin(); it != buffers.end();) {
+                if (it->use_count() == 1) {     // رشته صاحب بافر تمام شده
+                    it = buffers.erase(it);
+                    continue;
+                }
+                std::lock_guard<std::mutex> bufferLock((*it)->mtx);
+                (*it)->events.clear();
+                ++it;
+            }
+            recorded = 0;
+            epoch = Clock::now().time_since_epoch().count();
+            enabled = true;
+        }
+
+        void stop() { enabled = false; }
+
+        // هر رشته در بافر خودش می‌نویسد (قفل آن فقط با writeJson رقابت دارد)، پس کارهای موازی سر یک قفل صف نمی‌کشند
+        void record(const std::string &name, const char *category, Clock::time_point begin, Clock::time_point end) {
+            if (!isEnabled()) return;
+            if (recorded.fetch_add(1, std::memory_order_relaxed) >= maxEvents) return;
+            Clock::time_point zero{Clock::duration(epoch.load(std::memory_order_relaxed))};
+            TraceEvent ev;
+            ev.name = name;
+            ev.category = category;
+            ev.ts = std::chrono::duration_cast<std::chrono::microseconds>(begin - zero).count();
+            ev.dur = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+            Buffer &b = buffer();
+            ev.tid = b.tid;
+            std::lock_guard<std::mutex> lock(b.mtx);
+            b.events.push_back(std::move(ev));
+        }
+
+        size_t eventCount() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            size_t n = 0;
+            for (auto &b : buffers) {
+                std::lock_guard<std::mutex> bufferLock(b->mtx);
+                n += b->events.size();
+            }
+            return n;
+        }
+
+        bool writeJson(const std::string &path) const {
+            std::ofstream out(path);
+            if (!out.is_open()) return false;
+            std::lock_guard<std::mutex> lock(mtx);
+            out << "{\"traceEvents\":[\n";
+            bool first = true;
+            for (auto &b : buffers) {
+                std::lock_guard<std::mutex> bufferLock(b->mtx);
+                for (const TraceEvent &ev : b->events) {
+                    out << (first ? "" : ",\n") << "{\"name\":\"" << escape(ev.name) << "\",\"cat\":\"" << escape(ev.category)
+                        << "\",\"ph\":\"X\",\"ts\":" << ev.ts << ",\"dur\":" << ev.dur
+                        << ",\"pid\":1,\"tid\":" << ev.tid << "}";
+                    first = false;
+                }
+            }
+            out << (first ? "" : "\n") << "],\"displayTimeUnit\":\"ms\"}\n";
+            return true;
+        }
+
+    private:
+        struct Buffer {
+            std::mutex mtx;
+            int tid = 0;
+            std::vector<TraceEvent> events;
+        };
+
+        Tracer() = default;
+
+        Buffer &buffer() {
+            thread_local std::shared_ptr<Buffer> mine;
+            if (!mine) {
+                mine = std::make_shared<Buffer>();
+                std::lock_guard<std::mutex> lock(mtx);
+                mine->tid = ++threads;
+                buffers.push_back(mine);
+            }
+            return *mine;
+        }
+
+        static std::string escape(const std::string &s) {
+            std::string r;
+            for (char c : s) {
+                if (c == '"' || c == '\\') r += '\\';
+                if (c == '\n') { r += "\\n"; continue; }
+                r += c;
+            }
+            return r;
+        }
+
+        static const size_t maxEvents = 1 << 20;
+        std::atomic<bool> enabled{false};
+        std::atomic<size_t> recorded{0};
+        std::atomic<Clock::rep> epoch{Clock::now().time_since_epoch().count()};
+        mutable std::mutex mtx;
+        std::vector<std::shared_ptr<Buffer>> buffers;     // زیر mtx
+        int threads = 0;
+    };
+
+    // یک بازه زمانی؛ وقتی ضبط خاموش است تقریبا هزینه‌ای ندارد
+    class ScopedEvent {
+    public:
+        explicit ScopedEvent(const char *name, const char *category = "app")
+                : name(name), category(category), active(Tracer::instance().isEnabled()) {
+            if (active) begin = Clock::now();
+        }
+        ~ScopedEvent() { end(); }
+
+        void end() {
+            if (!active) return;
+            active = false;
+            Tracer::instance().record(name, category, begin, Clock::now());
+        }
+        ScopedEvent(const ScopedEvent &) = delete;
+        ScopedEvent &operator=(const ScopedEvent &) = delete;
+
+    private:
+        const char *name;
+        const char *category;
+        bool active;
+        Clock::time_point begin;
+    };
+}
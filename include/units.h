@@ -0,0 +1,168 @@
+#pragma once
+// خواندن اعداد با پسوند مهندسی (10k، 2.2u، 1Meg) بدون regex و بدون تخصیص حافظه
+// constexpr است تا درستی آن با static_assert در زمان کامپایل بررسی شود
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Units {
+    // Gui: مثل فیلدهای دیالوگ؛ کل متن (با فاصله اطراف) باید عدد و پسوند باشد و M یعنی مگا
+    // Spice: مثل نت‌لیست؛ حروف کوچک و بزرگ یکی است، M یعنی میلی و حروف بعد از پسوند (واحد مثل F یا Ohm) نادیده گرفته می‌شوند
+    enum class Syntax { Gui, Spice };
+
+    namespace detail {
+        constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+        constexpr bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+        constexpr bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+        constexpr char lower(char c) { return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c; }
+
+        constexpr bool startsWithNoCase(std::string_view s, std::string_view prefix) {
+            if (s.size() < prefix.size()) return false;
+            for (std::size_t i = 0; i < prefix.size(); ++i) {
+                if (lower(s[i]) != prefix[i]) return false;
+            }
+            return true;
+        }
+
+        // 10^e تا 1e22 دقیق است؛ تقسیم بر آن (به جای ضرب در 10^-e) نتیجه را درست گرد می‌کند
+        constexpr double pow10(int e) {
+            double r = 1.0;
+            for (int i = 0; i < e; ++i) r *= 10.0;
+            return r;
+        }
+
+        // توان ده پسوند و طول آن؛ scale فقط برای mil که توان ده نیست
+        struct Suffix {
+            int exp10 = 0;
+            double scale = 1.0;
+            std::size_t length = 0;
+            bool valid = true;
+        };
+
+        constexpr Suffix suffix(std::string_view s, Syntax syntax) {
+            Suffix r;
+            if (s.empty()) return r;
+            if (syntax == Syntax::Gui) {
+                if (s == "Meg") { r.exp10 = 6; r.length = 3; }
+                else if (s == "mil") { r.scale = 25.4e-6; r.length = 3; }
+                else if (s.size() == 1) {
+                    r.length = 1;
+                    switch (s[0]) {
+                        case 'f': r.exp10 = -15; break;
+                        case 'p': r.exp10 = -12; break;
+                        case 'n': r.exp10 = -9; break;
+                        case 'u': r.exp10 = -6; break;
+                        case 'm': r.exp10 = -3; break;
+                        case 'k': r.exp10 = 3; break;
+                        case 'M': r.exp10 = 6; break;
+                        case 'G': r.exp10 = 9; break;
+                        case 'T': r.exp10 = 12; break;
+                        default: r.valid = false; break;
+                    }
+                }
+                else r.valid = false;
+                return r;
+            }
+            if (startsWithNoCase(s, "meg")) { r.exp10 = 6; r.length = 3; }
+            else if (startsWithNoCase(s, "mil")) { r.scale = 25.4e-6; r.length = 3; }
+            else {
+                r.length = 1;
+                switch (lower(s[0])) {
+                    case 'f': r.exp10 = -15; break;
+                    case 'p': r.exp10 = -12; break;
+                    case 'n': r.exp10 = -9; break;
+                    case 'u': r.exp10 = -6; break;
+                    case 'm': r.exp10 = -3; break;
+                    case 'k': r.exp10 = 3; break;
+                    case 'g': r.exp10 = 9; break;
+                    case 't': r.exp10 = 12; break;
+                    default: r.length = 0; break; // واحد بدون پسوند (مثلا 5V)
+                }
+            }
+            for (std::size_t i = r.length; i < s.size(); ++i) {
+                if (!isAlpha(s[i])) r.valid = false;
+            }
+            return r;
+        }
+    }
+
+    // [+-] digits [. digits] [e[+-]digits] [suffix]؛ در صورت خطا false و out دست نمی‌خورد
+    constexpr bool parse(std::string_view s, double &out, Syntax syntax = Syntax::Gui) {
+        std::size_t i = 0, n = s.size();
+        if (syntax == Syntax::Gui) {
+            while (i < n && detail::isSpace(s[i])) ++i;
+            while (n > i && detail::isSpace(s[n - 1])) --n;
+        }
+        bool negative = false;
+        if (i < n && (s[i] == '+' || s[i] == '-')) negative = (s[i++] == '-');
+
+        // تا ۱۹ رقم معنادار در mantissa؛ رقم‌های بیشتر فقط توان را جابجا می‌کنند
+        std::uint64_t mantissa = 0;
+        int exp10 = 0;
+        int digits = 0;
+        while (i < n && detail::isDigit(s[i])) {
+            if (mantissa < 1000000000000000000ULL) mantissa = mantissa * 10 + (s[i] - '0');
+            else ++exp10;
+            ++digits;
+            ++i;
+        }
+        if (i < n && s[i] == '.') {
+            ++i;
+            while (i < n && detail::isDigit(s[i])) {
+                if (mantissa < 1000000000000000000ULL) {
+                    mantissa = mantissa * 10 + (s[i] - '0');
+                    --exp10;
+                }
+                ++digits;
+                ++i;
+            }
+        }
+        if (digits == 0) return false;
+
+        if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+            std::size_t j = i + 1;
+            bool expNegative = false;
+            if (j < n && (s[j] == '+' || s[j] == '-')) expNegative = (s[j++] == '-');
+            if (j < n && detail::isDigit(s[j])) {
+                int e = 0;
+                while (j < n && detail::isDigit(s[j])) {
+                    if (e < 10000) e = e * 10 + (s[j] - '0');
+                    ++j;
+                }
+                exp10 += expNegative ? -e : e;
+                i = j;
+            }
+        }
+
+        if (syntax == Syntax::Gui) {
+            while (i < n && detail::isSpace(s[i])) ++i;
+        }
+        detail::Suffix sfx = detail::suffix(s.substr(i, n - i), syntax);
+        if (!sfx.valid) return false;
+        exp10 += sfx.exp10;
+
+        double value = (double)mantissa;
+        if (exp10 >= 0) value *= detail::pow10(exp10);
+        else value /= detail::pow10(-exp10);
+        value *= sfx.scale;
+        out = negative ? -value : value;
+        return true;
+    }
+
+    namespace detail {
+        constexpr double valueOf(std::string_view s, Syntax syntax = Syntax::Gui) {
+            double v = -1.0;
+            return parse(s, v, syntax) ? v : -1.0;
+        }
+
+        static_assert(valueOf("10k") == 10e3, "k suffix");
+        static_assert(valueOf(" 2.2u ") == 2.2e-6, "u suffix with spaces");
+        static_assert(valueOf("1Meg") == 1e6 && valueOf("1M") == 1e6, "mega in dialogs");
+        static_assert(valueOf("-4.7e-3") == -4.7e-3, "exponent");
+        static_assert(valueOf("3 n") == 3e-9, "space before suffix");
+        static_assert(valueOf("10kOhm") == -1.0 && valueOf("1.2.3") == -1.0 && valueOf("") == -1.0, "strict dialogs");
+        static_assert(valueOf("1M", Syntax::Spice) == 1e-3 && valueOf("1MEG", Syntax::Spice) == 1e6, "SPICE mega/milli");
+        static_assert(valueOf("10uF", Syntax::Spice) == 10e-6 && valueOf("5V", Syntax::Spice) == 5.0, "SPICE units");
+        static_assert(valueOf("1k5", Syntax::Spice) == -1.0, "digits after suffix");
+    }
+}
@@ -11,12 +11,20 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <complex>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
-#include <regex>
+#include <chrono>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <cstring>
+#include <filesystem>
 
 // --- Windows TCP/IP ---
 #define WIN32_LEAN_AND_MEAN
@@ -38,6 +46,21 @@
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/utility.hpp>
 
+// --- Project ---
+#include "bytes.h"
+#include "expression.h"
+#include "journal.h"
+#include "measure.h"
+#include "net.h"
+#include "profiler.h"
+#include "project.h"
+#include "samples.h"
+#include "stream.h"
+#include "sweep.h"
+#include "taskpool.h"
+#include "trace.h"
+#include "units.h"
+
 using namespace std;
 
 //////---------------------------------------
@@ -48,6 +71,7 @@ int stepY=15;
 string nameFile="firstRun";
 string IP="127.0.0.1";
 int PORT=8080;
+int WORKER_PORT=8081;     // کارگر شبیه‌سازی (CircuNet --worker)
 bool isOnceSave=false;
 
 //////---------------------------------------
@@ -56,6 +80,29 @@ void snapToGrid(int &x, int &y) {
     y = (y / stepY) * stepY + stepY/2;
 }
 //////---------------------------------------
+// قالب سریالایز مدار: Compact فقط خود مدار (المان‌ها، نت‌ها و جای آن‌ها) را ذخیره می‌کند
+// و مستطیل‌ها، رنگ‌ها، وضعیت رابط و نتیجه تحلیل هنگام خواندن از نو ساخته می‌شوند
+// Legacy قالب فایل‌های قدیمی است و فقط برای خواندن آن‌ها (تبدیل به قالب جدید) استفاده می‌شود
+namespace Schema {
+    enum class Layout { Legacy, Compact };
+
+    // برای هر رشته جدا، چون ذخیره، باز کردن و شبکه روی رشته‌های مختلف سریالایز می‌کنند
+    inline thread_local Layout layout = Layout::Compact;
+
+    inline bool legacy() { return layout == Layout::Legacy; }
+
+    // قالب را تا پایان scope عوض می‌کند
+    class Scope {
+    public:
+        explicit Scope(Layout l) : previous(layout) { layout = l; }
+        ~Scope() { layout = previous; }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        Layout previous;
+    };
+}
+//////---------------------------------------
 namespace Exceptions {
     class SyntaxError:public exception{
         const char* what() const noexcept override {
@@ -153,6 +200,16 @@ namespace Exceptions {
             return message.c_str();
         }
     };
+    class netlistError : public exception {
+    public:
+        string message;
+        netlistError(size_t line, const std::string& msg) {
+            message = line ? "Error: netlist line " + to_string(line) + ": " + msg : "Error: netlist: " + msg;
+        }
+        const char* what() const noexcept override {
+            return message.c_str();
+        }
+    };
     class NotFoundGND:public exception{
         const char* what() const noexcept override {
             return "Error: Number of grounds must not be 0 or more than one";
@@ -187,6 +244,22 @@ namespace Circuit{
         }
 
         Node(int x, int y): x(x),y(y) {
+            updateRects();
+            name = "N" + to_string((y / stepY) * (WindowH / stepY) + (x / stepX) + 1);
+            voltage=0.0;
+            isGround= false;
+        }
+
+        // نود شبکه که با نود تازه همان نقطه فرقی ندارد در فایل پروژه ذخیره نمی‌شود
+        bool isPristine() const {
+            Node fresh(x, y);
+            return name == fresh.name && voltage == fresh.voltage && isGround == fresh.isGround &&
+                   AcVoltage == fresh.AcVoltage && !enabled && !visible && !pressed &&
+                   color.r == fresh.color.r && color.g == fresh.color.g && color.b == fresh.color.b && color.a == fresh.color.a &&
+                   SDL_RectEquals(&rect, &fresh.rect) && SDL_RectEquals(&expandedRect, &fresh.expandedRect);
+        }
+
+        void updateRects() {
             rect = {x, y, 3, 3}; // اندازه پیش‌فرض برای مقاومت
             expandedRect = {
                     rect.x - 5,      // ۵ پیکسل به چپ
@@ -194,15 +267,18 @@ namespace Circuit{
                     rect.w + 10,     // ۱۰ پیکسل به عرض (۵ از هر طرف)
                     rect.h + 10      // ۱۰ پیکسل به ارتفاع (۵ از هر طرف)
             };
-            name = "N" + to_string((y / stepY) * (WindowH / stepY) + (x / stepX) + 1);
-            voltage=0.0;
-            isGround= false;
         }
 
         // تابع serialize
+        // Compact: مکان، نام و زمین؛ ولتاژها نتیجه تحلیل‌اند و enabled را Wire::restoreNodes از روی خطوط می‌سازد
         template<class Archive>
         void serialize(Archive & ar)
         {
+            if (!Schema::legacy()) {
+                ar(x, y, name, isGround);
+                if (Archive::is_loading::value) updateRects();
+                return;
+            }
             ar(x, y, voltage, isGround, AcVoltage, name);
             ar(rect.x, rect.y, rect.w, rect.h);
             ar(enabled, visible, pressed);
@@ -319,8 +395,13 @@ namespace Circuit{
         int x2 = 0, y2 = 0;
 
     public:
+        // Compact: دو سر، نقاط روی خط و نام؛ A، B، C در draw دوباره حساب می‌شوند
         template<class Archive>
         void serialize(Archive &ar) {
+            if (!Schema::legacy()) {
+                ar(startNode, endNode, lineName, isComplete, Nodes);
+                return;
+            }
             ar(startNode, endNode, A, B, C,
                lineName, isDrawing, isComplete,
                Nodes, waitingForFirstClick,
@@ -361,12 +442,55 @@ namespace Circuit{
         shared_ptr<Node> tempStart; // نقطه شروع خط موقت
         shared_ptr<Node> tempEnd;  // نقطه پایان خط موقت
     public:
+        // Compact: فقط تعداد نت‌ها؛ خط نیمه‌کاره حالت رابط است و با خواندن مدار پاک می‌شود
         template <class Archive>
         void serialize(Archive& archive) {
+            if (!Schema::legacy()) {
+                archive(componentId);
+                if (Archive::is_loading::value) tempStart = tempEnd = nullptr;
+                return;
+            }
             archive(tempStart, tempEnd, isActive, componentId); // بدون نام
         }
         Wire() : isActive(false), tempStart(nullptr), tempEnd(nullptr) {}
 
+        // نودهایی که در فایل پروژه ذخیره می‌شوند: تغییر کرده، یا چیزی جز allNodes (المان، خط، سیم) به آن‌ها اشاره می‌کند
+        static vector<shared_ptr<Node>> usedNodes() {
+            vector<shared_ptr<Node>> used;
+            for (auto &node : allNodes) {
+                if (node.use_count() > 1 || !node->isPristine()) used.push_back(node);
+            }
+            return used;
+        }
+
+        // شبکه خالی نودها به اندازه پنجره
+        static void resetGrid() {
+            allNodes.clear();
+            for (int y = stepY/2; y < WindowH; y += stepY) {
+                for (int x = stepX/2; x < WindowW; x += stepX) {
+                    allNodes.push_back(make_shared<Node>(x, y));
+                }
+            }
+        }
+
+        // نودهای خوانده شده جای نود هم‌مکان در شبکه تازه را می‌گیرند؛ نودی که در شبکه جایی ندارد به آخر اضافه می‌شود
+        // نودهای روی خطوط مثل handleMouseClick فعال می‌شوند
+        static void restoreNodes(const vector<shared_ptr<Node>> &used) {
+            unordered_map<long long, size_t> index;
+            auto key = [](const Node &n) { return ((long long)n.x << 32) | (unsigned int)n.y; };
+            for (size_t i = 0; i < allNodes.size(); ++i) index[key(*allNodes[i])] = i;
+            for (auto &node : used) {
+                auto it = index.find(key(*node));
+                if (it != index.end()) allNodes[it->second] = node;
+                else allNodes.push_back(node);
+            }
+            for (auto &line : Lines) {
+                for (auto &node : line->Nodes) {
+                    if (node) node->enabled = true;
+                }
+            }
+        }
+
         static shared_ptr<Node> findNode(int x, int y) {
             for (auto &i: allNodes) {
                 if (i->x == x && i->y == y)
@@ -673,8 +797,17 @@ namespace Circuit{
         bool mirror=false;
         //Node *connectedNode; // اضافه کردن این خط
         //----------------------------------------------
+        // Compact: نودها، جای المان، نام، مقدار و پارامترهای AC؛ ولتاژ و جریان نتیجه تحلیل‌اند و اندازه و رنگ ثابت
         template <class Archive>
         void serialize(Archive& ar) {
+            if (!Schema::legacy()) {
+                ar(nodeN, nodeP, rect.x, rect.y, name, value, type, AcValue, phase, fr, mirror);
+                if (Archive::is_loading::value) {
+                    rect.w = stepX*4;
+                    rect.h = stepY*2;
+                }
+                return;
+            }
             ar(nodeN,
                nodeP,
                voltage,
@@ -791,8 +924,10 @@ namespace Circuit{
     public:
         template <class Archive>
         void serialize(Archive& ar) {
-            ar(cereal::base_class<Element>(this), // سریالایز بخش پایه
-               capacitance,previousVoltage);
+            // previousVoltage حالت تحلیل گذراست
+            if (!Schema::legacy()) ar(cereal::base_class<Element>(this), capacitance);
+            else ar(cereal::base_class<Element>(this), // سریالایز بخش پایه
+                    capacitance,previousVoltage);
         }
         void draw(SDL_Renderer* renderer, TTF_Font* font) override {
             // رنگ مستطیل (قهوه‌ای برای مقاومت)
@@ -855,8 +990,10 @@ namespace Circuit{
     public:
         template <class Archive>
         void serialize(Archive& ar) {
-            ar(cereal::base_class<Element>(this), // سریالایز بخش پایه
-               inductance,previousCurrent);
+            // previousCurrent حالت تحلیل گذراست
+            if (!Schema::legacy()) ar(cereal::base_class<Element>(this), inductance);
+            else ar(cereal::base_class<Element>(this), // سریالایز بخش پایه
+                    inductance,previousCurrent);
         }
         Inductor(){}
         void draw(SDL_Renderer* renderer, TTF_Font* font) override {
@@ -1282,7 +1419,7 @@ namespace Circuit{
 
                   pwlFileName(pwlFile) {
 
-            loadPWLFile(pwlFile);
+            if (!pwlFile.empty()) loadPWLFile(pwlFile);
 
         }
 
@@ -1422,6 +1559,55 @@ namespace Circuit{
 
         }
 
+        // نقاط مستقیم (مثلا از کارت PWL نت‌لیست) بدون فایل
+
+        void setTimeVoltagePairs(const vector<pair<double, double>>& points) {
+
+            timeVoltagePairs = points;
+
+            pwlFileName = "";
+
+            setValue(points.empty() ? 0.0 : points[0].second);
+
+        }
+
+    };
+
+    // هم‌شبیه‌سازی: نمونه‌ها در حین تحلیل گذرا از سوکت یا فایل/pipe می‌رسند (Streaming::Feed)؛
+    // source مثل tcp:127.0.0.1:9000 یا data/stream.txt. هر تحلیل گذرا منبع را از اول باز می‌کند
+    class StreamVoltageSource : public VoltageSource {
+    private:
+        string source;
+        shared_ptr<Streaming::Feed> feed;      // فقط در حین تحلیل گذرا
+    public:
+        // حداکثر انتظار حل‌کننده برای نمونه بعدی؛ بعد از آن مقدار قبلی می‌ماند (stream_underruns)
+        static constexpr chrono::milliseconds stallLimit{2000};
+
+        template <class Archive>
+        void serialize(Archive& ar) {
+            ar(cereal::base_class<VoltageSource>(this), source);
+        }
+        StreamVoltageSource(){}
+        StreamVoltageSource(int x, int y, string name = "", string source = "",
+                            shared_ptr<Node> n = nullptr, shared_ptr<Node> p = nullptr)
+                : VoltageSource(x, y, name, 0.0, n, p), source(source) {}
+
+        const string& getSource() const { return source; }
+
+        void open() {
+            feed.reset();
+            feed = make_shared<Streaming::Feed>(source);
+            setValue(0.0);
+        }
+
+        void close() { feed.reset(); }
+
+        void setValueAtTime(double t) override {
+            if (!feed) return;
+            bool underrun;
+            setValue(feed->valueAt(t, stallLimit, underrun));
+            if (underrun) Profiling::Profiler::instance().count("stream_underruns");
+        }
     };
 
     class SinVoltageSource : public VoltageSource {
@@ -2251,6 +2437,12 @@ namespace Circuit{
     public:
         template <class Archive>
         void serialize(Archive& ar) {
+            // isOn و assumedOn حالت حل‌کننده‌اند
+            if (!Schema::legacy()) {
+                ar(cereal::base_class<Element>(this), model, vOn);
+                if (Archive::is_loading::value) isOn = assumedOn = false;
+                return;
+            }
             ar(
                     cereal::base_class<Element>(this), // سریالایز بخش VoltageSource
                     model,vOn,isOn,assumedOn
@@ -2721,6 +2913,7 @@ namespace Circuit{
         }
         shared_ptr<Node> getControlNodeP() const { return ctrlPositive; }
         shared_ptr<Node> getControlNodeN() const { return ctrlNegative; }
+        void setControlNodes(shared_ptr<Node> p, shared_ptr<Node> n) { ctrlPositive = p; ctrlNegative = n; }
     };
 
     class VCVS : public VoltageSource {
@@ -2839,6 +3032,7 @@ namespace Circuit{
         }
         shared_ptr<Node> getControlNodeP() const { return ctrlPositive; }
         shared_ptr<Node> getControlNodeN() const { return ctrlNegative; }
+        void setControlNodes(shared_ptr<Node> p, shared_ptr<Node> n) { ctrlPositive = p; ctrlNegative = n; }
     };
 }
 using namespace Circuit;
@@ -2851,6 +3045,7 @@ CEREAL_REGISTER_TYPE(CurrentSource)
 CEREAL_REGISTER_TYPE(SinVoltageSource)
 CEREAL_REGISTER_TYPE(SinCurrentSource)
 CEREAL_REGISTER_TYPE(PWLVoltageSource)
+CEREAL_REGISTER_TYPE(StreamVoltageSource)
 CEREAL_REGISTER_TYPE(PulseVoltageSource)
 CEREAL_REGISTER_TYPE(PulseCurrentSource)
 CEREAL_REGISTER_TYPE(deltaVoltageSource)
@@ -2876,6 +3071,7 @@ CEREAL_REGISTER_POLYMORPHIC_RELATION(VoltageSource, deltaVoltageSource)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(VoltageSource, CCVS)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(VoltageSource, VCVS)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(VoltageSource, PWLVoltageSource)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(VoltageSource, StreamVoltageSource)
 // روابط مشتق شده از CurrentSource
 CEREAL_REGISTER_POLYMORPHIC_RELATION(CurrentSource, SinCurrentSource)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(CurrentSource, PulseCurrentSource)
@@ -4328,6 +4524,9 @@ namespace graphicElements{
                     }
                     else if (currentElementType == "PWLVoltageSource") {
                     }
+                    else if (currentElementType == "StreamVoltageSource") {
+                        values.push_back(valueBox.text);    // فایل یا tcp:host:port
+                    }
                     else if (currentElementType == "Diode") {
                         values.push_back(modelBox.text);
                     }
@@ -4434,6 +4633,12 @@ namespace graphicElements{
                 currentY += fieldSpacing;
             }
             else if (currentElementType == "PWLVoltageSource") {}
+            else if (currentElementType == "StreamVoltageSource") {
+                valueBox.rect.x = rect.x + textBoxOffset;
+                valueBox.rect.y = rect.y + currentY;
+                valueBox.rect.w = textBoxWidth;
+                currentY += fieldSpacing;
+            }
             else if (currentElementType == "Diode") {
                 modelBox.rect.x = rect.x + textBoxOffset;
                 modelBox.rect.y = rect.y + currentY;
@@ -4568,6 +4773,7 @@ namespace graphicElements{
                     {"AcVoltageSource", "AC Voltage Source Properties"},
                     {"PhaseVoltageSource", "Phase Voltage Source Properties"},
                     {"PWLVoltageSource", "PWL Voltage Source Properties"},
+                    {"StreamVoltageSource", "Stream Voltage Source Properties"},
                     {"CurrentSource", "DC Current Source Properties"},
                     {"CCCS", "CCCS Properties"},
                     {"CCVS", "CCVS Properties"},
@@ -4660,6 +4866,9 @@ namespace graphicElements{
                 valueBox.handleEvent(e);
                 bfrBox.handleEvent(e);
             }
+            else if (currentElementType == "StreamVoltageSource") {
+                valueBox.handleEvent(e);
+            }
             else if (currentElementType == "Diode") {
                 modelBox.handleEvent(e);
             } else if (currentElementType == "CCCS" || currentElementType == "CCVS") {
@@ -4744,6 +4953,10 @@ namespace graphicElements{
             }
             else if (currentElementType == "PWLVoltageSource") {
             }
+            else if (currentElementType == "StreamVoltageSource") {
+                drawLabel(renderer, "Source:", labelX, currentY);
+                valueBox.draw(renderer);
+            }
             else if (currentElementType == "Diode") {
                 drawLabel(renderer, "Model:", labelX, currentY);
                 modelBox.draw(renderer);
@@ -5321,8 +5534,18 @@ namespace graphicElements{
         static shared_ptr<LabelNet> placingInstance;
         std::string fontPath="assets/Tahoma.ttf"; // برای ذخیره مسیر فونت
 
+        // Compact: متن و جای برچسب و پایه؛ اندازه‌ها، رنگ‌ها و فونت ثابت‌اند
         template <class Archive>
         void serialize(Archive& ar) {
+            if (!Schema::legacy()) {
+                ar(text, rect.x, rect.y, baseRect.x, baseRect.y);
+                if (Archive::is_loading::value) {
+                    rect.w = 30;
+                    rect.h = 15;
+                    baseRect.w = baseRect.h = 10;
+                }
+                return;
+            }
             // سریالایز مستطیل‌ها
             ar(rect.x, rect.y, rect.w, rect.h);
             ar(baseRect.x, baseRect.y, baseRect.w, baseRect.h);
@@ -5489,8 +5712,18 @@ namespace graphicElements{
         bool isPlacing;
         static shared_ptr<GNDSymbol> placingInstance;
 
+        // Compact: نقطه شبکه؛ مستطیل‌ها با updatePosition ساخته می‌شوند
         template <class Archive>
         void serialize(Archive& ar) {
+            if (!Schema::legacy()) {
+                int x = baseRect.x + 5 - 1, y = baseRect.y + 5 - 1;
+                ar(x, y);
+                if (Archive::is_loading::value) {
+                    isPlacing = false;
+                    updatePosition(x, y);
+                }
+                return;
+            }
             // سریالایز مستطیل‌ها
             ar(bounds.x, bounds.y, bounds.w, bounds.h);
             ar(baseRect.x, baseRect.y, baseRect.w, baseRect.h);
@@ -5604,7 +5837,10 @@ namespace graphicElements{
 
     shared_ptr<GNDSymbol> GNDSymbol::placingInstance = nullptr;
 
-    std::string ShowSaveDialog(HWND hwnd) {
+    const char* circuitFileFilter = "Circuit Files\0*.shirali\0All Files\0*.*\0";
+    const char* netlistFileFilter = "SPICE Netlist\0*.cir;*.sp;*.net;*.spice\0All Files\0*.*\0";
+
+    std::string ShowSaveDialog(HWND hwnd, const char* filter = circuitFileFilter) {
         OPENFILENAME ofn = {0};
         char szFile[260] = {0};
 
@@ -5612,7 +5848,7 @@ namespace graphicElements{
         ofn.hwndOwner = hwnd;
         ofn.lpstrFile = szFile;
         ofn.nMaxFile = sizeof(szFile);
-        ofn.lpstrFilter = "Circuit Files\0*.shirali\0All Files\0*.*\0";
+        ofn.lpstrFilter = filter;
         ofn.nFilterIndex = 1;
         ofn.lpstrDefExt = "cir"; // پسوند اختصاصی برای فایل‌های مدار
         ofn.Flags = OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT | OFN_NOCHANGEDIR;
@@ -5623,7 +5859,7 @@ namespace graphicElements{
         return "";
     }
 
-    string ShowOpenFileDialog(HWND hwnd) {
+    string ShowOpenFileDialog(HWND hwnd, const char* filter = circuitFileFilter) {
         OPENFILENAME ofn = {0};
         char szFile[MAX_PATH] = {0};
 
@@ -5631,7 +5867,7 @@ namespace graphicElements{
         ofn.hwndOwner = hwnd;
         ofn.lpstrFile = szFile;
         ofn.nMaxFile = sizeof(szFile);
-        ofn.lpstrFilter = "Circuit Files\0*.shirali\0All Files\0*.*\0";
+        ofn.lpstrFilter = filter;
         ofn.nFilterIndex = 1;
         ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR;
 
@@ -5644,6 +5880,338 @@ namespace graphicElements{
 }
 using namespace graphicElements;
 
+//////---------------------------------------
+// تغییرات کوچک مدار (افزودن، حذف، آینه و جابه‌جایی) برای دفتر بازیابی؛ به جای کپی کل مدار
+namespace Editing {
+    enum class Kind : uint8_t {
+        AddElement, RemoveElement, MirrorElement,
+        AddLine, RemoveLine,
+        AddLabel, RemoveLabel, MoveLabel,
+        AddGround, RemoveGround
+    };
+
+    struct LabelPlace {
+        int x = 0, y = 0, baseX = 0, baseY = 0;
+
+        bool operator!=(const LabelPlace &o) const { return x != o.x || y != o.y || baseX != o.baseX || baseY != o.baseY; }
+
+        template <class Archive>
+        void serialize(Archive &ar) { ar(x, y, baseX, baseY); }
+    };
+
+    inline LabelPlace placeOf(const LabelNet &label) {
+        return {label.rect.x, label.rect.y, label.baseRect.x, label.baseRect.y};
+    }
+
+    // یک تغییر؛ index جای شیء در vector مربوط در لحظه اعمال است
+    // شیء حذف شده فقط در حافظه نگه داشته می‌شود و در دفتر فقط index آن نوشته می‌شود
+    struct Edit {
+        Kind kind = Kind::AddElement;
+        uint32_t index = 0;
+        shared_ptr<Element> element;
+        shared_ptr<liine> line;
+        shared_ptr<LabelNet> label;
+        shared_ptr<GNDSymbol> ground;
+        LabelPlace from, to;            // MoveLabel
+
+        template <class Archive>
+        void serialize(Archive &ar) {
+            ar(kind, index);
+            switch (kind) {
+                case Kind::AddElement: ar(element); break;
+                case Kind::AddLine: ar(line); break;
+                case Kind::AddLabel: ar(label); break;
+                case Kind::AddGround: ar(ground); break;
+                case Kind::MoveLabel: ar(from, to); break;
+                default: break;
+            }
+        }
+    };
+
+    // مدار صفحه؛ خطوط در Wire::Lines هستند
+    struct Scene {
+        vector<shared_ptr<Element>> &elements;
+        vector<shared_ptr<LabelNet>> &labels;
+        vector<shared_ptr<GNDSymbol>> &grounds;
+    };
+
+    // نود شیئی که از دفتر خوانده شده به نود هم‌مکان شبکه وصل می‌شود
+    inline shared_ptr<Node> onGrid(const shared_ptr<Node> &node) {
+        if (!node) return node;
+        shared_ptr<Node> gridNode = Wire::findNode(node->x, node->y);
+        return gridNode ? gridNode : node;
+    }
+
+    template <class T>
+    void insertAt(vector<shared_ptr<T>> &v, size_t index, const shared_ptr<T> &item) {
+        v.insert(v.begin() + min(index, v.size()), item);
+    }
+
+    template <class T>
+    void eraseAt(vector<shared_ptr<T>> &v, size_t index) {
+        if (index < v.size()) v.erase(v.begin() + index);
+    }
+
+    inline void apply(const Edit &e, const Scene &scene) {
+        switch (e.kind) {
+            case Kind::AddElement: {
+                e.element->setNodeN(onGrid(e.element->getNodeN()));
+                e.element->setNodeP(onGrid(e.element->getNodeP()));
+                if (auto vcvs = dynamic_pointer_cast<VCVS>(e.element)) {
+                    vcvs->setControlNodes(onGrid(vcvs->getControlNodeP()), onGrid(vcvs->getControlNodeN()));
+                }
+                if (auto vccs = dynamic_pointer_cast<VCCS>(e.element)) {
+                    vccs->setControlNodes(onGrid(vccs->getControlNodeP()), onGrid(vccs->getControlNodeN()));
+                }
+                insertAt(scene.elements, e.index, e.element);
+                break;
+            }
+            case Kind::RemoveElement: eraseAt(scene.elements, e.index); break;
+            case Kind::MirrorElement:
+                if (e.index < scene.elements.size()) scene.elements[e.index]->Mirror();
+                break;
+            case Kind::AddLine: {
+                // مثل Wire::handleMouseClick
+                e.line->startNode = onGrid(e.line->startNode);
+                e.line->endNode = onGrid(e.line->endNode);
+                for (auto &node : e.line->Nodes) {
+                    node = onGrid(node);
+                    if (!node) continue;
+                    node->name = e.line->lineName;
+                    node->enabled = true;
+                }
+                insertAt(Wire::Lines, e.index, e.line);
+                break;
+            }
+            case Kind::RemoveLine: eraseAt(Wire::Lines, e.index); break;
+            case Kind::AddLabel: insertAt(scene.labels, e.index, e.label); break;
+            case Kind::RemoveLabel: eraseAt(scene.labels, e.index); break;
+            case Kind::MoveLabel:
+                if (e.index < scene.labels.size()) {
+                    LabelNet &label = *scene.labels[e.index];
+                    label.rect.x = e.to.x;
+                    label.rect.y = e.to.y;
+                    label.baseRect.x = e.to.baseX;
+                    label.baseRect.y = e.to.baseY;
+                }
+                break;
+            case Kind::AddGround: insertAt(scene.grounds, e.index, e.ground); break;
+            case Kind::RemoveGround: eraseAt(scene.grounds, e.index); break;
+        }
+    }
+
+    inline string encode(const vector<Edit> &edits) {
+        ostringstream os;
+        {
+            cereal::BinaryOutputArchive archive(os);
+            archive(edits);
+        }
+        return os.str();
+    }
+
+    // از همان بافر پیام یا رکورد خوانده می‌شود، بدون کپی
+    inline vector<Edit> decode(string_view data) {
+        vector<Edit> edits;
+        Bytes::InputView view(data);
+        istream is(&view);
+        cereal::BinaryInputArchive archive(is);
+        archive(edits);
+        return edits;
+    }
+
+    // حذف‌ها از آخر به اول و بعد افزودن‌ها به ترتیب، تا index ها هنگام اعمال پشت سر هم درست باشند
+    // (ترتیب نسبی اشیای باقی‌مانده با erase و push_back عوض نمی‌شود)
+    // kept[i] جای قبلی after[i] یا -1 برای شیء جدید
+    template <class T, class Attach>
+    void diff(const vector<shared_ptr<T>> &before, const vector<shared_ptr<T>> &after, Kind add, Kind remove,
+              vector<Edit> &out, vector<long long> &kept, Attach attach) {
+        kept.assign(after.size(), -1);
+        bool same = before.size() == after.size();
+        for (size_t i = 0; same && i < after.size(); ++i) same = before[i] == after[i];
+        if (same) {
+            for (size_t i = 0; i < after.size(); ++i) kept[i] = (long long)i;
+            return;
+        }
+        unordered_map<T *, size_t> oldIndex;
+        for (size_t i = 0; i < before.size(); ++i) oldIndex[before[i].get()] = i;
+        vector<bool> survives(before.size(), false);
+        for (size_t i = 0; i < after.size(); ++i) {
+            auto it = oldIndex.find(after[i].get());
+            if (it == oldIndex.end()) continue;
+            kept[i] = (long long)it->second;
+            survives[it->second] = true;
+        }
+        for (size_t i = before.size(); i-- > 0;) {
+            if (survives[i]) continue;
+            Edit e;
+            e.kind = remove;
+            e.index = (uint32_t)i;
+            attach(e, before[i]);
+            out.push_back(e);
+        }
+        for (size_t i = 0; i < after.size(); ++i) {
+            if (kept[i] >= 0) continue;
+            Edit e;
+            e.kind = add;
+            e.index = (uint32_t)i;
+            attach(e, after[i]);
+            out.push_back(e);
+        }
+    }
+
+    // برچسب‌ها یا زمین‌هایی که در حال قرار گرفتن نیستند؛ index تغییرات برچسب و زمین در همین فهرست است
+    template <class T>
+    vector<shared_ptr<T>> placed(const vector<shared_ptr<T>> &items) {
+        vector<shared_ptr<T>> result;
+        for (auto &item : items) {
+            if (!item->isPlacing) result.push_back(item);
+        }
+        return result;
+    }
+
+    // آخرین حالت ثبت شده مدار؛ changes تفاوت مدار فعلی با آن را به صورت Edit می‌دهد و حالت را جلو می‌برد
+    // برچسب و زمینی که هنوز در حال قرار گرفتن است، و جابه‌جایی برچسبی که کشیده می‌شود، تا رها شدن ثبت نمی‌شود
+    class Tracker {
+    public:
+        void reset(const Scene &scene) {
+            elements = scene.elements;
+            mirrored.clear();
+            for (auto &e : elements) mirrored.push_back(e->mirror);
+            lines = Wire::Lines;
+            labels = placed(scene.labels);
+            places.clear();
+            for (auto &l : labels) places.push_back(placeOf(*l));
+            grounds = placed(scene.grounds);
+        }
+
+        vector<Edit> changes(const Scene &scene) {
+            vector<Edit> edits;
+            vector<long long> kept;
+
+            diff(elements, scene.elements, Kind::AddElement, Kind::RemoveElement, edits, kept,
+                 [](Edit &e, const shared_ptr<Element> &p) { e.element = p; });
+            vector<bool> nowMirrored;
+            for (size_t i = 0; i < scene.elements.size(); ++i) {
+                bool m = scene.elements[i]->mirror;
+                if (kept[i] >= 0 && mirrored[kept[i]] != m) {
+                    Edit e;
+                    e.kind = Kind::MirrorElement;
+                    e.index = (uint32_t)i;
+                    edits.push_back(e);
+                }
+                nowMirrored.push_back(m);
+            }
+            elements = scene.elements;
+            mirrored.swap(nowMirrored);
+
+            diff(lines, Wire::Lines, Kind::AddLine, Kind::RemoveLine, edits, kept,
+                 [](Edit &e, const shared_ptr<liine> &p) { e.line = p; });
+            lines = Wire::Lines;
+
+            vector<shared_ptr<LabelNet>> nowLabels = placed(scene.labels);
+            diff(labels, nowLabels, Kind::AddLabel, Kind::RemoveLabel, edits, kept,
+                 [](Edit &e, const shared_ptr<LabelNet> &p) { e.label = p; });
+            vector<LabelPlace> nowPlaces;
+            for (size_t i = 0; i < nowLabels.size(); ++i) {
+                LabelPlace place = placeOf(*nowLabels[i]);
+                if (kept[i] >= 0) {
+                    if (nowLabels[i]->isDragging) place = places[kept[i]];
+                    else if (place != places[kept[i]]) {
+                        Edit e;
+                        e.kind = Kind::MoveLabel;
+                        e.index = (uint32_t)i;
+                        e.from = places[kept[i]];
+                        e.to = place;
+                        edits.push_back(e);
+                    }
+                }
+                nowPlaces.push_back(place);
+            }
+            labels.swap(nowLabels);
+            places.swap(nowPlaces);
+
+            vector<shared_ptr<GNDSymbol>> nowGrounds = placed(scene.grounds);
+            diff(grounds, nowGrounds, Kind::AddGround, Kind::RemoveGround, edits, kept,
+                 [](Edit &e, const shared_ptr<GNDSymbol> &p) { e.ground = p; });
+            grounds.swap(nowGrounds);
+            return edits;
+        }
+
+    private:
+        vector<shared_ptr<Element>> elements;
+        vector<bool> mirrored;
+        vector<shared_ptr<liine>> lines;
+        vector<shared_ptr<LabelNet>> labels;
+        vector<LabelPlace> places;
+        vector<shared_ptr<GNDSymbol>> grounds;
+
+    };
+
+    // عکس یک تغییر؛ شیء حذف شده در Edit مانده و همان شیء (با همان نودها) برمی‌گردد
+    inline Edit inverse(const Edit &e) {
+        Edit r = e;
+        switch (e.kind) {
+            case Kind::AddElement: r.kind = Kind::RemoveElement; break;
+            case Kind::RemoveElement: r.kind = Kind::AddElement; break;
+            case Kind::AddLine: r.kind = Kind::RemoveLine; break;
+            case Kind::RemoveLine: r.kind = Kind::AddLine; break;
+            case Kind::AddLabel: r.kind = Kind::RemoveLabel; break;
+            case Kind::RemoveLabel: r.kind = Kind::AddLabel; break;
+            case Kind::AddGround: r.kind = Kind::RemoveGround; break;
+            case Kind::RemoveGround: r.kind = Kind::AddGround; break;
+            case Kind::MoveLabel: swap(r.from, r.to); break;
+            case Kind::MirrorElement: break;
+        }
+        return r;
+    }
+
+    // undo/redo؛ هر فرمان تغییرات یک فریم از Tracker است، نه کپی مدار
+    // index برچسب و زمین جای آن بین اشیای قرار گرفته است، پس وقتی چیزی در حال قرار گرفتن است اعمال نمی‌شود
+    class History {
+    public:
+        explicit History(size_t limit = 1000) : limit(limit) {}
+
+        void record(vector<Edit> edits) {
+            if (edits.empty()) return;
+            undoStack.push_back(std::move(edits));
+            if (undoStack.size() > limit) undoStack.pop_front();
+            redoStack.clear();
+        }
+
+        bool undo(const Scene &scene) {
+            if (undoStack.empty()) return false;
+            vector<Edit> edits = std::move(undoStack.back());
+            undoStack.pop_back();
+            for (auto it = edits.rbegin(); it != edits.rend(); ++it) apply(inverse(*it), scene);
+            redoStack.push_back(std::move(edits));
+            return true;
+        }
+
+        bool redo(const Scene &scene) {
+            if (redoStack.empty()) return false;
+            vector<Edit> edits = std::move(redoStack.back());
+            redoStack.pop_back();
+            for (auto &e : edits) apply(e, scene);
+            undoStack.push_back(std::move(edits));
+            return true;
+        }
+
+        bool canUndo() const { return !undoStack.empty(); }
+        bool canRedo() const { return !redoStack.empty(); }
+
+        void clear() {
+            undoStack.clear();
+            redoStack.clear();
+        }
+
+    private:
+        deque<vector<Edit>> undoStack;
+        vector<vector<Edit>> redoStack;
+        size_t limit;
+    };
+}
+using namespace Editing;
+
 //////---------------------------------------
 namespace Analyze{
     bool allVisited(const vector<bool>& xx) {
@@ -5704,9 +6272,10 @@ namespace Analyze{
         }
         return false; // All connected nodes visited - continuous
     }
-    bool notFoundGnd(){
+    // نودهای همان مداری که تحلیل می‌شود (در جاروب کپی هر اجرا، نه شبکه سراسری Wire::allNodes)
+    bool notFoundGnd(const vector<shared_ptr<Node>>& nodes){
         int n=0;
-        for (auto &i:Wire::allNodes) {
+        for (auto &i:nodes) {
             if(i->getIsGround())
                 n++;
         }
@@ -5716,13 +6285,14 @@ namespace Analyze{
         if (!discontinuousCircuit(elements,nodes)) {
             throw DiscontinuousCircuit();
         }
-        if (!notFoundGnd()) {
+        if (!notFoundGnd(nodes)) {
             throw NotFoundGND();
         }
     }
     vector<double> solveLinearSystem(vector<vector<double>>& A, vector<double>& z) {
         const double EPSILON = 1e-12;
         int n = A.size();
+        Profiling::Profiler::instance().count("factorizations");
         for (int i = 0; i < n; i++) {
             int maxRow = i;
             for (int k = i + 1; k < n; k++) {
@@ -5756,29 +6326,36 @@ namespace Analyze{
         return z;
     }
 
-    double unitHandler3(string input, string type) {
-        regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-        smatch match;
-        if (regex_match(input, match, pattern)) {
-            double value = stod(match[1]);
-            string unit = match[2].str();
-            double multiplier = 1.0;
-            if (unit == "n") multiplier = 1e-9;
-            else if (unit == "u") multiplier = 1e-6;
-            else if (unit == "m") multiplier = 1e-3;
-            else if (unit == "k") multiplier = 1e3;
-            else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-            else if (unit == "G") multiplier = 1e9;
-            return value * multiplier;
-        } else {
+    // مقدار با پسوند مهندسی (10k، 2.2u، 1Meg)؛ برای ورودی نامعتبر invalidValue
+    double unitHandler3(const string &input, const string &type) {
+        double value;
+        if (!Units::parse(input, value)) {
+            throw invalidValue(type);
+        }
+        return value;
+    }
+    // مقادیر المان (مقاومت، خازن، ...) باید مثبت باشند
+    double unitHandlerPositive(const string &input, const string &type) {
+        double value = unitHandler3(input, type);
+        if (value <= 0) {
+            throw invalidValue(type);
+        }
+        return value;
+    }
+    // زمان‌ها و پارامترهای تحلیل منفی نیستند
+    double unitHandlerNonNegative(const string &input, const string &type) {
+        double value = unitHandler3(input, type);
+        if (value < 0) {
             throw invalidValue(type);
         }
+        return value;
     }
 
     vector<complex<double>> solveLinearSystemComplex(vector<vector<complex<double>>> &A,
                                                      vector<complex<double>> &z) {
         const double EPSILON = 1e-12;
         int n = A.size();
+        Profiling::Profiler::instance().count("factorizations");
 
         for (int i = 0; i < n; i++) {
             // انتخاب Pivot
@@ -5825,6 +6402,7 @@ namespace Analyze{
     vector<double> solveLinearSystem2(vector<vector<double>> A, vector<double> &z) {
         const double EPSILON = 1e-12;
         int n = A.size();
+        Profiling::Profiler::instance().count("factorizations");
 
         for (int i = 0; i < n; i++) {
             int maxRow = i;
@@ -5868,16 +6446,136 @@ namespace Analyze{
     }
 
 ///-------
+    // نام داخل پرانتز سیگنال اندازه‌گیری: out در V(out) یا V(out)(phase)
+    string measureTarget(const string &signal) {
+        size_t open = signal.find('('), close = signal.find(')');
+        return signal.substr(open + 1, close - open - 1);
+    }
+
+    bool isGroundName(const string &name) {
+        auto nodes = Wire::findNodeWhitname(name);
+        return name == "N00" || (!nodes.empty() && nodes[0]->getIsGround());
+    }
+
+    // سیگنال اندازه‌گیری در تحلیل گذرا: V(node) از جواب دستگاه، I و P(element) از مقدار المان بعد از به‌روزرسانی
+    function<double(const vector<double>&)> transientMeasureProbe(const string &signal, const map<string, int> &nodeIndex,
+                                                                  const vector<shared_ptr<Element>> &elements) {
+        string target = measureTarget(signal);
+        if (signal[0] == 'V') {
+            auto it = nodeIndex.find(target);
+            if (it != nodeIndex.end()) {
+                int index = it->second;
+                return [index](const vector<double> &solution) { return solution[index]; };
+            }
+            if (isGroundName(target)) return [](const vector<double> &) { return 0.0; };
+            throw nodeNotFound(target);
+        }
+        for (auto &e : elements) {
+            if (e->getName() != target) continue;
+            if (signal[0] == 'I') return [e](const vector<double> &) { return e->getCurrent(); };
+            return [e](const vector<double> &) { return e->getVoltage() * e->getCurrent(); };
+        }
+        throw elementNotFound2(target);
+    }
+
+    // سیگنال اندازه‌گیری در تحلیل AC: دامنه خطی، یا فاز (رادیان) با پسوند (phase)
+    function<double(const vector<complex<double>>&)> acMeasureProbe(const string &signal, const map<string, int> &nodeIndex,
+                                                                    const map<string, int> &voltageSourceIndex, int n,
+                                                                    const vector<shared_ptr<Element>> &elements) {
+        string target = measureTarget(signal);
+        bool phase = signal.find("(phase)") != string::npos;
+        auto part = [phase](complex<double> v) { return phase ? arg(v) : abs(v); };
+        if (signal[0] == 'V') {
+            auto it = nodeIndex.find(target);
+            if (it != nodeIndex.end()) {
+                int index = it->second;
+                return [index, part](const vector<complex<double>> &solution) { return part(solution[index]); };
+            }
+            if (isGroundName(target)) return [](const vector<complex<double>> &) { return 0.0; };
+            throw nodeNotFound(target);
+        }
+        if (signal[0] == 'I') {
+            auto it = voltageSourceIndex.find(target);
+            if (it != voltageSourceIndex.end()) {
+                int index = n + it->second;
+                return [index, part](const vector<complex<double>> &solution) { return part(solution[index]); };
+            }
+            for (auto &e : elements) {
+                if (e->getName() == target && (dynamic_pointer_cast<Resistor>(e) || dynamic_pointer_cast<Inductor>(e) ||
+                                               dynamic_pointer_cast<Capacitor>(e))) {
+                    return [e, part](const vector<complex<double>> &) { return part(e->AcCurrent); };
+                }
+            }
+            throw elementNotFound2(target);
+        }
+        throw ErrorInput();
+    }
+
+    // سیگنال‌هایی که در data/log.txt ذخیره می‌شوند؛ saveAll یعنی همه نودها و جریان‌ها
+    struct SaveList {
+        bool saveAll = true;
+        set<string> signals;    // مثل V(N01) و I(R1)
+        string logPath = "data/log.txt";    // تحلیل گذرا؛ خالی یعنی هیچ فایلی نوشته نمی‌شود (اجراهای موازی جاروب)
+
+        bool wants(const string &signal) const { return saveAll || signals.count(signal) > 0; }
+    };
+
+    // انتشار نتیجه در حین تحلیل گذرا: هر blockSteps گام نمونه‌های تازه سیگنال‌های ذخیره شده یک بلوک Samples می‌شوند
+    // (و باقی‌مانده در پایان)؛ publish روی رشته حل صدا زده می‌شود و نباید منتظر شبکه بماند. publish خالی یعنی انتشاری نیست
+    struct ResultStream {
+        size_t blockSteps = 256;
+        function<void(const string &block)> publish;
+    };
+
+    // سیگنال‌های لازم برای پروب‌ها: نام‌های داخل عبارت (بدون پسوند AC) و برای P(x) ولتاژ دو سر و جریان x
+    SaveList saveListFromProbes(const string &probeExpressions, const vector<shared_ptr<Element>> &elements) {
+        SaveList save;
+        save.saveAll = false;
+        istringstream in(probeExpressions);
+        string probe;
+        while (getline(in, probe)) {
+            if (probe.size() > 3 && probe[0] == 'P' && probe[1] == '(') {
+                string target = measureTarget(probe);
+                for (auto &e : elements) {
+                    if (e->getName() != target) continue;
+                    save.signals.insert("V(" + e->getNodeP()->getName() + ")");
+                    save.signals.insert("V(" + e->getNodeN()->getName() + ")");
+                    save.signals.insert("I(" + target + ")");
+                }
+                continue;
+            }
+            try {
+                for (string signal : Expressions::compile(probe).signals) {
+                    save.signals.insert(signal.substr(0, signal.find(')') + 1));
+                }
+            }
+            catch (const exception &) {
+                // عبارت نامعتبر در extract_data گزارش می‌شود
+            }
+        }
+        return save;
+    }
+
     string analyzeTransient(double tStart, double tEnd, double step,
                             vector<shared_ptr<Node>>& nodes,
-                            vector<shared_ptr<Element>>& elements) {
-        findError(elements,nodes);
+                            vector<shared_ptr<Element>>& elements,
+                            Measurements::Session *measure = nullptr,
+                            const SaveList *save = nullptr,
+                            const ResultStream *stream = nullptr) {
+        Profiling::ScopedRun profileRun("Transient");
+        {
+            Profiling::ScopedTimer timer("findError");
+            findError(elements,nodes);
+        }
         stringstream ss;
-        ofstream outFile("data/log.txt");
-
-        if (!outFile.is_open()) {
-            cerr << "Unable to open log.txt for writing" << endl;
-            return "Error: Could not open log file";
+        string logPath = save ? save->logPath : "data/log.txt";
+        ofstream outFile;
+        if (!logPath.empty()) {
+            outFile.open(logPath);
+            if (!outFile.is_open()) {
+                cerr << "Unable to open log.txt for writing" << endl;
+                return "Error: Could not open log file";
+            }
         }
 
 // 1. شناسایی نودهای فعال
@@ -5910,20 +6608,72 @@ namespace Analyze{
             nodeIndex[*it] = idx++;
         }
 
+// سیگنال‌های اندازه‌گیری یک بار به جواب دستگاه یا المان نگاشت می‌شوند
+        vector<function<double(const vector<double>&)>> measureProbes;
+        if (measure) {
+            measure->reset();
+            for (const string &signal : measure->signals()) measureProbes.push_back(transientMeasureProbe(signal, nodeIndex, elements));
+        }
+        vector<double> measureValues(measureProbes.size());
+
+// سیگنال‌های ذخیره شده و نودهای هم‌نام هر شبکه (از nodes، نه Wire::allNodes) یک بار پیدا می‌شوند، نه در هر گام
+        map<string, vector<shared_ptr<Node>>> nodesByName;
+        for (auto &node : nodes) nodesByName[node->getName()].push_back(node);
+        map<string, vector<pair<double, double>>> voltageResults;
+        map<string, vector<pair<double, double>>> currentResults;
+        vector<pair<int, vector<pair<double, double>>*>> savedVoltages;
+        vector<pair<shared_ptr<Element>, vector<pair<double, double>>*>> savedCurrents;
+        vector<vector<shared_ptr<Node>>> sameNameNodes(idx);
+        for (map<string, int>::iterator it = nodeIndex.begin(); it != nodeIndex.end(); ++it) {
+            sameNameNodes[it->second] = nodesByName[it->first];
+            string signal = "V(" + it->first + ")";
+            if (!save || save->wants(signal)) savedVoltages.push_back({it->second, &voltageResults[signal]});
+        }
+        for (const auto& elem : elements) {
+            string signal = "I(" + elem->getName() + ")";
+            if (!save || save->wants(signal)) savedCurrents.push_back({elem, &currentResults[signal]});
+        }
+
+// نمونه‌های هر سیگنال از streamed به بعد هنوز منتشر نشده‌اند؛ همه سیگنال‌ها در هر گام یک نمونه می‌گیرند
+        if (stream && !stream->publish) stream = nullptr;
+        size_t streamed = 0, unstreamedSteps = 0;
+        auto publishBlock = [&]() {
+            Profiling::ScopedTimer timer("publish");
+            string block;
+            for (auto &entry : voltageResults) {
+                Samples::append(block, entry.first, entry.second.data() + streamed, entry.second.size() - streamed);
+            }
+            for (auto &entry : currentResults) {
+                Samples::append(block, entry.first, entry.second.data() + streamed, entry.second.size() - streamed);
+            }
+            streamed += unstreamedSteps;
+            unstreamedSteps = 0;
+            stream->publish(block);
+        };
+
 // 3. شمارش منابع ولتاژ و دیودها
         int n = idx;
         vector<shared_ptr<Element>> voltageSourcesAndDiodes;
         vector<shared_ptr<Diode>> diodes;
-
-// ذخیره داده‌های خروجی
-        map<string, vector<pair<double, double>>> voltageResults;
-        map<string, vector<pair<double, double>>> currentResults;
+        // منابع جریانی با هر خروج (از جمله خطا) بسته می‌شوند تا رشته خواننده به طرف مقابل وصل نماند
+        struct OpenFeeds {
+            vector<shared_ptr<StreamVoltageSource>> list;
+            void close() {
+                for (auto &feed : list) feed->close();
+                list.clear();
+            }
+            ~OpenFeeds() { close(); }
+        } feeds;
 
 // مقداردهی اولیه عناصر دینامیک و جداسازی منابع ولتاژ و دیودها
         for (const auto& elem : elements) {
             string type = elem->getType();
             if (type == "VoltageSource" || type == "VCVS" || type == "CCVS") {
                 voltageSourcesAndDiodes.push_back(elem);
+                if (auto feed = dynamic_pointer_cast<StreamVoltageSource>(elem)) {
+                    feeds.list.push_back(feed);
+                    feed->open();
+                }
             } else if (type.rfind("Diode", 0) == 0) { // Check if type starts with "Diode"
                 auto d = dynamic_pointer_cast<Diode>(elem);
                 diodes.push_back(d);
@@ -5949,6 +6699,7 @@ namespace Analyze{
             }
 
             while (!converged && iteration < iterationLimit) {
+                Profiling::ScopedTimer stampTimer("stamp");
 // ماتریس‌های سیستم
                 vector<vector<double>> G(n, vector<double>(n, 0.0));
                 vector<vector<double>> B(n, vector<double>(m, 0.0));
@@ -6074,8 +6825,12 @@ namespace Analyze{
                     for (int j = 0; j < m; j++) A[n + i][n + j] = E[i][j];
                     Z[n + i] = F[i];
                 }
+                stampTimer.stop();
 
-                solution = solveLinearSystem(A, Z);
+                {
+                    Profiling::ScopedTimer timer("solve");
+                    solution = solveLinearSystem(A, Z);
+                }
 
 // 7. بررسی همگرایی دیودها
                 converged = true;
@@ -6108,27 +6863,32 @@ namespace Analyze{
                     if (old_assumption != new_state) {
                         converged = false;
                         d->assumeState(new_state); // Update assumption for next iteration
+                        Profiling::Profiler::instance().count("diode_flips");
                     }
                 }
                 iteration++;
+                Profiling::Profiler::instance().count("newton_iterations");
             } // End of convergence loop
+            Profiling::Profiler::instance().count("steps");
+            if (!converged) {
+                Profiling::Profiler::instance().count("rejected_steps");
+            }
+            Profiling::ScopedTimer nodeUpdateTimer("node_update");
 
 // 8. به‌روزرسانی ولتاژ نودها و وضعیت نهایی عناصر
-            for (map<string, int>::iterator it = nodeIndex.begin(); it != nodeIndex.end(); ++it) {
-                string name = it->first;
-                int index = it->second;
-                double voltage = solution[index];
-
-                auto sameNameNodes = Wire::findNodeWhitname(name);
-                for (size_t i = 0; i < sameNameNodes.size(); i++) {
-                    sameNameNodes[i]->setVoltage(voltage);
+            for (int index = 0; index < n; ++index) {
+                for (auto &node : sameNameNodes[index]) {
+                    node->setVoltage(solution[index]);
                 }
-
-                if (t >= tStart) {
-                    voltageResults["V(" + name + ")"].push_back({t, voltage});
+            }
+            if (t >= tStart) {
+                for (auto &saved : savedVoltages) {
+                    saved.second->push_back({t, solution[saved.first]});
                 }
             }
 
+            nodeUpdateTimer.stop();
+
 // به‌روزرسانی جریان و حالت عناصر
             for (const auto& elem : elements) {
                 double current = 0.0;
@@ -6167,14 +6927,25 @@ namespace Analyze{
 
 // ذخیره جریان‌ها
             if (t >= tStart) {
-                for (const auto& elem : elements) {
-                    currentResults["I(" + elem->getName() + ")"].push_back({t, elem->getCurrent()});
+                for (auto &saved : savedCurrents) {
+                    saved.second->push_back({t, saved.first->getCurrent()});
                 }
             }
 
+            if (!measureProbes.empty() && t >= tStart) {
+                for (size_t i = 0; i < measureProbes.size(); ++i) measureValues[i] = measureProbes[i](solution);
+                measure->feed(t, measureValues);
+            }
+
+            if (stream && t >= tStart && ++unstreamedSteps >= stream->blockSteps) publishBlock();
+
         } // End of time loop
+        if (stream && unstreamedSteps) publishBlock();
+        feeds.close();
 
 // 9. نوشتن نتایج در خروجی
+        if (!outFile.is_open()) return "Tran Good";
+        Profiling::ScopedTimer writeTimer("write_log");
         for (const auto& entry : voltageResults) {
             outFile << entry.first << endl;
             ss << entry.first << endl;
@@ -6192,16 +6963,109 @@ namespace Analyze{
             }
         }
 
+        Profiling::Profiler::instance().count("bytes_written", outFile.tellp());
         outFile.close();
         return "Tran Good";
     }
 
 
-// تابع کمکی برای نوشتن داده‌ها
-    void writeDataToFile(ofstream& outFile, stringstream& ss,
-                         map<string, vector<tuple<double, double>>>& voltageAmplitudes,
-                         map<string, vector<tuple<double, double>>>& voltagePhases,
-                         map<string, vector<tuple<double, double>>>& currentAmplitudes,
+    // نودهای پایانه‌های المان‌ها (و نودهای کنترل منابع وابسته)، هر کدام یک بار
+    vector<shared_ptr<Node>> circuitNodes(const vector<shared_ptr<Element>> &elements) {
+        vector<shared_ptr<Node>> nodes;
+        set<Node*> seen;
+        auto add = [&](const shared_ptr<Node> &node) {
+            if (node && seen.insert(node.get()).second) nodes.push_back(node);
+        };
+        for (auto &e : elements) {
+            add(e->getNodeP());
+            add(e->getNodeN());
+            if (auto vcvs = dynamic_pointer_cast<VCVS>(e)) { add(vcvs->getControlNodeP()); add(vcvs->getControlNodeN()); }
+            else if (auto vccs = dynamic_pointer_cast<VCCS>(e)) { add(vccs->getControlNodeP()); add(vccs->getControlNodeN()); }
+        }
+        return nodes;
+    }
+
+    // مقدار فعلی المان‌های جاروب شده به ترتیب plan.elements()؛ index جای هر کدام در elements
+    vector<double> sweepNominal(const Sweeps::Plan &plan, const vector<shared_ptr<Element>> &elements, vector<int> *index = nullptr) {
+        vector<double> nominal;
+        for (const string &name : plan.elements()) {
+            auto it = find_if(elements.begin(), elements.end(), [&](const shared_ptr<Element> &e) { return e->getName() == name; });
+            if (it == elements.end()) throw elementNotFound2(name);
+            if (index) index->push_back(int(it - elements.begin()));
+            nominal.push_back((*it)->getValue());
+        }
+        return nominal;
+    }
+
+    // هر اجرای جاروب کپی خودش را دارد و منبع جریانی در هر کپی اتصال جدایی به برنامه بیرونی باز می‌کرد
+    void rejectStreamSweep(const vector<shared_ptr<Element>> &elements) {
+        for (auto &e : elements) {
+            if (dynamic_pointer_cast<StreamVoltageSource>(e))
+                throw runtime_error("STREAM source " + e->getName() + " cannot be used in a .step sweep");
+        }
+    }
+
+    // جاروب پارامتر / مونت‌کارلو روی تحلیل گذرا: مدار یک بار با cereal سریالایز می‌شود و هر اجرا
+    // کپی مستقل خودش (المان‌ها و نودها) را می‌سازد، پس اجراها بدون قفل روی Tasks::Pool حل می‌شوند
+    // نتیجه هر اجرا فقط .meas هاست و data/log.txt نوشته نمی‌شود
+    // first و count فقط بخشی از اجراها (یک دسته کارگر در جاروب توزیع شده)؛ نتیجه i اجرای first + i است
+    vector<Sweeps::Run> sweepTransient(const Sweeps::Plan &plan, const Measurements::Session &measures,
+                                       double tStart, double tEnd, double step,
+                                       const vector<shared_ptr<Element>> &elements,
+                                       Tasks::Pool &pool = Tasks::Pool::instance(),
+                                       size_t first = 0, size_t count = (size_t)-1) {
+        Profiling::ScopedRun profileRun("Sweep");
+        rejectStreamSweep(elements);
+        string compiled;
+        {
+            Profiling::ScopedTimer timer("compile");
+            ostringstream os(ios::binary);
+            cereal::BinaryOutputArchive archive(os);
+            archive(elements);
+            compiled = os.str();
+        }
+
+        vector<int> index;
+        vector<double> nominal = sweepNominal(plan, elements, &index);
+
+        first = min(first, plan.size());
+        vector<Sweeps::Run> runs(min(count, plan.size() - first));
+        SaveList noLog;
+        noLog.saveAll = false;
+        noLog.logPath = "";
+        // هر اجرا یک کار؛ رشته بیکار اجراهای باقی‌مانده را از صف دیگران برمی‌دارد
+        Tasks::parallelFor(runs.size(), [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                Sweeps::Run &run = runs[k];
+                run.values = plan.point(first + k, nominal);
+                try {
+                    vector<shared_ptr<Element>> copy;
+                    {
+                        istringstream is(compiled, ios::binary);
+                        cereal::BinaryInputArchive archive(is);
+                        archive(copy);
+                    }
+                    for (size_t p = 0; p < index.size(); ++p) copy[index[p]]->setValue(run.values[p]);
+                    vector<shared_ptr<Node>> nodes = circuitNodes(copy);
+                    Measurements::Session session = measures;
+                    analyzeTransient(tStart, tEnd, step, nodes, copy, &session, &noLog);
+                    run.results = session.results();
+                }
+                catch (const exception &e) {
+                    run.error = e.what();
+                }
+            }
+        }, 1, pool);
+        Profiling::Profiler::instance().count("runs", (long long)runs.size());
+        Profiling::Profiler::instance().count("threads", (long long)pool.concurrency());
+        return runs;
+    }
+
+// تابع کمکی برای نوشتن داده‌ها
+    void writeDataToFile(ofstream& outFile, stringstream& ss,
+                         map<string, vector<tuple<double, double>>>& voltageAmplitudes,
+                         map<string, vector<tuple<double, double>>>& voltagePhases,
+                         map<string, vector<tuple<double, double>>>& currentAmplitudes,
                          map<string, vector<tuple<double, double>>>& currentPhases) {
 
         for (const auto& entry : voltageAmplitudes) {
@@ -6243,10 +7107,15 @@ namespace Analyze{
 
     string analyzeAc(string type, string tStart, string tEnd, string numberOfPoints,
                      int componentId,
-                     vector<shared_ptr<Element>>& elements, vector<shared_ptr<LabelNet>>& labels) {
+                     vector<shared_ptr<Element>>& elements, vector<shared_ptr<LabelNet>>& labels,
+                     Measurements::Session *measure = nullptr) {
 
         if (elements.empty()) return "empty";
-        findError(elements, Wire::allNodes);
+        Profiling::ScopedRun profileRun("AC Sweep");
+        {
+            Profiling::ScopedTimer timer("findError");
+            findError(elements, Wire::allNodes);
+        }
 
         double TStart = 0;
         double TStop = 0;
@@ -6318,6 +7187,14 @@ namespace Analyze{
         }
         int matrixSize = n + m;
 
+        vector<function<double(const vector<complex<double>>&)>> measureProbes;
+        if (measure) {
+            measure->reset();
+            for (const string &signal : measure->signals())
+                measureProbes.push_back(acMeasureProbe(signal, nodeIndex, voltageSourceNameToIndex, n, elements));
+        }
+        vector<double> measureValues(measureProbes.size());
+
         map<string, vector<tuple<double, double>>> voltageAmplitudes;
         map<string, vector<tuple<double, double>>> voltagePhases;
         map<string, vector<tuple<double, double>>> currentAmplitudes;
@@ -6326,237 +7203,274 @@ namespace Analyze{
         int checkForWrite = 0;
         const int WRITE_THRESHOLD = 500;
 
+// نودهای بدون اندیس مثل قبل با operator[] اضافه می‌شوند تا حل موازی فقط از nodeIndex بخواند
+        for (shared_ptr<Element>& e : elements) {
+            for (const shared_ptr<Node> &node : {e->getNodeP(), e->getNodeN()}) {
+                if (node && !node->getIsGround()) nodeIndex[node->getName()];
+            }
+        }
+        vector<double> frequencies;
         for (double frc = TStart; frc <= TStop + 1e-12; frc += Step) {
-            vector<vector<complex<double>>> G(n, vector<complex<double>>(n, 0.0));
-            vector<vector<complex<double>>> B(n, vector<complex<double>>(m, 0.0));
-            vector<vector<complex<double>>> C(m, vector<complex<double>>(n, 0.0));
-            vector<vector<complex<double>>> D(m, vector<complex<double>>(m, 0.0));
-            vector<complex<double>> I(n, 0.0);
-            vector<complex<double>> F(m, 0.0);
+            frequencies.push_back(frc);
+            if (Step <= 0) break;
+        }
+
+// نقطه‌های فرکانس مستقل‌اند: هر دسته WRITE_THRESHOLD تایی روی Tasks::Pool حل و بعد به ترتیب ثبت می‌شود
+        vector<vector<complex<double>>> solutions;
+        for (size_t blockStart = 0; blockStart < frequencies.size(); blockStart += WRITE_THRESHOLD) {
+            size_t blockSize = min<size_t>(WRITE_THRESHOLD, frequencies.size() - blockStart);
+            solutions.assign(blockSize, {});
+            Tasks::parallelFor(blockSize, [&](size_t begin, size_t end) {
+                for (size_t point = begin; point < end; ++point) {
+                    double frc = frequencies[blockStart + point];
+                    Profiling::Profiler::instance().count("points");
+                    Profiling::ScopedTimer stampTimer("stamp");
+                    vector<vector<complex<double>>> G(n, vector<complex<double>>(n, 0.0));
+                    vector<vector<complex<double>>> B(n, vector<complex<double>>(m, 0.0));
+                    vector<vector<complex<double>>> C(m, vector<complex<double>>(n, 0.0));
+                    vector<vector<complex<double>>> D(m, vector<complex<double>>(m, 0.0));
+                    vector<complex<double>> I(n, 0.0);
+                    vector<complex<double>> F(m, 0.0);
+
+                    int vsIndex = 0;
+                    for (shared_ptr<Element>& e : elements) {
+                        string type = e->getType();
+                        shared_ptr<Node> pn = e->getNodeP();
+                        shared_ptr<Node> nn = e->getNodeN();
+                        int pi = (pn && !pn->getIsGround()) ? nodeIndex.at(pn->getName()) : -1;
+                        int ni = (nn && !nn->getIsGround()) ? nodeIndex.at(nn->getName()) : -1;
+
+                        if (type == "Resistor" || type == "Inductor" || type == "Capacitor") {
+                            complex<double> r;
+                            if (type == "Resistor") {
+                                r = e->getValue();
+                            }
+                            if (type == "Inductor") {
+                                r = frc * e->getValue() * complex<double>(0.0, 1.0);
+                            }
+                            if (type == "Capacitor") {
+                                if (frc == 0) r = 1e12;
+                                else r = 1.0 / (frc * e->getValue() * complex<double>(0.0, 1.0));
+                            }
 
-            int vsIndex = 0;
-            for (shared_ptr<Element>& e : elements) {
-                string type = e->getType();
-                shared_ptr<Node> pn = e->getNodeP();
-                shared_ptr<Node> nn = e->getNodeN();
-                int pi = (pn && !pn->getIsGround()) ? nodeIndex[pn->getName()] : -1;
-                int ni = (nn && !nn->getIsGround()) ? nodeIndex[nn->getName()] : -1;
+                            complex<double> g = (abs(r) < 1e-12) ? 1e12 : 1.0 / r;
+                            if (pi != -1) G[pi][pi] += g;
+                            if (ni != -1) G[ni][ni] += g;
+                            if (pi != -1 && ni != -1) {
+                                G[pi][ni] -= g;
+                                G[ni][pi] -= g;
+                            }
+                        }
+                        else if (type == "CurrentSource") {
+                            double prevI = e->getValue();
+                            if (pi != -1) I[pi] -= prevI;
+                            if (ni != -1) I[ni] += prevI;
+                        }
+                        else if (type == "VCCS") {
+                            auto vccs = dynamic_pointer_cast<VCCS>(e);
+                            double g = vccs->getGain();
+                            auto cpn = vccs->getControlNodeP();
+                            auto cnn = vccs->getControlNodeN();
+                            int cpi = (cpn && !cpn->getIsGround()) ? nodeIndex.at(cpn->getName()) : -1;
+                            int cni = (cnn && !cnn->getIsGround()) ? nodeIndex.at(cnn->getName()) : -1;
+
+                            if (pi != -1) {
+                                if (cpi != -1) G[pi][cpi] += g;
+                                if (cni != -1) G[pi][cni] -= g;
+                            }
+                            if (ni != -1) {
+                                if (cpi != -1) G[ni][cpi] -= g;
+                                if (cni != -1) G[ni][cni] += g;
+                            }
+                        }
+                        else if (type == "CCCS") {
+                            auto cccs = dynamic_pointer_cast<CCCS>(e);
+                            double beta = cccs->getGain();
+                            auto ctrlElement = cccs->getControlSourceName();
+                            if (ctrlElement && dynamic_pointer_cast<VoltageSource>(ctrlElement)) {
+                                int ctrlVsIndex = voltageSourceNameToIndex.at(ctrlElement->getName());
+                                if (pi != -1) B[pi][ctrlVsIndex] += beta;
+                                if (ni != -1) B[ni][ctrlVsIndex] -= beta;
+                            }
+                        }
+                        else if (dynamic_pointer_cast<VoltageSource>(e)) {
+                            if (pi != -1) {
+                                B[pi][vsIndex] = 1.0;
+                                C[vsIndex][pi] = 1.0;
+                            }
+                            if (ni != -1) {
+                                B[ni][vsIndex] = -1.0;
+                                C[vsIndex][ni] = -1.0;
+                            }
 
-                if (type == "Resistor" || type == "Inductor" || type == "Capacitor") {
-                    complex<double> r;
-                    if (type == "Resistor") {
-                        r = e->getValue();
-                    }
-                    if (type == "Inductor") {
-                        r = frc * e->getValue() * complex<double>(0.0, 1.0);
-                    }
-                    if (type == "Capacitor") {
-                        if (frc == 0) r = 1e12;
-                        else r = 1.0 / (frc * e->getValue() * complex<double>(0.0, 1.0));
+                            if (type == "VCVS") {
+                                auto vcvs = dynamic_pointer_cast<VCVS>(e);
+                                double mu = vcvs->getGain();
+                                auto cpn = vcvs->getControlNodeP();
+                                auto cnn = vcvs->getControlNodeN();
+                                int cpi = (cpn && !cpn->getIsGround()) ? nodeIndex.at(cpn->getName()) : -1;
+                                int cni = (cnn && !cnn->getIsGround()) ? nodeIndex.at(cnn->getName()) : -1;
+
+                                if (cpi != -1) C[vsIndex][cpi] -= mu;
+                                if (cni != -1) C[vsIndex][cni] += mu;
+                                F[vsIndex] = 0.0;
+                            }
+                            else if (type == "CCVS") {
+                                auto ccvs = dynamic_pointer_cast<CCVS>(e);
+                                double r = ccvs->getGain();
+                                auto ctrlElement = ccvs->getControlSourceName();
+                                if (ctrlElement && dynamic_pointer_cast<VoltageSource>(ctrlElement)) {
+                                    int ctrlVsIndex = voltageSourceNameToIndex.at(ctrlElement->getName());
+                                    D[vsIndex][ctrlVsIndex] = -r;
+                                    F[vsIndex] = 0.0;
+                                }
+                            }
+                            else {
+                                F[vsIndex] = e->AcVoltage;
+                            }
+                            vsIndex++;
+                        }
                     }
 
-                    complex<double> g = (abs(r) < 1e-12) ? 1e12 : 1.0 / r;
-                    if (pi != -1) G[pi][pi] += g;
-                    if (ni != -1) G[ni][ni] += g;
-                    if (pi != -1 && ni != -1) {
-                        G[pi][ni] -= g;
-                        G[ni][pi] -= g;
-                    }
-                }
-                else if (type == "CurrentSource") {
-                    double prevI = e->getValue();
-                    if (pi != -1) I[pi] -= prevI;
-                    if (ni != -1) I[ni] += prevI;
-                }
-                else if (type == "VCCS") {
-                    auto vccs = dynamic_pointer_cast<VCCS>(e);
-                    double g = vccs->getGain();
-                    auto cpn = vccs->getControlNodeP();
-                    auto cnn = vccs->getControlNodeN();
-                    int cpi = (cpn && !cpn->getIsGround()) ? nodeIndex.at(cpn->getName()) : -1;
-                    int cni = (cnn && !cnn->getIsGround()) ? nodeIndex.at(cnn->getName()) : -1;
+// ساخت ماتریس A و بردار Z
+                    vector<vector<complex<double>>> A(matrixSize, vector<complex<double>>(matrixSize, 0.0));
+                    vector<complex<double>> Z(matrixSize, 0.0);
 
-                    if (pi != -1) {
-                        if (cpi != -1) G[pi][cpi] += g;
-                        if (cni != -1) G[pi][cni] -= g;
-                    }
-                    if (ni != -1) {
-                        if (cpi != -1) G[ni][cpi] -= g;
-                        if (cni != -1) G[ni][cni] += g;
-                    }
-                }
-                else if (type == "CCCS") {
-                    auto cccs = dynamic_pointer_cast<CCCS>(e);
-                    double beta = cccs->getGain();
-                    auto ctrlElement = cccs->getControlSourceName();
-                    if (ctrlElement && dynamic_pointer_cast<VoltageSource>(ctrlElement)) {
-                        int ctrlVsIndex = voltageSourceNameToIndex.at(ctrlElement->getName());
-                        if (pi != -1) B[pi][ctrlVsIndex] += beta;
-                        if (ni != -1) B[ni][ctrlVsIndex] -= beta;
-                    }
-                }
-                else if (dynamic_pointer_cast<VoltageSource>(e)) {
-                    if (pi != -1) {
-                        B[pi][vsIndex] = 1.0;
-                        C[vsIndex][pi] = 1.0;
+                    for (int i = 0; i < n; i++) {
+                        for (int j = 0; j < n; j++) A[i][j] = G[i][j];
+                        for (int j = 0; j < m; j++) A[i][n + j] = B[i][j];
+                        Z[i] = I[i];
                     }
-                    if (ni != -1) {
-                        B[ni][vsIndex] = -1.0;
-                        C[vsIndex][ni] = -1.0;
+                    for (int i = 0; i < m; i++) {
+                        for (int j = 0; j < n; j++) A[n + i][j] = C[i][j];
+                        for (int j = 0; j < m; j++) A[n + i][n + j] = D[i][j];
+                        Z[n + i] = F[i];
                     }
 
-                    if (type == "VCVS") {
-                        auto vcvs = dynamic_pointer_cast<VCVS>(e);
-                        double mu = vcvs->getGain();
-                        auto cpn = vcvs->getControlNodeP();
-                        auto cnn = vcvs->getControlNodeN();
-                        int cpi = (cpn && !cpn->getIsGround()) ? nodeIndex.at(cpn->getName()) : -1;
-                        int cni = (cnn && !cnn->getIsGround()) ? nodeIndex.at(cnn->getName()) : -1;
-
-                        if (cpi != -1) C[vsIndex][cpi] -= mu;
-                        if (cni != -1) C[vsIndex][cni] += mu;
-                        F[vsIndex] = 0.0;
-                    }
-                    else if (type == "CCVS") {
-                        auto ccvs = dynamic_pointer_cast<CCVS>(e);
-                        double r = ccvs->getGain();
-                        auto ctrlElement = ccvs->getControlSourceName();
-                        if (ctrlElement && dynamic_pointer_cast<VoltageSource>(ctrlElement)) {
-                            int ctrlVsIndex = voltageSourceNameToIndex.at(ctrlElement->getName());
-                            D[vsIndex][ctrlVsIndex] = -r;
-                            F[vsIndex] = 0.0;
-                        }
-                    }
-                    else {
-                        F[vsIndex] = e->AcVoltage;
-                    }
-                    vsIndex++;
+                    stampTimer.stop();
+                    Profiling::ScopedTimer solveTimer("solve");
+                    solutions[point] = solveLinearSystemComplex(A, Z);
                 }
-            }
-
-// ساخت ماتریس A و بردار Z
-            vector<vector<complex<double>>> A(matrixSize, vector<complex<double>>(matrixSize, 0.0));
-            vector<complex<double>> Z(matrixSize, 0.0);
-
-            for (int i = 0; i < n; i++) {
-                for (int j = 0; j < n; j++) A[i][j] = G[i][j];
-                for (int j = 0; j < m; j++) A[i][n + j] = B[i][j];
-                Z[i] = I[i];
-            }
-            for (int i = 0; i < m; i++) {
-                for (int j = 0; j < n; j++) A[n + i][j] = C[i][j];
-                for (int j = 0; j < m; j++) A[n + i][n + j] = D[i][j];
-                Z[n + i] = F[i];
-            }
-
-            vector<complex<double>> solution = solveLinearSystemComplex(A, Z);
+            });
 
+            for (size_t point = 0; point < blockSize; ++point) {
+                double frc = frequencies[blockStart + point];
+                const vector<complex<double>> &solution = solutions[point];
 // استخراج نتایج
-            for (shared_ptr<Node>& node : Wire::allNodes) {
-                if (!node) continue;
+                for (shared_ptr<Node>& node : Wire::allNodes) {
+                    if (!node) continue;
 
-                auto it = nodeIndex.find(node->getName());
-                if (it != nodeIndex.end()) {
-                    int nodeIdx = it->second;
+                    auto it = nodeIndex.find(node->getName());
+                    if (it != nodeIndex.end()) {
+                        int nodeIdx = it->second;
 
-                    if (node->getIsGround()) {
-                        node->AcVoltage = {0.0, 0.0};
-                    }
-                    else if (nodeIdx >= 0 && nodeIdx < solution.size()) {
-                        node->AcVoltage = solution[nodeIdx];
-                        if (type == "dec") {
-                            voltageAmplitudes["V(" + node->name + ")(amplitude)"].push_back(
-                                    make_tuple(frc, abs(solution[nodeIdx]))
-                            );
+                        if (node->getIsGround()) {
+                            node->AcVoltage = {0.0, 0.0};
                         }
-                        if (type == "log") {
-                            voltageAmplitudes["V(" + node->name + ")(amplitude)"].push_back(
-                                    make_tuple(frc, 20 * log10(abs(solution[nodeIdx])))
+                        else if (nodeIdx >= 0 && nodeIdx < solution.size()) {
+                            node->AcVoltage = solution[nodeIdx];
+                            if (type == "dec") {
+                                voltageAmplitudes["V(" + node->name + ")(amplitude)"].push_back(
+                                        make_tuple(frc, abs(solution[nodeIdx]))
+                                );
+                            }
+                            if (type == "log") {
+                                voltageAmplitudes["V(" + node->name + ")(amplitude)"].push_back(
+                                        make_tuple(frc, 20 * log10(abs(solution[nodeIdx])))
+                                );
+                            }
+
+                            voltagePhases["V(" + node->name + ")(phase)"].push_back(
+                                    make_tuple(frc, arg(solution[nodeIdx]))
                             );
                         }
+                        else {
+                            node->AcVoltage = {0.0, 0.0};
+                        }
+                    }
+                }
 
-                        voltagePhases["V(" + node->name + ")(phase)"].push_back(
-                                make_tuple(frc, arg(solution[nodeIdx]))
+                for (int i = 0; i < m; i++) {
+                    voltageSources[i]->AcCurrent = (solution[n + i]);
+
+                    if (type == "dec") {
+                        currentAmplitudes["I(" + voltageSources[i]->getName() + ")(amplitude)"].push_back(
+                                make_tuple(frc, abs(solution[n + i]))
                         );
                     }
-                    else {
-                        node->AcVoltage = {0.0, 0.0};
+                    if (type == "log") {
+                        currentAmplitudes["I(" + voltageSources[i]->getName() + ")(amplitude)"].push_back(
+                                make_tuple(frc, 20 * log10(abs(solution[n + i])))
+                        );
                     }
-                }
-            }
-
-            for (int i = 0; i < m; i++) {
-                voltageSources[i]->AcCurrent = (solution[n + i]);
 
-                if (type == "dec") {
-                    currentAmplitudes["I(" + voltageSources[i]->getName() + ")(amplitude)"].push_back(
-                            make_tuple(frc, abs(solution[n + i]))
-                    );
-                }
-                if (type == "log") {
-                    currentAmplitudes["I(" + voltageSources[i]->getName() + ")(amplitude)"].push_back(
-                            make_tuple(frc, 20 * log10(abs(solution[n + i])))
+                    currentPhases["I(" + voltageSources[i]->getName() + ")(phase)"].push_back(
+                            make_tuple(frc, arg(solution[n + i]))
                     );
                 }
 
-                currentPhases["I(" + voltageSources[i]->getName() + ")(phase)"].push_back(
-                        make_tuple(frc, arg(solution[n + i]))
-                );
-            }
+                for (shared_ptr<Element>& e : elements) {
+                    e->AcVoltage = e->getNodeP()->AcVoltage - e->getNodeN()->AcVoltage;
 
-            for (shared_ptr<Element>& e : elements) {
-                e->AcVoltage = e->getNodeP()->AcVoltage - e->getNodeN()->AcVoltage;
+                    if (e->getType() == "Resistor") {
+                        e->AcCurrent = (e->getValue() == 0) ? e->AcVoltage * 1e12 : e->AcVoltage / e->getValue();
+                    }
+                    if (e->getType() == "Inductor") {
+                        if (frc == 0 || e->getValue() == 0) e->AcCurrent = {0.0, 0.0};
+                        else e->AcCurrent = e->AcVoltage / (frc * e->getValue() * complex<double>(0.0, 1.0));
+                    }
+                    if (e->getType() == "Capacitor") {
+                        e->AcCurrent = e->AcVoltage * (frc * e->getValue() * complex<double>(0.0, 1.0));
+                    }
 
-                if (e->getType() == "Resistor") {
-                    e->AcCurrent = (e->getValue() == 0) ? e->AcVoltage * 1e12 : e->AcVoltage / e->getValue();
-                }
-                if (e->getType() == "Inductor") {
-                    if (frc == 0 || e->getValue() == 0) e->AcCurrent = {0.0, 0.0};
-                    else e->AcCurrent = e->AcVoltage / (frc * e->getValue() * complex<double>(0.0, 1.0));
-                }
-                if (e->getType() == "Capacitor") {
-                    e->AcCurrent = e->AcVoltage * (frc * e->getValue() * complex<double>(0.0, 1.0));
-                }
+                    if (dynamic_pointer_cast<Resistor>(e) || dynamic_pointer_cast<Inductor>(e) || dynamic_pointer_cast<Capacitor>(e)) {
+                        if (type == "dec") {
+                            currentAmplitudes["I(" + e->getName() + ")(amplitude)"].push_back(
+                                    make_tuple(frc, abs(e->AcCurrent))
+                            );
+                        }
+                        if (type == "log") {
+                            currentAmplitudes["I(" + e->getName() + ")(amplitude)"].push_back(
+                                    make_tuple(frc, 20 * log10(abs(e->AcCurrent)))
+                            );
+                        }
 
-                if (dynamic_pointer_cast<Resistor>(e) || dynamic_pointer_cast<Inductor>(e) || dynamic_pointer_cast<Capacitor>(e)) {
-                    if (type == "dec") {
-                        currentAmplitudes["I(" + e->getName() + ")(amplitude)"].push_back(
-                                make_tuple(frc, abs(e->AcCurrent))
-                        );
-                    }
-                    if (type == "log") {
-                        currentAmplitudes["I(" + e->getName() + ")(amplitude)"].push_back(
-                                make_tuple(frc, 20 * log10(abs(e->AcCurrent)))
+                        currentPhases["I(" + e->getName() + ")(phase)"].push_back(
+                                make_tuple(frc, arg(e->AcCurrent))
                         );
                     }
+                }
 
-                    currentPhases["I(" + e->getName() + ")(phase)"].push_back(
-                            make_tuple(frc, arg(e->AcCurrent))
-                    );
+                if (!measureProbes.empty()) {
+                    for (size_t i = 0; i < measureProbes.size(); ++i) measureValues[i] = measureProbes[i](solution);
+                    measure->feed(frc, measureValues);
                 }
-            }
 
-            checkForWrite++;
-            if (checkForWrite >= WRITE_THRESHOLD) {
+                checkForWrite++;
+                if (checkForWrite >= WRITE_THRESHOLD) {
 // نوشتن داده‌ها در فایل
-                writeDataToFile(outFile, ss, voltageAmplitudes, voltagePhases, currentAmplitudes, currentPhases);
+                    Profiling::ScopedTimer writeTimer("write_log");
+                    writeDataToFile(outFile, ss, voltageAmplitudes, voltagePhases, currentAmplitudes, currentPhases);
 
 // پاک کردن مپ‌ها
-                voltageAmplitudes.clear();
-                voltagePhases.clear();
-                currentAmplitudes.clear();
-                currentPhases.clear();
+                    voltageAmplitudes.clear();
+                    voltagePhases.clear();
+                    currentAmplitudes.clear();
+                    currentPhases.clear();
 
-                checkForWrite = 0;
-                outFile.flush();
+                    checkForWrite = 0;
+                    outFile.flush();
+                }
             }
         }
 
 // نوشتن داده‌های باقیمانده
         if (!voltageAmplitudes.empty() || !currentAmplitudes.empty()) {
+            Profiling::ScopedTimer writeTimer("write_log");
             writeDataToFile(outFile, ss, voltageAmplitudes, voltagePhases, currentAmplitudes, currentPhases);
         }
 
+        Profiling::Profiler::instance().count("bytes_written", outFile.tellp());
         outFile.close();
         return "ok";
     }
@@ -6566,7 +7480,11 @@ namespace Analyze{
                         int componentId, string Bfrc,
                         vector<shared_ptr<Element>>& elements,vector<shared_ptr<LabelNet>>&labels) {
         if(elements.empty())return "empty";
-        findError(elements, Wire::allNodes);
+        Profiling::ScopedRun profileRun("Phase Sweep");
+        {
+            Profiling::ScopedTimer timer("findError");
+            findError(elements, Wire::allNodes);
+        }
         double TStart = 0;
         double TStop = 0;
         double Step = 0;
@@ -6642,6 +7560,8 @@ namespace Analyze{
         map<string, vector<tuple<double, double>>> currentPhases;
 
         for (double phase = TStart; phase <= TStop + 1e-12; phase += Step) {
+            Profiling::Profiler::instance().count("points");
+            Profiling::ScopedTimer stampTimer("stamp");
             vector<vector<complex<double>>> G(n, vector<complex<double>>(n, 0.0));
             vector<vector<complex<double>>> B(n, vector<complex<double>>(m, 0.0));
             vector<vector<complex<double>>> C(m, vector<complex<double>>(n, 0.0));
@@ -6765,7 +7685,10 @@ namespace Analyze{
                 Z[n + i] = F[i];
             }
 
+            stampTimer.stop();
+            Profiling::ScopedTimer solveTimer("solve");
             vector<complex<double>> solution = solveLinearSystemComplex(A, Z);
+            solveTimer.stop();
 
 // ذخیره نتایج ولتاژ گره‌ها
             for (shared_ptr<Node>& node : Wire::allNodes) {
@@ -6828,6 +7751,7 @@ namespace Analyze{
         }
 
 // نوشتن نتایج در فایل و رشته خروجی
+        Profiling::ScopedTimer writeTimer("write_log");
 // Write voltage amplitudes
         for (const auto& entry : voltageAmplitudes) {
             outFile << entry.first << endl;
@@ -6868,6 +7792,7 @@ namespace Analyze{
             }
         }
 
+        Profiling::Profiler::instance().count("bytes_written", outFile.tellp());
         return "ok";
     }
 
@@ -6899,6 +7824,7 @@ namespace Analyze{
     }
 
     string op(int componentId, vector<shared_ptr<Element>>&elements,vector<shared_ptr<LabelNet>>&labels) {
+        Profiling::ScopedTimer stampTimer("stamp");
 
         map<string, int> nodeIndex;
         int idx = 0;
@@ -7061,7 +7987,11 @@ namespace Analyze{
             for (int j = 0; j < m; j++) A[n + i][n + j] = D[i][j];
             Z[n + i] = F[i];
         }
+        stampTimer.stop();
+        Profiling::ScopedTimer solveTimer("solve");
         vector<double> solution = solveLinearSystem2(A, Z);
+        solveTimer.stop();
+        Profiling::ScopedTimer nodeUpdateTimer("node_update");
         for (shared_ptr<Node>& node : Wire::allNodes) {
             if (!node) continue;
 
@@ -7081,6 +8011,8 @@ namespace Analyze{
             }
         }
 
+        nodeUpdateTimer.stop();
+
         size_t current_solution_idx = n;
 
         for (auto &vs: voltageSources) {
@@ -7121,7 +8053,11 @@ namespace Analyze{
         int numDiodes = count_if(elements.begin(), elements.end(),
                                  [](auto e) { return e->getType() == "DiodeD" || e->getType() == "DiodeZ"; });
 
-        findError(elements, Wire::allNodes);
+        Profiling::ScopedRun profileRun("OP");
+        {
+            Profiling::ScopedTimer timer("findError");
+            findError(elements, Wire::allNodes);
+        }
 
         ofstream outFile("data/log.txt");
 
@@ -7132,6 +8068,7 @@ namespace Analyze{
 
         int totalStates = 1 << numDiodes;
         for (int state = 0; state < totalStates; ++state) {
+            Profiling::Profiler::instance().count("diode_states");
             int bit = 0;
             for (auto &e: elements) {
                 if (e->getType() == "DiodeD" || e->getType() == "DiodeZ") {
@@ -7146,6 +8083,7 @@ namespace Analyze{
             string data= op(componentId, elements,labels);
             if (Truestate(elements)) {
                 outFile<<data;
+                Profiling::Profiler::instance().count("bytes_written", data.size());
                 opBox.setMessage(data);
                 opBox.setTitle(".OP!");
                 opBox.show();
@@ -7158,8 +8096,13 @@ namespace Analyze{
         return "No valid diode state found.";
     }
 
-    string DCSweep(int componentId, vector<shared_ptr<Element>>& elements, string SourceName, string tStart, string tEnd, string step,vector<shared_ptr<LabelNet>>&labels) {
-        findError(elements, Wire::allNodes);
+    string DCSweep(int componentId, vector<shared_ptr<Element>>& elements, string SourceName, string tStart, string tEnd, string step,vector<shared_ptr<LabelNet>>&labels,
+                   const SaveList *save = nullptr) {
+        Profiling::ScopedRun profileRun("DC Sweep");
+        {
+            Profiling::ScopedTimer timer("findError");
+            findError(elements, Wire::allNodes);
+        }
 
         ofstream outFile("data/log.txt");
         if (!outFile.is_open()) {
@@ -7188,12 +8131,28 @@ namespace Analyze{
         int numDiodes = count_if(elements.begin(), elements.end(),
                                  [](auto e) { return e->getType() == "DiodeD" || e->getType() == "DiodeZ"; });
 
-// ذخیره داده‌های خروجی به فرمت مشابه transient
+// ذخیره داده‌های خروجی به فرمت مشابه transient؛ هر شبکه یک بار (اولین نود هم‌نام)
         map<string, vector<pair<double, double>>> voltageResults;
         map<string, vector<pair<double, double>>> currentResults;
+        vector<pair<shared_ptr<Node>, vector<pair<double, double>>*>> savedVoltages;
+        vector<pair<shared_ptr<Element>, vector<pair<double, double>>*>> savedCurrents;
+        for (shared_ptr<Node>& node : Wire::allNodes) {
+            string signal = "V(" + node->getName() + ")";
+            if (node->getIsGround() || voltageResults.count(signal) || (save && !save->wants(signal))) continue;
+            savedVoltages.push_back({node, &voltageResults[signal]});
+        }
+        for (auto &elem : elements) {
+            string signal = "I(" + elem->getName() + ")";
+            if (!save || save->wants(signal)) savedCurrents.push_back({elem, &currentResults[signal]});
+        }
+        auto savePoint = [&](double t) {
+            for (auto &saved : savedVoltages) saved.second->push_back({t, saved.first->getVoltage()});
+            for (auto &saved : savedCurrents) saved.second->push_back({t, saved.first->getCurrent()});
+        };
 
         if (numDiodes != 0) {
             for (double t = TStart; t <= TStop + 1e-12; t += Step) {
+                Profiling::Profiler::instance().count("points");
                 E->setValue(t);
                 if (t == 0) {
                     E->setValue(t + 1e-12);
@@ -7201,6 +8160,7 @@ namespace Analyze{
 
                 int totalStates = 1 << numDiodes;
                 for (int state = 0; state < totalStates; ++state) {
+                    Profiling::Profiler::instance().count("diode_states");
                     int bit = 0;
                     for (auto &e : elements) {
                         if (e->getType() == "DiodeD" || e->getType() == "DiodeZ") {
@@ -7215,20 +8175,7 @@ namespace Analyze{
 
                     string data = op(componentId, elements,labels);
                     if (Truestate(elements)) {
-// ذخیره نتایج ولتاژ
-                        for (shared_ptr<Node>& node : Wire::allNodes) {
-                            if (!node->getIsGround()) {
-                                string nodeName = "V(" + node->getName() + ")";
-                                voltageResults[nodeName].push_back({t, node->getVoltage()});
-                            }
-                        }
-
-// ذخیره نتایج جریان
-                        for (auto &elem : elements) {
-                            string elemName = "I(" + elem->getName() + ")";
-                            currentResults[elemName].push_back({t, elem->getCurrent()});
-                        }
-
+                        savePoint(t);
                         break; // حالت صحیح پیدا شد
                     }
                 }
@@ -7236,30 +8183,19 @@ namespace Analyze{
         }
         else {
             for (double t = TStart; t <= TStop + 1e-12; t += Step) {
+                Profiling::Profiler::instance().count("points");
                 E->setValue(t);
                 if (t == 0) {
                     E->setValue(t + 1e-12);
                 }
 
                 string data = op(componentId, elements,labels);
-
-// ذخیره نتایج ولتاژ
-                for (shared_ptr<Node>& node : Wire::allNodes) {
-                    if (!node->getIsGround()) {
-                        string nodeName = "V(" + node->getName() + ")";
-                        voltageResults[nodeName].push_back({t, node->getVoltage()});
-                    }
-                }
-
-// ذخیره نتایج جریان
-                for (auto &elem : elements) {
-                    string elemName = "I(" + elem->getName() + ")";
-                    currentResults[elemName].push_back({t, elem->getCurrent()});
-                }
+                savePoint(t);
             }
         }
 
 // نوشتن نتایج در فایل به فرمت مشابه transient
+        Profiling::ScopedTimer writeTimer("write_log");
         for (const auto& entry : voltageResults) {
             outFile << entry.first << endl;
             for (const auto& point : entry.second) {
@@ -7274,6 +8210,7 @@ namespace Analyze{
             }
         }
 
+        Profiling::Profiler::instance().count("bytes_written", outFile.tellp());
         outFile.close();
         return "DCSweep ok";
     }
@@ -7283,117 +8220,302 @@ using namespace Analyze;
 
 //////---------------------------------------
 namespace Network{
-    class TCPServer {
-    public:
-        TCPServer(int port) {
-            WSADATA wsaData;
-            WSAStartup(MAKEWORD(2,2), &wsaData);
+    enum MessageType : uint8_t {
+        VoltageSourceMessage = 1,
+        CircuitMessage,         // snapshot مدار: نسخه (u64) + آرشیو
+        AnalyzeMessage,
+        SubscribeMessage,       // کلاینت: snapshot فعلی و بعد هر تغییر
+        DeltaMessage,           // نسخه (u64) + Editing::encode تغییرات یک فریم
+        JobMessage,             // به کارگر شبیه‌سازی: شماره کار (u64) + نت‌لیست با کارت تحلیل
+        ResultMessage,          // از کارگر: شماره کار + تکه بعدی فایل نتیجه
+        JobDoneMessage,         // از کارگر: شماره کار + وضعیت (u8، صفر یعنی موفق) + خلاصه .meas/جاروب یا پیام خطا
+        SweepMessage,           // به کارگر: شماره دسته (u64) + اولین اجرا (u64) + تعداد اجرا (u64) + نت‌لیست با .step
+        RunsMessage,            // از کارگر: شماره دسته + Sweeps::encode نتیجه اجراهای دسته
+        ResultSubscribeMessage, // کلاینت: نتیجه‌های گذرای سرور در حین اجرا
+        ResultBlockMessage,     // شماره اجرا (u64) + بلوک Samples نمونه‌های تازه
+        ResultEndMessage        // شماره اجرا + وضعیت (u8) + کل data/log.txt برای مشترک عقب‌افتاده (یا خالی) یا پیام خطا
+    };
 
-            ServerSocket = socket(AF_INET, SOCK_STREAM, 0);
+    // نسخه در ۸ بایت اول (little-endian)؛ stamp برای محتوایی که جای نسخه را از قبل دارد (بدون کپی)
+    inline void stamp(uint64_t version, std::string &payload) {
+        for (int i = 0; i < 8; ++i) payload[i] = (char)((version >> (8 * i)) & 0xff);
+    }
 
-            sockaddr_in serverAddr{};
-            serverAddr.sin_family = AF_INET;
-            serverAddr.sin_port = htons(port);
-            serverAddr.sin_addr.s_addr = INADDR_ANY;
+    inline std::string versioned(uint64_t version, const std::string &data) {
+        std::string out;
+        out.reserve(8 + data.size());
+        out.resize(8);
+        stamp(version, out);
+        return out += data;
+    }
 
-            bind(ServerSocket, (sockaddr*)&serverAddr, sizeof(serverAddr));
-            listen(ServerSocket, SOMAXCONN);
-        }
+    inline uint64_t versionOf(const std::string &payload) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0 && payload.size() >= 8; --i) v = (v << 8) | (unsigned char)payload[i];
+        return v;
+    }
 
-        void acceptClient() {
-            sockaddr_in clientAddr{};
-            int clientSize = sizeof(clientAddr);
-            clientSocket = accept(ServerSocket, (sockaddr*)&clientAddr, &clientSize);
-            std::cout << "Client connected!\n";
+    // سرور همکاری ماندگار روی PORT: آخرین منبع، مدار و تنظیمات تحلیل منتشر شده را نگه می‌دارد
+    // و به هر کلاینتی که همان نوع پیام را با محتوای خالی بفرستد می‌دهد (خالی یعنی هنوز منتشر نشده)
+    // مدار زنده: هر تغییر با نسخه بعدی به مشترک‌ها فرستاده می‌شود و مشترک تازه snapshot و تغییرات بعد از آن را می‌گیرد
+    class CollabServer {
+    public:
+        static CollabServer &instance() {
+            static CollabServer server;
+            return server;
         }
 
-        void sendMessage(const std::string& msg) {
-            send(clientSocket, msg.c_str(), msg.size(), 0); // اصلاح شده: ارسال به clientSocket
-        }
+        // رشته حلقه handler های قطع اتصال را صدا می‌زند؛ قبل از از بین رفتن فهرست مشترک‌ها متوقف می‌شود
+        ~CollabServer() { server.stop(); }
 
-        void receiveMessage() {
-            char buffer[1024] = {};
-            recv(clientSocket, buffer, sizeof(buffer), 0); // اصلاح شده: دریافت از clientSocket
-            std::cout << "Received from client: " << buffer << "\n";
+        // اولین انتشار سرور را راه می‌اندازد
+        bool publish(MessageType type, std::string payload) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                published[type] = server.prepare(std::make_shared<const std::string>(std::move(payload)));
+            }
+            return ensureRunning();
         }
 
-        ~TCPServer() {
-            closesocket(clientSocket);
-            closesocket(ServerSocket);
-            WSACleanup();
+        // snapshot جدید جای تغییرات قبلی را می‌گیرد؛ ۸ بایت اول payload جای نسخه است (circuitArchive با headroom)
+        bool publishSnapshot(std::string framed) {
+            // بدون headroom، stamp خود آرشیو را بازنویسی می‌کند (یا بیرون از رشته می‌نویسد)
+            if (framed.size() < 8) throw std::invalid_argument("publishSnapshot: payload has no version headroom");
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stamp(++version, framed);
+                Net::PacketPtr payload = server.prepare(std::make_shared<const std::string>(std::move(framed)));
+                deltas.clear();
+                for (Net::ClientId client : subscribers) server.send(client, CircuitMessage, payload);
+                published[CircuitMessage] = payload;
+            }
+            return ensureRunning();
         }
 
-    public:
-        SOCKET ServerSocket;
-        SOCKET clientSocket;
-    };
-
-    class TCPClient {
-    public:
-        TCPClient(const std::string& ip, int port) {
-            WSADATA wsaData;
-            WSAStartup(MAKEWORD(2, 2), &wsaData);
+        void publishDelta(const std::string &edits) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Net::PacketPtr payload = server.prepare(std::make_shared<const std::string>(versioned(++version, edits)));
+            for (Net::ClientId client : subscribers) server.send(client, DeltaMessage, payload);
+            deltas.push_back(payload);
+        }
 
-            clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+        size_t deltasSinceSnapshot() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return deltas.size();
+        }
 
-            sockaddr_in serverAddr{};
-            serverAddr.sin_family = AF_INET;
-            serverAddr.sin_port = htons(port);
-            serverAddr.sin_addr.s_addr = inet_addr(ip.c_str());
+        // سرور را برای مشترک‌های نتیجه باز می‌کند
+        bool shareResults() { return ensureRunning(); }
 
-            connect(clientSocket, (sockaddr*)&serverAddr, sizeof(serverAddr));
+        // اجرای تازه؛ publish خالی اگر مشترک نتیجه‌ای نیست
+        Analyze::ResultStream beginResults() {
+            Analyze::ResultStream stream;
+            std::lock_guard<std::mutex> lock(mtx);
+            ++resultRun;
+            for (auto &subscriber : resultSubscribers) subscriber.second = false;
+            if (!resultSubscribers.empty()) stream.publish = [this](const std::string &block) { publishResults(block); };
+            return stream;
         }
 
-        void sendMessage(const std::string& msg) {
-            send(clientSocket, msg.c_str(), msg.size(), 0);
+        // روی رشته حل: مشترکی که بیش از resultBacklog بایت عقب است بقیه بلوک‌های این اجرا را نمی‌گیرد
+        void publishResults(const std::string &block) {
+            std::lock_guard<std::mutex> lock(mtx);
+            Net::PacketPtr payload;
+            for (auto &subscriber : resultSubscribers) {
+                if (subscriber.second) continue;
+                if (!payload) payload = server.prepare(std::make_shared<const std::string>(versioned(resultRun, block)));
+                if (!server.trySend(subscriber.first, ResultBlockMessage, payload, resultBacklog)) subscriber.second = true;
+            }
         }
 
-        string receiveMessage() {
-            char buffer[1024] = {};
-            recv(clientSocket, buffer, sizeof(buffer), 0);
-            std::cout << "Received from server: " << buffer << "\n";
-            return buffer;
+        // مشترک‌های عقب‌افتاده کل فایل نتیجه را می‌گیرند و بقیه فقط پایان اجرا را؛ error غیرخالی یعنی اجرا شکست خورد
+        void endResults(const std::string &logPath, const std::string &error = "") {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (resultSubscribers.empty()) return;
+            std::string status(1, (char)(error.empty() ? 0 : 1));
+            Net::PacketPtr done = server.prepare(std::make_shared<const std::string>(versioned(resultRun, status + error)));
+            Net::PacketPtr full;
+            for (auto &subscriber : resultSubscribers) {
+                if (!subscriber.second || !error.empty()) {
+                    server.send(subscriber.first, ResultEndMessage, done);
+                    continue;
+                }
+                if (!full) {
+                    std::ifstream in(logPath, std::ios::binary);
+                    std::string log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                    full = server.prepare(std::make_shared<const std::string>(versioned(resultRun, status + log)));
+                }
+                server.send(subscriber.first, ResultEndMessage, full);
+            }
         }
 
-        ~TCPClient() {
-            closesocket(clientSocket);
-            WSACleanup();
+        size_t clientCount() const { return server.clientCount(); }
+
+    private:
+        Net::Server server;
+        std::mutex mtx;
+        std::map<uint8_t, Net::PacketPtr> published;   // هر نسخه یک بار در حافظه (و یک بار فشرده)، برای همه کلاینت‌ها
+        uint64_t version = 0;
+        std::vector<Net::PacketPtr> deltas;     // بعد از آخرین snapshot
+        std::set<Net::ClientId> subscribers;
+        // true یعنی از اجرای فعلی عقب افتاده (یا وسط آن آمده) و در پایان کل نتیجه را می‌گیرد
+        std::map<Net::ClientId, bool> resultSubscribers;
+        uint64_t resultRun = 0;
+        static const size_t resultBacklog = 4 << 20;
+
+        CollabServer() {
+            for (uint8_t type : {VoltageSourceMessage, CircuitMessage, AnalyzeMessage}) {
+                server.on(type, [this, type](Net::ClientId client, Net::Message &) {
+                    Net::PacketPtr payload;
+                    {
+                        std::lock_guard<std::mutex> lock(mtx);
+                        auto it = published.find(type);
+                        if (it != published.end()) payload = it->second;
+                    }
+                    if (payload) server.send(client, type, payload);
+                    else server.send(client, type, std::string());
+                });
+            }
+            server.on(SubscribeMessage, [this](Net::ClientId client, Net::Message &) {
+                std::lock_guard<std::mutex> lock(mtx);
+                subscribers.insert(client);
+                auto it = published.find(CircuitMessage);
+                if (it == published.end()) return;
+                server.send(client, CircuitMessage, it->second);
+                for (auto &delta : deltas) server.send(client, DeltaMessage, delta);
+            });
+            server.on(ResultSubscribeMessage, [this](Net::ClientId client, Net::Message &) {
+                std::lock_guard<std::mutex> lock(mtx);
+                resultSubscribers[client] = true;
+            });
+            server.onConnect([](Net::ClientId client) { std::cout << "Server: client " << client << " connected\n"; });
+            server.onDisconnect([this](Net::ClientId client) {
+                std::lock_guard<std::mutex> lock(mtx);
+                subscribers.erase(client);
+                resultSubscribers.erase(client);
+            });
+        }
+
+        bool ensureRunning() {
+            if (server.running()) return true;
+            if (!server.start(PORT)) {
+                std::cerr << "Server: could not listen on port " << PORT << "\n";
+                return false;
+            }
+            std::cout << "Server: listening on port " << PORT << "\n";
+            return true;
         }
+    };
 
+    // اتصال ماندگار به سرور؛ اگر سرور بسته و دوباره باز شده باشد یک بار دوباره وصل می‌شود
+    class CollabClient {
     public:
-        SOCKET clientSocket;
+        static CollabClient &instance() {
+            static CollabClient client;
+            return client;
+        }
+
+        // false یعنی سرور در دسترس نیست یا هنوز چیزی از این نوع منتشر نکرده
+        bool fetch(MessageType type, std::string &payload) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                if (!client.connected() && !client.connect(IP, PORT)) break;
+                Net::Message reply;
+                if (!client.send(type, "")) continue;
+                while (client.receive(reply)) {
+                    if (reply.type != type) continue;
+                    payload = std::move(reply.payload);
+                    return !payload.empty();
+                }
+            }
+            std::cerr << "Client: could not reach server " << IP << ":" << PORT << "\n";
+            return false;
+        }
+
+    private:
+        Net::Client client;
+        std::mutex mtx;
     };
 
-    //----------------------------------
+    // کارهای شبکه‌ای که ممکن است منتظر طرف مقابل بمانند (fetch های CollabClient) روی یک رشته I/O و به ترتیب
+    // اجرا می‌شوند و کامل شدنشان به صورت رویداد SDL به حلقه اصلی می‌رسد؛ تابع کامل‌شدن روی رشته UI (dispatch)
+    // اجرا می‌شود، پس بدون قفل به مدار و رابط گرافیکی دسترسی دارد و رابط هیچ وقت منتظر شبکه نمی‌ماند.
+    // کارها blocking اند: کاری که منتظر connect به میزبان در دسترس نیست بماند کارهای بعدی صف را هم معطل می‌کند
+    class Executor {
+    public:
+        using Completion = std::function<void()>;
 
-    void startServer() {
-        TCPServer server(PORT);
-        std::cout << "Server waiting for client...\n";
-        server.acceptClient();
+        // هیچ وقت از بین نمی‌رود: رشته I/O ممکن است هنگام خروج هنوز منتظر connect باشد
+        static Executor &instance() {
+            static Executor *executor = new Executor();
+            return *executor;
+        }
 
-        // حالا می‌توانیم هم ارسال کنیم هم دریافت
-        server.sendMessage("Hello from Server!");
-        //server.receiveMessage();
-    }
+        // work روی رشته I/O (به ترتیب ارسال)؛ تابعی که برمی‌گرداند روی رشته UI اجرا می‌شود
+        void post(std::function<Completion()> work) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                pending.push_back(std::move(work));
+            }
+            ready.notify_one();
+        }
 
-    void startClient() {
-        TCPClient client(IP, PORT);
-        client.receiveMessage();
-        //client.sendMessage("Hello from Client!");
-    }
+        // از هر رشته‌ای: done در فریم بعدی روی رشته UI
+        void complete(Completion done) {
+            SDL_Event e{};
+            e.type = eventType;
+            e.user.data1 = new Completion(std::move(done));
+            if (SDL_PushEvent(&e) <= 0) delete static_cast<Completion *>(e.user.data1);
+        }
+
+        bool owns(const SDL_Event &e) const { return e.type == eventType; }
+
+        // حلقه اصلی برای رویدادهای owns
+        void dispatch(const SDL_Event &e) {
+            std::unique_ptr<Completion> done(static_cast<Completion *>(e.user.data1));
+            if (done && *done) (*done)();
+        }
+
+    private:
+        Uint32 eventType;
+        std::mutex mtx;
+        std::condition_variable ready;
+        std::deque<std::function<Completion()>> pending;
+
+        Executor() : eventType(SDL_RegisterEvents(1)) {
+            std::thread([this]() { loop(); }).detach();
+        }
+
+        void loop() {
+            while (true) {
+                std::function<Completion()> work;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    ready.wait(lock, [&]() { return !pending.empty(); });
+                    work = std::move(pending.front());
+                    pending.pop_front();
+                }
+                try {
+                    Completion done = work();
+                    if (done) complete(std::move(done));
+                }
+                catch (const std::exception &ex) {
+                    std::cerr << "Network: " << ex.what() << "\n";
+                }
+            }
+        }
+    };
 
     //----------------------------------
-    void startServerSendVoltageSource(shared_ptr<SinVoltageSource> e) {
-        TCPServer server(PORT);
+    void publishVoltageSource(shared_ptr<SinVoltageSource> e) {
+        Tracing::ScopedEvent sendTrace("publish voltage source", "network");
         ostringstream data;
         data<<e->getOffset()<<","<<e->getAmplitude()<<","<<e->getFrequency();
-        std::cout << "Server waiting for client...\n";
-        server.acceptClient();
-        server.sendMessage(data.str());
+        CollabServer::instance().publish(VoltageSourceMessage, data.str());
     }
 
-    void startClientReceiveVoltageSource(shared_ptr<SinVoltageSource> e) {
-        TCPClient client(IP, PORT);
+    // offset، دامنه و فرکانس منبع منتشر شده؛ خالی اگر سرور در دسترس نیست یا چیزی منتشر نکرده (رشته I/O)
+    vector<double> fetchVoltageSource() {
         string data;
         auto parseDoubles=[](const std::string& str)->vector<double> {
             vector<double> values;
@@ -7404,97 +8526,58 @@ namespace Network{
             }
             return values;
         };
-        data=client.receiveMessage();
+        Tracing::ScopedEvent receiveTrace("receive voltage source", "network");
+        if (!CollabClient::instance().fetch(VoltageSourceMessage, data)) return {};
         vector<double> x=parseDoubles(data);
-        e->setOffset(x[0]);
-        e->setAmplitude(x[1]);
-        e->setFrequency(x[2]);
+        if (x.size() < 3) return {};
+        return x;
     }
 
     //----------------------------------
 
-    std::mutex circuit_data_mutex;
-
-    void startServerSendCircuit(Wire &wire, vector<shared_ptr<LabelNet>>&labels, vector<shared_ptr<Element>>&elements, vector<shared_ptr<GNDSymbol>>&gndSymbols) {
-        TCPServer server(PORT);
-        std::cout << "Server waiting for client...\n";
-        server.acceptClient();
-
-        // قفل کردن موتکس قبل از دسترسی به داده‌های مشترک برای سریالایز
-        std::lock_guard<std::mutex> lock(circuit_data_mutex);
-
-        // سریالایز کردن داده
-        std::stringstream ss(std::ios::binary | std::ios::out | std::ios::in);
+    // headroom بایت صفر قبل از آرشیو (جای نسخه در publishSnapshot)؛ مستقیم در رشته‌ای نوشته می‌شود که برمی‌گردد
+    std::string circuitArchive(Wire &wire, vector<shared_ptr<LabelNet>>&labels, vector<shared_ptr<Element>>&elements, vector<shared_ptr<GNDSymbol>>&gndSymbols, size_t headroom = 0) {
+        Tracing::ScopedEvent serializeTrace("serialize circuit", "network");
+        static thread_local Bytes::OutputBuffer buffer;
+        buffer.begin(headroom);
         {
-            cereal::BinaryOutputArchive archive(ss);
+            std::ostream out(&buffer);
+            cereal::BinaryOutputArchive archive(out);
             archive(wire);
             archive(labels);
             archive(elements);
             archive(gndSymbols);
 
-            // متغیرهای استاتیک
+            // متغیرهای استاتیک؛ از شبکه نودها فقط نودهای استفاده شده (مثل فایل پروژه)
             archive(liine::count);
-            archive(Wire::allNodes);
+            archive(Wire::usedNodes());
             archive(Wire::Lines);
         }
-// قفل در انتهای این بلوک (scope) به صورت خودکار آزاد می‌شود
-
-        std::string serializedData = ss.str();
-
-// ارسال طول داده اول
-        uint32_t dataSize = htonl(serializedData.size());
-        send(server.clientSocket, reinterpret_cast<const char*>(&dataSize), sizeof(dataSize), 0);
-
-// ارسال خود داده
-        send(server.clientSocket, serializedData.c_str(), serializedData.size(), 0);
-        std::cout << "Server: Circuit data sent.\n";
+        return buffer.take();
     }
 
-    void startClientReceiveCircuit(Wire &wire, vector<shared_ptr<LabelNet>>&labels, vector<shared_ptr<Element>>&elements, vector<shared_ptr<GNDSymbol>>&gndSymbols) {
-        TCPClient client(IP, PORT);
-        std::cout << "Client: Connecting to server...\n";
-
-// دریافت طول داده
-        uint32_t dataSize;
-        if (recv(client.clientSocket, reinterpret_cast<char*>(&dataSize), sizeof(dataSize), 0) <= 0) {
-            std::cerr << "Client: Error receiving data size or connection closed.\n";
-            return;
-        }
-        dataSize = ntohl(dataSize);
-        std::cout << "Client: Received data size: " << dataSize << " bytes.\n";
-
-// دریافت داده
-        std::vector<char> buffer(dataSize);
-        size_t totalReceived = 0;
-        while (totalReceived < dataSize) {
-            int bytesReceived = recv(client.clientSocket, buffer.data() + totalReceived, dataSize - totalReceived, 0);
-            if (bytesReceived <= 0) {
-                std::cerr << "Client: Error receiving data or connection closed mid-transfer.\n";
-                return;
-            }
-            totalReceived += bytesReceived;
-        }
-        std::cout << "Client: All data received. Total: " << totalReceived << " bytes.\n";
-
-// قفل کردن موتکس قبل از دسترسی به داده‌های مشترک برای دیسریالایز
-        std::lock_guard<std::mutex> lock(circuit_data_mutex);
-
-// دیسریال کردن
-        std::stringstream ss(std::string(buffer.begin(), buffer.end()),
-                             std::ios::binary | std::ios::out | std::ios::in);
+    // data معمولاً بخشی از m.payload است و کپی نمی‌شود
+    bool loadCircuit(std::string_view data, Wire &wire, vector<shared_ptr<LabelNet>>&labels, vector<shared_ptr<Element>>&elements, vector<shared_ptr<GNDSymbol>>&gndSymbols) {
+        Tracing::ScopedEvent deserializeTrace("deserialize circuit", "network");
+        Bytes::InputView view(data);
+        std::istream in(&view);
 
         try {
-            cereal::BinaryInputArchive archive(ss);
+            cereal::BinaryInputArchive archive(in);
+            vector<shared_ptr<Node>> usedNodes;
             archive(
                     wire,
                     labels,
                     elements,
                     gndSymbols,
                     liine::count,
-                    Wire::allNodes,
+                    usedNodes,
                     Wire::Lines
             );
+            Wire::resetGrid();
+            Wire::restoreNodes(usedNodes);
             std::cout << "Client: Circuit data deserialized successfully.\n";
+            return true;
         }
         catch (const cereal::Exception& e) {
             std::cerr << "Client: Deserialization error: " << e.what() << '\n';
@@ -7502,51 +8585,176 @@ namespace Network{
         catch (const std::exception& e) {
             std::cerr << "Client: Standard error during deserialization: " << e.what() << '\n';
         }
+        return false;
     }
-//----------------------------------
 
-    void startServerSendAnalyze(const vector<string>& analyzeData) {
-        TCPServer server(PORT);
-        std::cout << "Server waiting for client...\n";
-        server.acceptClient();
+    // snapshot کامل؛ بعد از آن تغییرات با publishDelta
+    void publishCircuit(Wire &wire, vector<shared_ptr<LabelNet>>&labels, vector<shared_ptr<Element>>&elements, vector<shared_ptr<GNDSymbol>>&gndSymbols) {
+        std::string framed = circuitArchive(wire, labels, elements, gndSymbols, 8);
+        size_t size = framed.size() - 8;
+        CollabServer::instance().publishSnapshot(std::move(framed));
+        std::cout << "Server: Circuit snapshot published (" << size << " bytes).\n";
+    }
 
-        // سریالایز کردن داده
-        std::stringstream ss(std::ios::binary | std::ios::out | std::ios::in);
-        {
-            cereal::BinaryOutputArchive archive(ss);
-            archive(analyzeData); // سریال کردن کل وکتور
+    // مشترک (مدار زنده یا نتیجه‌ها) روی اتصال جدا: رشته دریافت وصل می‌شود و پیام‌ها را در صف می‌گذارد
+    // و حلقه اصلی با take آن‌ها را اعمال می‌کند. رشته دریافت جداست و فقط Link خودش را می‌شناسد،
+    // پس start و stop روی رشته UI منتظر connect یا طرف مقابل نمی‌مانند
+    class Follower {
+    public:
+        explicit Follower(MessageType subscription) : subscription(subscription) {}
+        ~Follower() { stop(); }
+
+        // اشتراک قبلی رها می‌شود
+        void start() {
+            stop();
+            auto link = std::make_shared<Link>();
+            current = link;
+            std::thread([link, host = IP, port = PORT, type = subscription]() {
+                bool ok = link->client.connect(host, port) && link->client.send(type, "");
+                if (!ok) std::cerr << "Client: could not reach server " << host << ":" << port << "\n";
+                {
+                    std::lock_guard<std::mutex> lock(link->mtx);
+                    link->open = ok = ok && !link->cancelled;
+                }
+                Net::Message m;
+                while (ok && link->client.receive(m)) {
+                    std::lock_guard<std::mutex> lock(link->mtx);
+                    link->inbox.push_back(std::move(m));
+                }
+                std::lock_guard<std::mutex> lock(link->mtx);
+                link->open = false;
+                link->client.close();
+                link->active = false;
+            }).detach();
         }
 
-        std::string serializedData = ss.str();
+        void stop() {
+            if (current) {
+                std::lock_guard<std::mutex> lock(current->mtx);
+                current->cancelled = true;
+                if (current->open) current->client.shutdown();
+            }
+            current.reset();
+            expected = 0;
+        }
 
-        // ارسال طول داده اول
-        uint32_t dataSize = htonl(serializedData.size());
-        send(server.clientSocket, reinterpret_cast<const char*>(&dataSize), sizeof(dataSize), 0);
+        bool following() const { return current && current->active; }
 
-        // ارسال خود داده
-        send(server.clientSocket, serializedData.c_str(), serializedData.size(), 0);
-    }
+        std::deque<Net::Message> take() {
+            std::deque<Net::Message> messages;
+            if (!current) return messages;
+            std::lock_guard<std::mutex> lock(current->mtx);
+            messages.swap(current->inbox);
+            return messages;
+        }
 
+        // نسخه‌ای که تغییر بعدی باید داشته باشد؛ صفر تا اولین snapshot
+        uint64_t expected = 0;
 
-    vector<string> startClientReceiveAnalyze(){
-        TCPClient client(IP, PORT);
+    private:
+        struct Link {
+            Net::Client client;
+            std::mutex mtx;
+            std::deque<Net::Message> inbox;
+            std::atomic<bool> active{true};
+            bool open = false;          // بعد از connect؛ از آن به بعد stop سوکت را shutdown می‌کند
+            bool cancelled = false;
+        };
+        MessageType subscription;
+        std::shared_ptr<Link> current;
+    };
 
-        // دریافت طول داده
-        uint32_t dataSize;
-        recv(client.clientSocket, reinterpret_cast<char*>(&dataSize), sizeof(dataSize), 0);
-        dataSize = ntohl(dataSize);
+    // بلوک‌های نتیجه یک اجرا به ترتیب رسیدن سیگنال‌ها جمع می‌شوند (همان ترتیب data/log.txt سرور)
+    class ResultCollector {
+    public:
+        // true وقتی اجرا تمام شده: log متن data/log.txt است، یا error پیام خطای سرور
+        // بلوک خراب کل اجرا را خراب می‌کند: نمونه‌های ناقص به جای نتیجه کامل نوشته نمی‌شوند
+        bool add(const Net::Message &m, std::string &log, std::string &error) {
+            if (m.payload.size() < 8) return false;
+            uint64_t id = versionOf(m.payload);
+            if (id != run) {
+                run = id;
+                series.clear();
+                bySignal.clear();
+                corrupt.clear();
+            }
+            if (m.type == ResultBlockMessage) {
+                if (!corrupt.empty()) return false;
+                std::vector<Samples::Series> blocks;
+                try {
+                    blocks = Samples::decode(m.payload.substr(8));
+                }
+                catch (const std::exception &ex) {
+                    corrupt = ex.what();
+                    series.clear();
+                    bySignal.clear();
+                    return false;
+                }
+                for (Samples::Series &block : blocks) {
+                    auto it = bySignal.find(block.signal);
+                    if (it == bySignal.end()) {
+                        bySignal[block.signal] = series.size();
+                        series.push_back(std::move(block));
+                        continue;
+                    }
+                    auto &points = series[it->second].points;
+                    points.insert(points.end(), block.points.begin(), block.points.end());
+                }
+                return false;
+            }
+            if (m.type != ResultEndMessage || m.payload.size() < 9) return false;
+            std::string text = m.payload.substr(9);
+            error.clear();
+            if (m.payload[8]) error = text.empty() ? "analysis failed" : text;
+            else if (!text.empty()) log = std::move(text);      // کل data/log.txt سرور؛ بلوک‌های خراب مهم نیستند
+            else if (!corrupt.empty()) error = "results discarded: " + corrupt;
+            else {
+                std::ostringstream out;
+                for (const Samples::Series &s : series) {
+                    out << s.signal << '\n';
+                    for (const auto &point : s.points) out << point.first << "," << point.second << '\n';
+                }
+                log = out.str();
+            }
+            series.clear();
+            bySignal.clear();
+            corrupt.clear();
+            return true;
+        }
 
-        // دریافت داده
-        std::vector<char> buffer(dataSize);
-        recv(client.clientSocket, buffer.data(), dataSize, 0);
+    private:
+        uint64_t run = 0;
+        std::string corrupt;        // خطای اولین بلوک خراب این اجرا
+        std::vector<Samples::Series> series;
+        std::map<std::string, size_t> bySignal;
+    };
+//----------------------------------
 
-        // دیسریال کردن
-        std::stringstream ss(std::string(buffer.begin(), buffer.end()),
-                             std::ios::binary | std::ios::out | std::ios::in);
+    void publishAnalyze(const vector<string>& analyzeData) {
+        Tracing::ScopedEvent sendTrace("publish analyze", "network");
+        // سریالایز کردن داده
+        Bytes::OutputBuffer buffer;
+        buffer.begin();
+        {
+            std::ostream out(&buffer);
+            cereal::BinaryOutputArchive archive(out);
+            archive(analyzeData); // سریال کردن کل وکتور
+        }
+        CollabServer::instance().publish(AnalyzeMessage, buffer.take());
+    }
 
+    // خالی اگر سرور تنظیماتی منتشر نکرده
+    vector<string> fetchAnalyze(){
+        Tracing::ScopedEvent receiveTrace("receive analyze", "network");
+        std::string data;
         vector<string> analyzeData;
+        if (!CollabClient::instance().fetch(AnalyzeMessage, data)) return analyzeData;
+
+        // دیسریال کردن از همان بافر دریافتی
+        Bytes::InputView view(data);
+        std::istream in(&view);
         {
-            cereal::BinaryInputArchive archive(ss);
+            cereal::BinaryInputArchive archive(in);
             archive(analyzeData); // دیسریال کردن کل وکتور
         }
 
@@ -7558,28 +8766,6 @@ namespace Network{
 using namespace Network;
 //////---------------------------------------
 void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,string type,string name,string value,string model="",string gain="",string sourceElement="",string sourceNodeP="",string sourceNodeN="",string nameS="",string posNode="",string negNode="",string phase="",string Basefr=""){
-    auto unitHandler=[](string input, string type)->double {
-        regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-        smatch match;
-        if (regex_match(input, match, pattern)) {
-            double value = stod(match[1]);
-            string unit = match[2].str();
-            double multiplier = 1.0;
-            if (unit == "n") multiplier = 1e-9;
-            else if (unit == "u") multiplier = 1e-6;
-            else if (unit == "m") multiplier = 1e-3;
-            else if (unit == "k") multiplier = 1e3;
-            else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-            else if (unit == "G") multiplier = 1e9;
-            if (value <= 0) {
-                throw invalidValue(type);
-            }
-            return value * multiplier;
-        } else {
-            throw invalidValue(type);
-        }
-        return -1.0;
-    };
     auto findElement=[&e] (string name)->shared_ptr<Element>{
         for (int i = 0; i < e.size(); ++i) {
             if(e[i]->getName()==name) {
@@ -7596,7 +8782,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     shared_ptr<Node> negNodeE=Wire::findNode(x-stepX*2,y);
 
     if(type=="Resistor"){
-        double Value = unitHandler(value, "Resistance");
+        double Value = unitHandlerPositive(value, "Resistance");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<Resistor> r = dynamic_pointer_cast<Resistor>(E);
         if (r) {
@@ -7609,7 +8795,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="Capacitor"){
-        double Value = unitHandler(value, "Capacitance");
+        double Value = unitHandlerPositive(value, "Capacitance");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<Capacitor> r = dynamic_pointer_cast<Capacitor>(E);
         if (r) {
@@ -7622,7 +8808,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="Inductor"){
-        double Value = unitHandler(value, "Inductance");
+        double Value = unitHandlerPositive(value, "Inductance");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<Inductor> r = dynamic_pointer_cast<Inductor>(E);
         if (r) {
@@ -7635,7 +8821,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="VoltageSource"){
-        double Value = unitHandler(value, "Voltage");
+        double Value = unitHandlerPositive(value, "Voltage");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<VoltageSource> r = dynamic_pointer_cast<VoltageSource>(E);
         if (r) {
@@ -7648,7 +8834,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="AcVoltageSource"){
-        double Value = unitHandler(value, "Voltage");
+        double Value = unitHandlerPositive(value, "Voltage");
         double Phase= unitHandler3(phase, "Voltage");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<VoltageSource> r = dynamic_pointer_cast<VoltageSource>(E);
@@ -7665,8 +8851,8 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="PhaseVoltageSource"){
-        double Value = unitHandler(value, "Voltage");
-        double BaseFry= unitHandler(Basefr, "Voltage");
+        double Value = unitHandlerPositive(value, "Voltage");
+        double BaseFry= unitHandlerPositive(Basefr, "Voltage");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<VoltageSource> r = dynamic_pointer_cast<VoltageSource>(E);
         if (r) {
@@ -7701,8 +8887,18 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
 
     }
 
+    else if(type=="StreamVoltageSource"){
+        if (value.empty()) throw ErrorInput();
+        if (dynamic_pointer_cast<VoltageSource>(findElement(name))) {
+            throw duplicateElementName("VoltageSource", name);
+        }
+        auto Vs = make_shared<StreamVoltageSource>(x,y,name,value,negNodeE,posNodeE);
+        Vs->value="STREAM(" + value + ")";
+        e.push_back(Vs);
+    }
+
     else if(type=="CurrentSource"){
-        double Value = unitHandler(value, "Voltage");
+        double Value = unitHandlerPositive(value, "Voltage");
         shared_ptr<Element> E = findElement(name);
         shared_ptr<CurrentSource> r =dynamic_pointer_cast<CurrentSource>(E);
         if (r) {
@@ -7739,7 +8935,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="CCCS"){
-        double g= stod(gain);
+        double g= unitHandler3(gain, "gain");
         shared_ptr<Element>E = findElement(name);
         if (E) {
             throw duplicateElementName("Element", name);
@@ -7754,7 +8950,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="CCVS"){
-        double g= stod(gain);
+        double g= unitHandler3(gain, "gain");
         shared_ptr<Element>E = findElement(name);
         if (E) {
             throw duplicateElementName("Element", name);
@@ -7769,7 +8965,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="VCCS"){
-        double g= stod(gain);
+        double g= unitHandler3(gain, "gain");
         shared_ptr<Node> P=Wire::findNodeWhitname(sourceNodeP)[0];
         shared_ptr<Node> N=Wire::findNodeWhitname(sourceNodeN)[0];
         if(!N){
@@ -7788,7 +8984,7 @@ void addElement(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y ,str
     }
 
     else if(type=="VCVS"){
-        double g= stod(gain);
+        double g= unitHandler3(gain, "gain");
         shared_ptr<Node> P=Wire::findNodeWhitname(sourceNodeP)[0];
         shared_ptr<Node> N=Wire::findNodeWhitname(sourceNodeN)[0];
         if(!N){
@@ -7813,28 +9009,6 @@ void addElementTime(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y
                     string frequency,string vOffset,string vAmplitude,
                     string Vinitial, string Von,string Tdelay, string Trise,string Tfall, string Ton,string Tperiod, string Ncycles = "0",
                     string tPulse="",string area=""){
-    auto unitHandler=[](string input, string type)->double {
-        regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-        smatch match;
-        if (regex_match(input, match, pattern)) {
-            double value = stod(match[1]);
-            string unit = match[2].str();
-            double multiplier = 1.0;
-            if (unit == "n") multiplier = 1e-9;
-            else if (unit == "u") multiplier = 1e-6;
-            else if (unit == "m") multiplier = 1e-3;
-            else if (unit == "k") multiplier = 1e3;
-            else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-            else if (unit == "G") multiplier = 1e9;
-            if (value <= 0) {
-                throw invalidValue(type);
-            }
-            return value * multiplier;
-        } else {
-            throw invalidValue(type);
-        }
-        return -1.0;
-    };
     auto findElement=[&e] (string name)->shared_ptr<Element>{
         for (int i = 0; i < e.size(); ++i) {
             if(e[i]->getName()==name) {
@@ -7843,77 +9017,55 @@ void addElementTime(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y
         }
         return nullptr;
     };
-    auto unitHandler2=[](string input, string type="time") {
-        regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-        smatch match;
-        if (regex_match(input, match, pattern)) {
-            double value = stod(match[1]);
-            string unit = match[2].str();
-            double multiplier = 1.0;
-            if (unit == "n") multiplier = 1e-9;
-            else if (unit == "u") multiplier = 1e-6;
-            else if (unit == "m") multiplier = 1e-3;
-            else if (unit == "k") multiplier = 1e3;
-            else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-            else if (unit == "G") multiplier = 1e9;
-            if (value < 0) {
-                throw invalidValue(type);
-            }
-            return value * multiplier;
-        } else {
-            throw invalidValue(type);
-        }
-        return -1.0;
-    };
 
     snapToGrid(x,y);
     auto posNodeE = Wire::findNode(x+stepX*2,y);
     auto negNodeE = Wire::findNode(x-stepX*2,y);
 
     if(type=="DeltaVoltageSource"){
-        double Value = unitHandler(area, "Voltage");
+        double Value = unitHandlerPositive(area, "Voltage");
         auto E = findElement(name);
         auto vs = dynamic_pointer_cast<VoltageSource>(E);
         if (vs) {
             throw duplicateElementName("VoltageSource", name);
         }
-        auto Vs = make_shared<deltaVoltageSource>(x,y,name,unitHandler2(tPulse),0.001,Value,negNodeE,posNodeE);
+        auto Vs = make_shared<deltaVoltageSource>(x,y,name,unitHandlerNonNegative(tPulse, "time"),0.001,Value,negNodeE,posNodeE);
         Vs->value="Delta(area: "+area+",tPulse: "+tPulse+")";
         e.push_back(Vs);
     }
 
     else if(type=="DeltaCurrentSource"){
-        double Value = unitHandler(area, "Current");
+        double Value = unitHandlerPositive(area, "Current");
         auto E = findElement(name);
         auto cs = dynamic_pointer_cast<CurrentSource>(E);
         if (cs) {
             throw duplicateElementName("CurrentSource", name);
         }
-        auto Is = make_shared<deltaCurrentSource>(x,y,name,unitHandler2(tPulse),0.001,Value,negNodeE,posNodeE);
+        auto Is = make_shared<deltaCurrentSource>(x,y,name,unitHandlerNonNegative(tPulse, "time"),0.001,Value,negNodeE,posNodeE);
         Is->value="Delta(area: "+area+",tPulse: "+tPulse+")";
         e.push_back(Is);
     }
 
     else if(type=="SineVoltageSource"){
-        double freq = unitHandler(frequency, "frequency");
+        double freq = unitHandlerPositive(frequency, "frequency");
         auto E = findElement(name);
         auto vs = dynamic_pointer_cast<VoltageSource>(E);
         if (vs) {
             throw duplicateElementName("VoltageSource", name);
         }
-        auto Vs = make_shared<SinVoltageSource>(x,y,name,stod(vOffset),stod(vAmplitude),freq,negNodeE,posNodeE);
+        auto Vs = make_shared<SinVoltageSource>(x,y,name,unitHandler3(vOffset, "offset"),unitHandler3(vAmplitude, "amplitude"),freq,negNodeE,posNodeE);
         Vs->value="Sine(f: "+frequency+",Amp: "+vAmplitude+",off: "+vOffset+")";
         e.push_back(Vs);
     }
 
     else if(type=="SineCurrentSource"){
-        double freq = unitHandler(frequency, "frequency");
+        double freq = unitHandlerPositive(frequency, "frequency");
         auto E = findElement(name);
         auto cs = dynamic_pointer_cast<CurrentSource>(E);
         if (cs) {
             throw duplicateElementName("CurrentSource", name);
         }
-        auto Is = make_shared<SinCurrentSource>(x,y,name,stod(vOffset),stod(vAmplitude),freq,negNodeE,posNodeE);
+        auto Is = make_shared<SinCurrentSource>(x,y,name,unitHandler3(vOffset, "offset"),unitHandler3(vAmplitude, "amplitude"),freq,negNodeE,posNodeE);
         Is->value="Sine(f: "+frequency+",Amp: "+vAmplitude+",off: "+vOffset+")";
         e.push_back(Is);
     }
@@ -7925,10 +9077,10 @@ void addElementTime(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y
             throw duplicateElementName("VoltageSource", name);
         }
         auto Vs = make_shared<PulseVoltageSource>(x,y,name,
-                                                  stod(Vinitial), stod(Von),
-                                                  unitHandler2(Tdelay, "time"), unitHandler2(Trise, "time"),
-                                                  unitHandler2(Tfall, "time"), unitHandler2(Ton, "time"),
-                                                  unitHandler2(Tperiod, "time"), unitHandler2(Ncycles),
+                                                  unitHandler3(Vinitial, "Voltage"), unitHandler3(Von, "Voltage"),
+                                                  unitHandlerNonNegative(Tdelay, "time"), unitHandlerNonNegative(Trise, "time"),
+                                                  unitHandlerNonNegative(Tfall, "time"), unitHandlerNonNegative(Ton, "time"),
+                                                  unitHandlerNonNegative(Tperiod, "time"), unitHandlerNonNegative(Ncycles, "cycles"),
                                                   negNodeE,posNodeE);
         Vs->value="Pulse(Vini: "+Vinitial+",Von: "+Von+",Td: "+Tdelay+
                   ",Tr: "+Trise+",Tf: "+Tfall+",Ton: "+Ton+",Tp: "+Tperiod+")";
@@ -7942,10 +9094,10 @@ void addElementTime(messageBox &error,vector<shared_ptr<Element>>&e,int x,int y
             throw duplicateElementName("CurrentSource", name);
         }
         auto Is = make_shared<PulseCurrentSource>(x,y,name,
-                                                  stod(Vinitial), stod(Von),
-                                                  unitHandler2(Tdelay, "time"), unitHandler2(Trise, "time"),
-                                                  unitHandler2(Tfall, "time"), unitHandler2(Ton, "time"),
-                                                  unitHandler2(Tperiod, "time"), unitHandler2(Ncycles),
+                                                  unitHandler3(Vinitial, "Voltage"), unitHandler3(Von, "Voltage"),
+                                                  unitHandlerNonNegative(Tdelay, "time"), unitHandlerNonNegative(Trise, "time"),
+                                                  unitHandlerNonNegative(Tfall, "time"), unitHandlerNonNegative(Ton, "time"),
+                                                  unitHandlerNonNegative(Tperiod, "time"), unitHandlerNonNegative(Ncycles, "cycles"),
                                                   negNodeE,posNodeE);
         Is->value="Pulse(Vini: "+Vinitial+",Von: "+Von+",Td: "+Tdelay+
                   ",Tr: "+Trise+",Tf: "+Tfall+",Ton: "+Ton+",Tp: "+Tperiod+")";
@@ -8038,8 +9190,9 @@ PopupMenu createServerMenu() {
     shared_ptr<TTF_Font> font(TTF_OpenFont("assets/Tahoma.ttf", 14), TTF_CloseFont);
     PopupMenu saveMenu(font, 180);
     saveMenu.addItem("send VoltageSource", [](){ SDL_Log("send VoltageSource"); });
-    saveMenu.addItem("send Circuit", [](){ SDL_Log("send Circuit"); });
+    saveMenu.addItem("share Circuit (live)", [](){ SDL_Log("share Circuit"); });
     saveMenu.addItem("send analyze", [](){ SDL_Log("send analyze"); });
+    saveMenu.addItem("share Results (live)", [](){ SDL_Log("share Results"); });
     return saveMenu;
 }
 
@@ -8047,8 +9200,10 @@ PopupMenu createClientMenu() {
     shared_ptr<TTF_Font> font(TTF_OpenFont("assets/Tahoma.ttf", 14), TTF_CloseFont);
     PopupMenu saveMenu(font, 180);
     saveMenu.addItem("receive VoltageSource", [](){ SDL_Log("receive VoltageSource");});
-    saveMenu.addItem("receive Circuit", [](){ SDL_Log("receive Circuit"); });
+    saveMenu.addItem("follow Circuit (live)", [](){ SDL_Log("follow Circuit"); });
     saveMenu.addItem("receive analyze", [](){ SDL_Log("receive analyze"); });
+    saveMenu.addItem("run Analysis on worker", [](){ SDL_Log("run on worker"); });
+    saveMenu.addItem("follow Results (live)", [](){ SDL_Log("follow Results"); });
     return saveMenu;
 }
 
@@ -8057,6 +9212,7 @@ PopupMenu createFileMenu() {
     PopupMenu saveMenu(font, 180);
     saveMenu.addItem("open", [](){ SDL_Log("Do Save"); });
     saveMenu.addItem("New", [](){ SDL_Log("Do Save As"); });
+    saveMenu.addItem("Import netlist", [](){ SDL_Log("Do Import"); });
     //saveMenu.addItem("Export", [](){ SDL_Log("Do Export"); });
     return saveMenu;
 }
@@ -8083,6 +9239,7 @@ PopupMenu createComponentMenu() {
     componentMenu.addItem("AcVoltageSource", [](){ SDL_Log("AcVoltageSource"); });
     componentMenu.addItem("PhaseVoltageSource", [](){ SDL_Log("PhaseVoltageSource"); });
     componentMenu.addItem("PWLVoltageSource", [](){ SDL_Log("PWLVoltageSource"); });
+    componentMenu.addItem("StreamVoltageSource", [](){ SDL_Log("StreamVoltageSource"); });
 
     return componentMenu;
 }
@@ -8095,6 +9252,7 @@ PopupMenu createAnalyzeMenu() {
     componentMenu.addItem("DC Sweep", [](){ SDL_Log("C"); });
     componentMenu.addItem("Ac Sweep", [](){ SDL_Log("V"); });
     componentMenu.addItem("Phase Sweep", [](){ SDL_Log("D"); });
+    componentMenu.addItem("Save: all", [](){ SDL_Log("S"); });
     return componentMenu;
 }
 
@@ -8109,101 +9267,24 @@ vector<string> split(const string &s, char delimiter) {
     return tokens;
 }
 
-// تابع برای تشخیص شروع یک بخش جدید
-int get_precedence(const std::string& op) {
-    if (op == "+" || op == "-") return 1;
-    if (op == "*" || op == "/") return 2;
-    return 0;
-}
-
-bool is_operator(const std::string& token) {
-    return token == "+" || token == "-" || token == "*" || token == "/";
-}
-
-// تابع tokenize_expression بهبود یافته برای پشتیبانی از (amp) و (phase)
-std::vector<std::string> tokenize_expression(const std::string& expr) {
-    std::vector<std::string> tokens;
-    for (size_t i = 0; i < expr.length(); ++i) {
-        if (isspace(expr[i])) continue;
-
-        if ((expr[i] == 'V' || expr[i] == 'I') && i + 1 < expr.length() && expr[i+1] == '(') {
-            size_t start = i;
-            size_t end = expr.find(')', start);
-            if (end != std::string::npos) {
-                // بررسی وجود پسوندهای (amp) یا (phase)
-                if (expr.substr(end + 1, 5) == "(amp)") {
-                    end += 5;
-                } else if (expr.substr(end + 1, 7) == "(phase)") {
-                    end += 7;
-                }
-                tokens.push_back(expr.substr(start, end - start + 1));
-                i = end;
-            }
-        } else if (isdigit(expr[i]) || expr[i] == '.') {
-            size_t start = i;
-            while (i + 1 < expr.length() && (isdigit(expr[i+1]) || expr[i+1] == '.')) {
-                i++;
-            }
-            tokens.push_back(expr.substr(start, i - start + 1));
-        } else if (std::string("+-*/()").find(expr[i]) != std::string::npos) {
-            tokens.push_back(std::string(1, expr[i]));
-        }
+// ستون عددی یک بخش لاگ؛ خطوط "t,value" فقط یک بار خوانده می‌شوند
+struct SignalColumn {
+    vector<double> time;
+    vector<double> value;
+};
+
+SignalColumn parse_signal_column(const vector<string> &lines) {
+    SignalColumn column;
+    column.time.reserve(lines.size());
+    column.value.reserve(lines.size());
+    for (const string &data_line : lines) {
+        char *end = nullptr;
+        double t = strtod(data_line.c_str(), &end);
+        double v = (*end == ',') ? strtod(end + 1, nullptr) : 0.0;
+        column.time.push_back(t);
+        column.value.push_back(v);
     }
-    return tokens;
-}
-
-std::vector<std::string> infix_to_postfix(const std::vector<std::string>& tokens) {
-    std::vector<std::string> output_queue;
-    std::stack<std::string> operator_stack;
-
-    for (const std::string& token : tokens) {
-        // هر توکنی که با V یا I شروع شود یا عدد باشد، یک مقدار (value) است
-        if (isdigit(token[0]) || token[0] == 'V' || token[0] == 'I') {
-            output_queue.push_back(token);
-        } else if (is_operator(token)) {
-            while (!operator_stack.empty() && operator_stack.top() != "(" &&
-                   get_precedence(operator_stack.top()) >= get_precedence(token)) {
-                output_queue.push_back(operator_stack.top());
-                operator_stack.pop();
-            }
-            operator_stack.push(token);
-        } else if (token == "(") {
-            operator_stack.push(token);
-        } else if (token == ")") {
-            while (!operator_stack.empty() && operator_stack.top() != "(") {
-                output_queue.push_back(operator_stack.top());
-                operator_stack.pop();
-            }
-            if (!operator_stack.empty()) operator_stack.pop();
-        }
-    }
-
-    while (!operator_stack.empty()) {
-        output_queue.push_back(operator_stack.top());
-        operator_stack.pop();
-    }
-    return output_queue;
-}
-
-double evaluate_postfix(const std::vector<std::string>& postfix_tokens, const std::map<std::string, double>& signal_values) {
-    std::stack<double> eval_stack;
-    for (const std::string& token : postfix_tokens) {
-        if (isdigit(token[0])) {
-            eval_stack.push(stod(token));
-        } else if (token[0] == 'V' || token[0] == 'I') {
-            eval_stack.push(signal_values.at(token));
-        } else if (is_operator(token)) {
-            if (eval_stack.size() < 2) throw std::runtime_error("Invalid expression");
-            double val2 = eval_stack.top(); eval_stack.pop();
-            double val1 = eval_stack.top(); eval_stack.pop();
-            if (token == "+") eval_stack.push(val1 + val2);
-            else if (token == "-") eval_stack.push(val1 - val2);
-            else if (token == "*") eval_stack.push(val1 * val2);
-            else if (token == "/") eval_stack.push(val1 / val2);
-        }
-    }
-    if (eval_stack.size() != 1) throw std::runtime_error("Invalid expression");
-    return eval_stack.top();
+    return column;
 }
 
 // تابع جدید برای نگاشت نام سیگنال ورودی به کلید استفاده شده در data_map
@@ -8227,13 +9308,13 @@ bool is_new_section(const std::string &line) {
 
 void extract_data(const string &input_string, const vector<shared_ptr<Element>> &elements) {
     std::ifstream log_file("data/log.txt");
-    std::ofstream data_file("data.txt");
+    std::ofstream output_file("data.txt");
 
     if (!log_file.is_open()) {
         std::cerr << "Error: Could not open log.txt" << std::endl;
         return;
     }
-    if (!data_file.is_open()) {
+    if (!output_file.is_open()) {
         std::cerr << "Error: Could not create data.txt" << std::endl;
         return;
     }
@@ -8274,8 +9355,72 @@ void extract_data(const string &input_string, const vector<shared_ptr<Element>>
         if(!key_line.empty()) input_keys.push_back(key_line);
     }
 
-// پردازش کلیدها
-    for (const string &key : input_keys) {
+// ستون‌های عددی فقط برای سیگنال‌هایی که در عبارت‌ها استفاده می‌شوند ساخته و بین عبارت‌ها مشترک می‌شوند
+// کلیدها همزمان پردازش می‌شوند؛ خواندن ستون بیرون از قفل است و اگر دو کار یک ستون را بسازند اولی می‌ماند
+    std::map<std::string, SignalColumn> columns;
+    std::mutex columns_mutex;
+    auto column_of = [&](const std::string &mapped_key) -> const SignalColumn & {
+        {
+            std::lock_guard<std::mutex> lock(columns_mutex);
+            auto it = columns.find(mapped_key);
+            if (it != columns.end()) return it->second;
+        }
+        SignalColumn column = parse_signal_column(data_map.at(mapped_key));
+        std::lock_guard<std::mutex> lock(columns_mutex);
+        return columns.emplace(mapped_key, std::move(column)).first->second;
+    };
+
+// عبارت یک بار کامپایل و روی کل ستون‌ها اجرا می‌شود
+    auto write_expression = [&](const std::string &label, const std::string &expr, std::ostream &data_file) {
+        try {
+            Expressions::Program program = Expressions::compile(expr);
+            std::vector<const double *> signal_columns;
+            const std::vector<double> *time = nullptr;
+            size_t num_points = SIZE_MAX;
+
+            for (const std::string &name : program.signals) {
+                if (name == "V(N00)") {
+                    signal_columns.push_back(nullptr);
+                    continue;
+                }
+                std::string mapped_key = map_signal_key(name); // نگاشت نام به کلید data_map
+                // در تحلیل AC، V(x) بدون پسوند همان دامنه است
+                if (data_map.find(mapped_key) == data_map.end() && data_map.count(mapped_key + "(amplitude)")) {
+                    mapped_key += "(amplitude)";
+                }
+                if (data_map.find(mapped_key) == data_map.end()) {
+                    std::cerr << "Warning: In expression '" << label << "', data for '" << name << "' (mapped to '" << mapped_key << "') not found. Skipping expression." << std::endl;
+                    return;
+                }
+                const SignalColumn &column = column_of(mapped_key);
+                signal_columns.push_back(column.value.data());
+                num_points = std::min(num_points, column.value.size());
+                if (!time) time = &column.time;
+            }
+
+            if (!time) {
+                // عبارت بدون سیگنال (مثل V(N00) یا عدد ثابت): زمان از اولین بخش لاگ
+                if (data_map.empty()) {
+                    std::cerr << "Warning: Cannot process expression '" << label << "' because log data is empty." << std::endl;
+                    return;
+                }
+                time = &column_of(data_map.begin()->first).time;
+                num_points = time->size();
+            }
+
+            std::vector<double> result;
+            program.evaluate(signal_columns, time->data(), num_points, result);
+            data_file << label << '\n';
+            for (size_t i = 0; i < num_points; ++i) {
+                data_file << (*time)[i] << "," << result[i] << "\n";
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Could not evaluate expression '" << label << "'. It may be an unknown key or an invalid expression. Error: " << e.what() << std::endl;
+        }
+    };
+
+// پردازش یک کلید در data_file
+    auto process_key = [&](const string &key, std::ostream &data_file) {
         if (key.size() > 2 && key[0] == 'P' && key[1] == '(') {
 // پردازش المان‌های توان (همانند قبل)
             string elementName = key.substr(2, key.size() - 3);
@@ -8289,46 +9434,13 @@ void extract_data(const string &input_string, const vector<shared_ptr<Element>>
 
             if (!itElem) {
                 cerr << "Warning: Element '" << elementName << "' not found in element list" << endl;
-                continue;
+                return;
             }
 
+            // توان همان عبارت (V(p)-V(n))*I(name) است
             string n1 = "V(" + itElem->getNodeP()->getName() + ")";
             string n2 = "V(" + itElem->getNodeN()->getName() + ")";
-            string Ikey = "I(" + itElem->name + ")";
-
-            bool n1_is_zero = (n1 == "V(N00)");
-            bool n2_is_zero = (n2 == "V(N00)");
-
-            if ((!n1_is_zero && data_map.find(n1) == data_map.end()) ||
-                (!n2_is_zero && data_map.find(n2) == data_map.end()) ||
-                data_map.find(Ikey) == data_map.end()) {
-                cerr << "Warning: Missing data for element '" << elementName << "'" << endl;
-                continue;
-            }
-
-            auto &i_data = data_map[Ikey];
-
-            data_file << key << '\n';
-            for (size_t i = 0; i < i_data.size(); i++) {
-                double t3, i3;
-                sscanf(i_data[i].c_str(), "%lf,%lf", &t3, &i3);
-
-                double v1 = 0.0, v2 = 0.0;
-
-                if (!n1_is_zero) {
-                    double t, val;
-                    sscanf(data_map[n1][i].c_str(), "%lf,%lf", &t, &val);
-                    v1 = val;
-                }
-                if (!n2_is_zero) {
-                    double t, val;
-                    sscanf(data_map[n2][i].c_str(), "%lf,%lf", &t, &val);
-                    v2 = val;
-                }
-
-                double p = (v1 - v2) * i3;
-                data_file << t3 << "," << p << "\n";
-            }
+            write_expression(key, "(" + n1 + "-" + n2 + ")*I(" + itElem->name + ")", data_file);
         }
         else if (key.size() > 3 && key[0] == 'V' && key[1] == '(') {
 // بررسی وجود پسوند (amp) یا (phase) در کلید ورودی
@@ -8373,13 +9485,13 @@ void extract_data(const string &input_string, const vector<shared_ptr<Element>>
                 if (has_amplitude || has_phase) {
                     if (has_amplitude) {
                         data_file << amp_key << '\n';
-                        for (const string &data_line : data_map[amp_key]) {
+                        for (const string &data_line : data_map.at(amp_key)) {
                             data_file << data_line << '\n';
                         }
                     }
                     if (has_phase) {
                         data_file << phase_key << '\n';
-                        for (const string &data_line : data_map[phase_key]) {
+                        for (const string &data_line : data_map.at(phase_key)) {
                             data_file << data_line << '\n';
                         }
                     }
@@ -8411,75 +9523,1561 @@ void extract_data(const string &input_string, const vector<shared_ptr<Element>>
         else if (data_map.count(key)) {
 // پردازش کلیدهای ساده که مستقیماً در فایل لاگ وجود دارند
             data_file << key << '\n';
-            for (const std::string &data_line : data_map[key]) {
+            for (const std::string &data_line : data_map.at(key)) {
                 data_file << data_line << '\n';
             }
         }
         else {
-// ---> بخش پردازش عبارت ریاضی (به‌روز شده) <---
+// ---> بخش پردازش عبارت ریاضی <---
+            write_expression(key, key, data_file);
+        }
+    };
+
+// هر کلید روی Tasks::Pool در بافر خودش نوشته و بافرها به ترتیب کلیدها در data.txt ریخته می‌شوند
+    std::vector<std::string> blocks(input_keys.size());
+    Tasks::parallelFor(input_keys.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::ostringstream block;
+            process_key(input_keys[i], block);
+            blocks[i] = block.str();
+        }
+    }, 1);
+    for (const std::string &block : blocks) output_file << block;
+
+    output_file.close();
+    cout << "Data extracted successfully to data.txt" << endl;
+}
+
+//////---------------------------------------
+// نت‌لیست SPICE: زیرمجموعه R C L V I E F G H D با منابع SIN/PULSE/PWL/STREAM/AC و کارت‌های .tran .ac .dc .op
+namespace Netlist{
+    // کارت تحلیل با همان نام‌هایی که AnalyzeDialog استفاده می‌کند
+    struct AnalysisCard {
+        string type;            // "" | "OP" | "Transient" | "DC Sweep" | "AC Sweep"
+        string source;          // منبع DC Sweep
+        string sweep = "dec";   // نوع کارت .ac (dec, lin, oct)
+        vector<double> values;  // Transient: start stop step | DC: start stop step | AC: fStart fStop intervals
+    };
+
+    // مدار خوانده شده بدون شبکه گرافیکی: شبکه k با نام N0k و زمین با N00
+    struct NetlistCircuit {
+        string title;
+        vector<shared_ptr<Element>> elements;
+        vector<shared_ptr<Node>> nodes;      // نودهای همه پایانه‌ها (مثل Wire::allNodes)
+        vector<string> netNames;             // netNames[k] نام شبکه N0k در نت‌لیست است
+        AnalysisCard analysis;
+        vector<string> measures;             // کارت‌های .meas به همان شکل متن (برای Measurements::Session)
+        vector<string> steps;                // کارت‌های .step (برای Sweeps::Plan)
+        int componentId = 0;       // تعداد شبکه‌های غیر زمین
+        size_t lines = 0;
+    };
+
+    string lower(string_view s) {
+        string r(s);
+        for (char &c : r) c = (char)tolower((unsigned char)c);
+        return r;
+    }
+
+    // نت‌لیست با قواعد SPICE: M یعنی میلی و واحد بعد از پسوند (10uF) نادیده گرفته می‌شود
+    bool parseNumber(string_view s, double &out) {
+        return Units::parse(s, out, Units::Syntax::Spice);
+    }
+
+    string formatValue(double v) {
+        ostringstream ss;
+        ss << setprecision(12) << v;
+        return ss.str();
+    }
+
+    class Parser {
+    public:
+        NetlistCircuit parse(string_view text) {
+            c = NetlistCircuit();
+            netlistText = text;
+            netIndex.clear();
+            names.clear();
+            pending.clear();
+            c.netNames.push_back("0");
+            netIndex.emplace("0", 0);
+
+            vector<string_view> card;
+            size_t cardLine = 0;
+            size_t lineNo = 0;
+            size_t pos = 0;
+            bool ended = false;
+            while (pos < text.size() && !ended) {
+                size_t eol = text.find('\n', pos);
+                if (eol == string_view::npos) eol = text.size();
+                string_view line = text.substr(pos, eol - pos);
+                pos = eol + 1;
+                ++lineNo;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+                // خط اول نت‌لیست همیشه عنوان است
+                if (lineNo == 1) {
+                    c.title = string(line);
+                    continue;
+                }
+                size_t first = line.find_first_not_of(" \t");
+                if (first == string_view::npos || line[first] == '*') continue;
+                if (line[first] == '+') {
+                    if (card.empty()) throw netlistError(lineNo, "continuation line without a card");
+                    tokenize(line.substr(first + 1), card);
+                    continue;
+                }
+                if (!card.empty()) ended = processCard(card, cardLine);
+                card.clear();
+                cardLine = lineNo;
+                tokenize(line.substr(first), card);
+            }
+            if (!card.empty() && !ended) processCard(card, cardLine);
+            c.lines = lineNo;
+
+            // منابع وابسته به جریان بعد از تعریف همه المان‌ها ساخته می‌شوند
+            for (auto &p : pending) {
+                auto ctrl = names.find(p.control);
+                if (ctrl == names.end()) throw netlistError(p.line, "controlling element " + p.control + " not found");
+                shared_ptr<Element> control = c.elements[ctrl->second];
+                if (p.isVoltage)
+                    c.elements[p.index] = make_shared<CCVS>(0, 0, p.name, p.gain, control, p.n, p.p);
+                else
+                    c.elements[p.index] = make_shared<CCCS>(0, 0, p.name, p.gain, control, p.n, p.p);
+                c.elements[p.index]->value = p.value;
+            }
+            c.componentId = (int)c.netNames.size() - 1;
+            return c;
+        }
+
+    private:
+        struct PendingControlled {
+            size_t index;
+            size_t line;
+            bool isVoltage;
+            string name;
+            string control;
+            string value;
+            double gain;
+            shared_ptr<Node> n;
+            shared_ptr<Node> p;
+        };
+
+        NetlistCircuit c;
+        string_view netlistText;   // کل متن برای rawCard
+        unordered_map<string, size_t> netIndex;
+        unordered_map<string, size_t> names;
+        vector<PendingControlled> pending;
+
+        // جداکننده‌ها: فاصله، پرانتز، ویرگول و '='؛ بعد از ';' توضیح است
+        // متن کارت با = و پرانتزها تا پایان آخرین خط؛ خطوط + یک خط و توضیح‌های ; حذف می‌شوند
+        string rawCard(const vector<string_view> &t) const {
+            size_t begin = t.front().data() - netlistText.data();
+            size_t end = netlistText.find('\n', t.back().data() - netlistText.data());
+            if (end == string_view::npos) end = netlistText.size();
+            string r;
+            for (size_t i = begin; i < end; ++i) {
+                char ch = netlistText[i];
+                if (ch == ';') {
+                    while (i + 1 < end && netlistText[i + 1] != '\n') ++i;
+                    continue;
+                }
+                if (ch == '\n') {
+                    r += ' ';
+                    while (i + 1 < end && (netlistText[i + 1] == ' ' || netlistText[i + 1] == '\t')) ++i;
+                    if (i + 1 < end && netlistText[i + 1] == '+') ++i;
+                    continue;
+                }
+                if (ch != '\r') r += ch;
+            }
+            return r;
+        }
+
+        static void tokenize(string_view line, vector<string_view> &out) {
+            size_t i = 0;
+            while (i < line.size()) {
+                char ch = line[i];
+                if (ch == ';') return;
+                if (ch == ' ' || ch == '\t' || ch == '(' || ch == ')' || ch == ',' || ch == '=') {
+                    ++i;
+                    continue;
+                }
+                size_t start = i;
+                while (i < line.size()) {
+                    ch = line[i];
+                    if (ch == ' ' || ch == '\t' || ch == '(' || ch == ')' || ch == ',' || ch == '=' || ch == ';') break;
+                    ++i;
+                }
+                out.push_back(line.substr(start, i - start));
+            }
+        }
+
+        // مثل نودهای شبکه در رابط گرافیکی هر پایانه Node خودش را دارد و اتصال با نام یکسان (N0k) است
+        shared_ptr<Node> net(string_view name) {
+            string key(name);
+            if (key == "gnd" || key == "GND") key = "0";
+            size_t id;
+            auto it = netIndex.find(key);
+            if (it != netIndex.end()) id = it->second;
+            else {
+                id = c.netNames.size();
+                c.netNames.push_back(key);
+                netIndex.emplace(move(key), id);
+            }
+            auto node = make_shared<Node>();
+            node->name = "N0" + to_string(id);
+            node->setIsGround(id == 0);
+            c.nodes.push_back(node);
+            return node;
+        }
+
+        double number(string_view token, size_t line) {
+            double v;
+            if (!parseNumber(token, v)) throw netlistError(line, "invalid value " + string(token));
+            return v;
+        }
+
+        void addElement(shared_ptr<Element> e, const string &name) {
+            if (!names.emplace(name, c.elements.size()).second) throw duplicateElementName("Element", name);
+            c.elements.push_back(move(e));
+        }
+
+        static string join(const vector<string_view> &t, size_t from) {
+            string r;
+            for (size_t i = from; i < t.size(); ++i) {
+                if (i > from) r += ' ';
+                r += t[i];
+            }
+            return r;
+        }
+
+        // .end برگرداند true
+        bool processCard(const vector<string_view> &t, size_t line) {
+            string name(t[0]);
+            char kind = (char)toupper((unsigned char)name[0]);
+            if (kind == '.') return processControl(t, line);
+
+            auto need = [&](size_t n) {
+                if (t.size() < n) throw netlistError(line, name + " needs " + to_string(n - 1) + " fields");
+            };
+            switch (kind) {
+                case 'R':
+                case 'C':
+                case 'L': {
+                    need(4);
+                    double v = number(t[3], line);
+                    if (v <= 0) throw invalidValue(name);
+                    shared_ptr<Node> p = net(t[1]), n = net(t[2]);
+                    shared_ptr<Element> e;
+                    if (kind == 'R') e = make_shared<Resistor>(0, 0, name, v, n, p);
+                    else if (kind == 'C') e = make_shared<Capacitor>(0, 0, name, v, n, p);
+                    else e = make_shared<Inductor>(0, 0, name, v, n, p);
+                    e->value = string(t[3]);
+                    addElement(e, name);
+                    break;
+                }
+                case 'V':
+                case 'I':
+                    need(3);
+                    addElement(source(t, line, kind == 'V'), name);
+                    break;
+                case 'E':
+                case 'G': {
+                    need(6);
+                    double gain = number(t[5], line);
+                    shared_ptr<Node> p = net(t[1]), n = net(t[2]), cp = net(t[3]), cn = net(t[4]);
+                    shared_ptr<Element> e;
+                    if (kind == 'E') e = make_shared<VCVS>(0, 0, name, gain, cp, cn, n, p);
+                    else e = make_shared<VCCS>(0, 0, name, gain, cp, cn, n, p);
+                    e->value = string(kind == 'E' ? "VCVS" : "VCCS") + "(g: " + string(t[5]) + ",posN: " + string(t[3]) + ",negN:" + string(t[4]) + ")";
+                    addElement(e, name);
+                    break;
+                }
+                case 'F':
+                case 'H': {
+                    need(5);
+                    PendingControlled p;
+                    p.index = c.elements.size();
+                    p.line = line;
+                    p.isVoltage = (kind == 'H');
+                    p.name = name;
+                    p.control = string(t[3]);
+                    p.gain = number(t[4], line);
+                    p.p = net(t[1]);
+                    p.n = net(t[2]);
+                    p.value = string(kind == 'H' ? "CCVS" : "CCCS") + "(g: " + string(t[4]) + ",e: " + p.control + ")";
+                    pending.push_back(p);
+                    addElement(nullptr, name);
+                    break;
+                }
+                case 'D': {
+                    need(3);
+                    // مدل‌هایی که با Z شروع می‌شوند زنر هستند؛ بقیه دیود ایده‌آل
+                    string model = (t.size() > 3 && toupper((unsigned char)t[3][0]) == 'Z') ? "Z" : "D";
+                    shared_ptr<Node> anode = net(t[1]), cathode = net(t[2]);
+                    auto d = make_shared<Diode>(0, 0, name, model, model == "Z" ? 0.7 : 0.0, cathode, anode);
+                    d->value = model;
+                    addElement(d, name);
+                    break;
+                }
+                default:
+                    throw netlistError(line, "unsupported element " + name);
+            }
+            return false;
+        }
+
+        // V/I name n+ n- [DC] v [AC mag [phase]] [SIN(...) | PULSE(...) | PWL(...) | STREAM(file | tcp:host:port)]
+        shared_ptr<Element> source(const vector<string_view> &t, size_t line, bool voltage) {
+            string name(t[0]);
+            shared_ptr<Node> p = net(t[1]), n = net(t[2]);
+            double dc = 0, acMag = 0, acPhase = 0;
+            bool ac = false;
+            string shape, feed;
+            vector<double> args;
+            double v;
+            for (size_t i = 3; i < t.size(); ++i) {
+                string key = lower(t[i]);
+                if (key == "dc") {
+                    if (i + 1 < t.size()) dc = number(t[++i], line);
+                }
+                else if (key == "ac") {
+                    ac = true;
+                    acMag = 1;
+                    if (i + 1 < t.size() && parseNumber(t[i + 1], v)) { acMag = v; ++i; }
+                    if (i + 1 < t.size() && parseNumber(t[i + 1], v)) { acPhase = v; ++i; }
+                }
+                else if (key == "stream") {
+                    if (i + 1 >= t.size()) throw netlistError(line, name + ": STREAM needs a file or tcp:host:port");
+                    shape = key;
+                    feed = string(t[++i]);
+                }
+                else if (key == "sin" || key == "pulse" || key == "pwl") {
+                    shape = key;
+                    while (i + 1 < t.size() && parseNumber(t[i + 1], v)) {
+                        args.push_back(v);
+                        ++i;
+                    }
+                }
+                else if (parseNumber(t[i], v)) dc = v;
+                else throw netlistError(line, "unexpected token " + string(t[i]) + " in " + name);
+            }
+
+            shared_ptr<Element> e;
+            auto arg = [&args](size_t i, double def = 0.0) { return i < args.size() ? args[i] : def; };
+            if (shape == "sin") {
+                if (args.size() < 3) throw netlistError(line, name + ": SIN needs offset, amplitude and frequency");
+                if (voltage) e = make_shared<SinVoltageSource>(0, 0, name, args[0], args[1], args[2], n, p);
+                else e = make_shared<SinCurrentSource>(0, 0, name, args[0], args[1], args[2], n, p);
+            }
+            else if (shape == "pulse") {
+                if (args.size() < 2) throw netlistError(line, name + ": PULSE needs two levels");
+                // بدون دوره، پالس یک بار اتفاق می‌افتد (fmod با دوره صفر تعریف نشده است)
+                double period = arg(6) > 0 ? arg(6) : 1e30;
+                if (voltage)
+                    e = make_shared<PulseVoltageSource>(0, 0, name, args[0], args[1], arg(2), arg(3), arg(4), arg(5), period, arg(7), n, p);
+                else
+                    e = make_shared<PulseCurrentSource>(0, 0, name, args[0], args[1], arg(2), arg(3), arg(4), arg(5), period, arg(7), n, p);
+            }
+            else if (shape == "stream") {
+                if (!voltage) throw netlistError(line, name + ": STREAM current sources are not supported");
+                e = make_shared<StreamVoltageSource>(0, 0, name, feed, n, p);
+            }
+            else if (shape == "pwl") {
+                if (!voltage) throw netlistError(line, name + ": PWL current sources are not supported");
+                if (args.size() < 2 || args.size() % 2) throw netlistError(line, name + ": PWL needs time/value pairs");
+                vector<pair<double, double>> points;
+                for (size_t i = 0; i + 1 < args.size(); i += 2) points.emplace_back(args[i], args[i + 1]);
+                auto pwl = make_shared<PWLVoltageSource>(0, 0, name, "", n, p);
+                pwl->setTimeVoltagePairs(points);
+                e = pwl;
+            }
+            else if (ac && voltage) {
+                // موتور AC دامنه را از getValue و فاز را (رادیان) از phase می‌خواند
+                auto vs = make_shared<VoltageSource>(0, 0, name, acMag, n, p);
+                vs->isAcSource = true;
+                vs->phase = acPhase * M_PI / 180.0;
+                vs->AcValue = polar(acMag, vs->phase);
+                e = vs;
+            }
+            else if (voltage) e = make_shared<VoltageSource>(0, 0, name, dc, n, p);
+            else e = make_shared<CurrentSource>(0, 0, name, ac ? acMag : dc, n, p);
+            e->value = join(t, 3);
+            return e;
+        }
+
+        bool processControl(const vector<string_view> &t, size_t line) {
+            string card = lower(t[0]);
+            AnalysisCard &a = c.analysis;
+            if (card == ".end") return true;
+            if (card == ".op") {
+                a = AnalysisCard();
+                a.type = "OP";
+            }
+            else if (card == ".tran") {
+                // .tran tstep tstop [tstart]
+                if (t.size() < 3) throw netlistError(line, ".tran needs tstep and tstop");
+                a = AnalysisCard();
+                a.type = "Transient";
+                a.values = {t.size() > 3 ? number(t[3], line) : 0.0, number(t[2], line), number(t[1], line)};
+            }
+            else if (card == ".dc") {
+                // .dc source start stop step
+                if (t.size() < 5) throw netlistError(line, ".dc needs source, start, stop and step");
+                a = AnalysisCard();
+                a.type = "DC Sweep";
+                a.source = string(t[1]);
+                a.values = {number(t[2], line), number(t[3], line), number(t[4], line)};
+            }
+            else if (card == ".ac") {
+                // .ac dec|lin|oct points fstart fstop؛ موتور AC فقط جاروب خطی دارد پس تعداد کل بازه‌ها حساب می‌شود
+                if (t.size() < 5) throw netlistError(line, ".ac needs sweep type, points, fstart and fstop");
+                a = AnalysisCard();
+                a.type = "AC Sweep";
+                a.sweep = lower(t[1]);
+                double points = number(t[2], line), fStart = number(t[3], line), fStop = number(t[4], line);
+                if (points < 1 || fStart <= 0 || fStop < fStart) throw netlistError(line, "invalid .ac range");
+                double total = points - 1;
+                if (a.sweep == "dec") total = points * log10(fStop / fStart);
+                else if (a.sweep == "oct") total = points * log2(fStop / fStart);
+                else if (a.sweep != "lin") throw netlistError(line, "unknown .ac sweep " + string(t[1]));
+                a.values = {fStart, fStop, max(1.0, ceil(total - 1e-9))};
+            }
+            else if (card == ".title") c.title = join(t, 1);
+            else if (card == ".meas" || card == ".measure") c.measures.push_back(rawCard(t));
+            else if (card == ".step") c.steps.push_back(rawCard(t));
+            else if (card == ".subckt" || card == ".include" || card == ".inc" || card == ".lib") {
+                throw netlistError(line, card + " is not supported");
+            }
+            // بقیه کارت‌ها (.model، .options، .print و ...) روی این موتور اثری ندارند
+            return false;
+        }
+    };
+
+    NetlistCircuit parse(string_view text) {
+        Parser parser;
+        return parser.parse(text);
+    }
+
+    NetlistCircuit readFile(const string &path) {
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in.is_open()) throw netlistError(0, "cannot open " + path);
+        string text((size_t)in.tellg(), '\0');
+        in.seekg(0);
+        in.read(&text[0], text.size());
+        return parse(text);
+    }
+
+    // نام SPICE: حرف اول باید نوع المان را نشان دهد
+    string spiceName(const shared_ptr<Element> &e) {
+        char letter = 'X';
+        string type = e->getType();
+        if (type == "Resistor") letter = 'R';
+        else if (type == "Capacitor") letter = 'C';
+        else if (type == "Inductor") letter = 'L';
+        else if (type.rfind("Diode", 0) == 0) letter = 'D';
+        else if (type == "VCVS") letter = 'E';
+        else if (type == "CCCS") letter = 'F';
+        else if (type == "VCCS") letter = 'G';
+        else if (type == "CCVS") letter = 'H';
+        else if (dynamic_pointer_cast<VoltageSource>(e)) letter = 'V';
+        else if (dynamic_pointer_cast<CurrentSource>(e)) letter = 'I';
+        string name = e->getName();
+        if (name.empty() || toupper((unsigned char)name[0]) != letter) name = string(1, letter) + name;
+        return name;
+    }
+
+    string netName(const shared_ptr<Node> &node) {
+        if (!node) return "?";
+        if (node->getIsGround()) return "0";
+        string name = node->getName();
+        for (char &ch : name) {
+            if (ch == ' ' || ch == '\t' || ch == '(' || ch == ')' || ch == ',' || ch == '=') ch = '_';
+        }
+        return name;
+    }
+
+    string write(const vector<shared_ptr<Element>> &elements, const AnalysisCard &analysis, const vector<string> &measures = {},
+                 const vector<string> &steps = {}, const string &title = "CircuNet export") {
+        ostringstream out;
+        out << title << "\n";
+        for (auto &e : elements) {
+            string name = spiceName(e);
+            string nodes = netName(e->getNodeP()) + " " + netName(e->getNodeN());
+            if (dynamic_pointer_cast<deltaVoltageSource>(e) || dynamic_pointer_cast<deltaCurrentSource>(e)) {
+                out << "* " << name << ": impulse sources have no SPICE equivalent\n";
+            }
+            else if (auto d = dynamic_pointer_cast<Diode>(e)) {
+                out << name << " " << nodes << " " << (d->getType() == "DiodeZ" ? "ZMODEL" : "DMODEL") << "\n";
+            }
+            else if (auto s = dynamic_pointer_cast<CCVS>(e)) {
+                out << name << " " << nodes << " " << spiceName(s->getControlSourceName()) << " " << formatValue(s->getGain()) << "\n";
+            }
+            else if (auto s = dynamic_pointer_cast<CCCS>(e)) {
+                out << name << " " << nodes << " " << spiceName(s->getControlSourceName()) << " " << formatValue(s->getGain()) << "\n";
+            }
+            else if (auto s = dynamic_pointer_cast<VCVS>(e)) {
+                out << name << " " << nodes << " " << netName(s->getControlNodeP()) << " " << netName(s->getControlNodeN())
+                    << " " << formatValue(s->getGain()) << "\n";
+            }
+            else if (auto s = dynamic_pointer_cast<VCCS>(e)) {
+                out << name << " " << nodes << " " << netName(s->getControlNodeP()) << " " << netName(s->getControlNodeN())
+                    << " " << formatValue(s->getGain()) << "\n";
+            }
+            else if (auto s = dynamic_pointer_cast<SinVoltageSource>(e)) {
+                out << name << " " << nodes << " SIN(" << formatValue(s->getOffset()) << " " << formatValue(s->getAmplitude())
+                    << " " << formatValue(s->getFrequency()) << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<SinCurrentSource>(e)) {
+                out << name << " " << nodes << " SIN(" << formatValue(s->getOffset()) << " " << formatValue(s->getAmplitude())
+                    << " " << formatValue(s->getFrequency()) << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<PulseVoltageSource>(e)) {
+                out << name << " " << nodes << " PULSE(" << formatValue(s->getVinitial()) << " " << formatValue(s->getVon())
+                    << " " << formatValue(s->getTdelay()) << " " << formatValue(s->getTrise()) << " " << formatValue(s->getTfall())
+                    << " " << formatValue(s->getTon()) << " " << formatValue(s->getTperiod()) << " " << formatValue(s->getNcycles()) << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<PulseCurrentSource>(e)) {
+                out << name << " " << nodes << " PULSE(" << formatValue(s->getIinitial()) << " " << formatValue(s->getIon())
+                    << " " << formatValue(s->getTdelay()) << " " << formatValue(s->getTrise()) << " " << formatValue(s->getTfall())
+                    << " " << formatValue(s->getTon()) << " " << formatValue(s->getTperiod()) << " " << formatValue(s->getNcycles()) << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<StreamVoltageSource>(e)) {
+                out << name << " " << nodes << " STREAM(" << s->getSource() << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<PWLVoltageSource>(e)) {
+                out << name << " " << nodes << " PWL(";
+                bool first = true;
+                for (auto &point : s->getTimeVoltagePairs()) {
+                    out << (first ? "" : " ") << formatValue(point.first) << " " << formatValue(point.second);
+                    first = false;
+                }
+                out << ")\n";
+            }
+            else if (auto s = dynamic_pointer_cast<VoltageSource>(e)) {
+                if (s->isAcSource || s->isPhaseSource)
+                    out << name << " " << nodes << " AC " << formatValue(s->getValue()) << " " << formatValue(s->phase * 180.0 / M_PI) << "\n";
+                else
+                    out << name << " " << nodes << " DC " << formatValue(s->getValue()) << "\n";
+            }
+            else {
+                out << name << " " << nodes << " " << formatValue(e->getValue()) << "\n";
+            }
+        }
+        out << ".model DMODEL D\n.model ZMODEL D\n";
+        const vector<double> &v = analysis.values;
+        if (analysis.type == "OP") out << ".op\n";
+        else if (analysis.type == "Transient" && v.size() == 3)
+            out << ".tran " << formatValue(v[2]) << " " << formatValue(v[1]) << " " << formatValue(v[0]) << "\n";
+        else if (analysis.type == "DC Sweep" && v.size() == 3)
+            out << ".dc " << analysis.source << " " << formatValue(v[0]) << " " << formatValue(v[1]) << " " << formatValue(v[2]) << "\n";
+        else if (analysis.type == "AC Sweep" && v.size() == 3 && v[2] > 0)
+            out << ".ac lin " << (long long)ceil(v[2] - 1e-9) + 1 << " " << formatValue(v[0]) << " " << formatValue(v[1]) << "\n";
+        for (auto &m : measures) {
+            out << (lower(m).rfind(".meas", 0) == 0 ? "" : ".meas ") << m << "\n";
+        }
+        for (auto &st : steps) {
+            out << (lower(st).rfind(".step", 0) == 0 ? "" : ".step ") << st << "\n";
+        }
+        out << ".end\n";
+        return out.str();
+    }
+
+    bool writeFile(const string &path, const vector<shared_ptr<Element>> &elements, const AnalysisCard &analysis,
+                   const vector<string> &measures = {}, const vector<string> &steps = {}) {
+        ofstream out(path, ios::binary);
+        if (!out.is_open()) return false;
+        out << write(elements, analysis, measures, steps);
+        return true;
+    }
+
+    // المان‌ها را روی شبکه بوم می‌چیند؛ هر شبکه با LabelNet هم‌نام و زمین با GNDSymbol وصل می‌شود
+    void placeOnCanvas(NetlistCircuit &c, vector<shared_ptr<Element>> &elements, vector<shared_ptr<LabelNet>> &labels,
+                       vector<shared_ptr<GNDSymbol>> &gndSymbols, shared_ptr<TTF_Font> font) {
+        const int left = stepX * 6, top = stepY * 8;
+        const int colStep = stepX * 8, rowStep = stepY * 5;
+        const int cols = max(1, (WindowW - stepX * 20 - left) / colStep);
+        const int rows = max(1, (WindowH - stepY * 4 - top) / rowStep);
+        if ((int)(c.elements.size() + c.netNames.size()) > cols * rows)
+            throw netlistError(0, "circuit is too large for the canvas (" + to_string(c.elements.size()) + " elements)");
+
+        auto netOf = [](const shared_ptr<Node> &node) -> size_t {
+            return node->getIsGround() ? 0 : stoul(node->getName().substr(2));
+        };
+        vector<shared_ptr<Node>> anchor(c.netNames.size());
+
+        int slot = 0;
+        auto slotCenter = [&](int &x, int &y) {
+            x = left + (slot % cols) * colStep;
+            y = top + (slot / cols) * rowStep;
+            snapToGrid(x, y);
+            ++slot;
+        };
+        auto attach = [&](const shared_ptr<Node> &gridNode, size_t netId) {
+            if (!anchor[netId]) anchor[netId] = gridNode;
+            if (netId == 0) {
+                auto gnd = make_shared<GNDSymbol>();
+                gnd->isPlacing = false;
+                gnd->updatePosition(gridNode->x, gridNode->y);
+                gndSymbols.push_back(gnd);
+            }
+            else {
+                auto label = make_shared<LabelNet>(gridNode->x, gridNode->y, c.netNames[netId], font);
+                label->rect = {gridNode->x - 15, gridNode->y - 25, 30, 15};
+                label->baseRect = {gridNode->x - 5 + 1, gridNode->y - 5 + 1, 10, 10};
+                labels.push_back(label);
+            }
+        };
+
+        for (auto &e : c.elements) {
+            int x, y;
+            slotCenter(x, y);
+            shared_ptr<Node> leftNode = Wire::findNode(x - stepX * 2, y);
+            shared_ptr<Node> rightNode = Wire::findNode(x + stepX * 2, y);
+            if (!leftNode || !rightNode) throw netlistError(0, "canvas grid is not ready");
+            e->rect = {x + 1 - 30, y + 1 - 15, stepX * 4, stepY * 2};
+            // مثل addElement: در دیود آند سمت چپ است و در بقیه پایانه منفی
+            bool diode = dynamic_pointer_cast<Diode>(e) != nullptr;
+            size_t leftNet = netOf(diode ? e->getNodeP() : e->getNodeN());
+            size_t rightNet = netOf(diode ? e->getNodeN() : e->getNodeP());
+            attach(leftNode, leftNet);
+            attach(rightNode, rightNet);
+            if (diode) { e->setNodeP(leftNode); e->setNodeN(rightNode); }
+            else { e->setNodeN(leftNode); e->setNodeP(rightNode); }
+        }
+
+        // شبکه‌هایی که فقط کنترل منبع وابسته‌اند یک لیبل جدا روی بوم می‌گیرند
+        auto anchored = [&](const shared_ptr<Node> &netNode) {
+            size_t id = netOf(netNode);
+            if (!anchor[id]) {
+                int x, y;
+                slotCenter(x, y);
+                shared_ptr<Node> gridNode = Wire::findNode(x, y);
+                if (!gridNode) throw netlistError(0, "canvas grid is not ready");
+                attach(gridNode, id);
+            }
+            return anchor[id];
+        };
+        for (auto &e : c.elements) {
+            if (auto s = dynamic_pointer_cast<VCVS>(e)) s->setControlNodes(anchored(s->getControlNodeP()), anchored(s->getControlNodeN()));
+            else if (auto s = dynamic_pointer_cast<VCCS>(e)) s->setControlNodes(anchored(s->getControlNodeP()), anchored(s->getControlNodeN()));
+        }
+        elements.insert(elements.end(), c.elements.begin(), c.elements.end());
+    }
+
+    // کارت‌های .meas تحلیل نت‌لیست؛ بدون بوم نام شبکه‌ها N0k است و نام‌های نت‌لیست به آن تبدیل می‌شوند
+    Measurements::Session measuresFor(const NetlistCircuit &c) {
+        const AnalysisCard &a = c.analysis;
+        Measurements::Session measures;
+        for (auto &m : c.measures) measures.add(m);
+        measures = measures.forAnalysis(a.type == "Transient" ? "tran" : a.type == "AC Sweep" ? "ac" : "dc");
+        measures.renameSignals([&](const string &signal) {
+            if (signal[0] != 'V') return signal;
+            string target = measureTarget(signal);
+            for (size_t k = 0; k < c.netNames.size(); ++k) {
+                if (c.netNames[k] == target) return signal.substr(0, 2) + "N0" + to_string(k) + signal.substr(signal.find(')'));
+            }
+            return signal;
+        });
+        return measures;
+    }
+
+    // کارت تحلیل نت‌لیست بدون بوم (CircuNetBench --netlist و کارگر شبیه‌سازی)
+    // با .step: جاروب موازی گذرا روی pool و نوشتن data/sweep.csv؛ بدون آن یک اجرا که data/log.txt را می‌نویسد
+    vector<Sweeps::Run> run(NetlistCircuit &c, const Sweeps::Plan &plan, Measurements::Session &measures,
+                            Tasks::Pool &pool = Tasks::Pool::instance()) {
+        const AnalysisCard &a = c.analysis;
+        if (!plan.empty() && a.type != "Transient") throw runtime_error(".step needs a .tran card");
+        Wire::allNodes = c.nodes;
+        vector<shared_ptr<LabelNet>> labels;
+        Measurements::Session *measure = measures.empty() ? nullptr : &measures;
+        vector<Sweeps::Run> runs;
+        if (!plan.empty()) {
+            runs = sweepTransient(plan, measures, a.values[0], a.values[1], a.values[2], c.elements, pool);
+            Sweeps::writeCsv("data/sweep.csv", plan, runs);
+        }
+        else if (a.type == "Transient") {
+            analyzeTransient(a.values[0], a.values[1], a.values[2], Wire::allNodes, c.elements, measure);
+        }
+        else if (a.type == "DC Sweep") {
+            DCSweep(c.componentId, c.elements, a.source, formatValue(a.values[0]), formatValue(a.values[1]),
+                    formatValue(a.values[2]), labels);
+        }
+        else if (a.type == "AC Sweep") {
+            analyzeAc("dec", formatValue(a.values[0]), formatValue(a.values[1]), formatValue(a.values[2]),
+                      c.componentId, c.elements, labels, measure);
+        }
+        else if (a.type == "OP") {
+            messageBox opBox;
+            analyzeOp(opBox, c.componentId, c.elements, labels);
+        }
+        return runs;
+    }
+}
+
+//////---------------------------------------
+// کارگر شبیه‌سازی بدون پنجره (CircuNet --worker [port]): کلاینت مدار را به شکل نت‌لیست با کارت تحلیل می‌فرستد،
+// کارگر آن را مثل CircuNetBench --netlist روی هسته‌های خودش اجرا می‌کند و فایل نتیجه را تکه‌تکه برمی‌گرداند
+namespace Remote{
+    const size_t chunkSize = 256 * 1024;
+
+    // سرآیند سیگنال V(N0k) در فایل نتیجه به نام شبکه در نت‌لیست کلاینت برمی‌گردد تا با پروب‌های آن بخواند
+    string clientNames(const string &line, const vector<string> &netNames) {
+        if (line.compare(0, 4, "V(N0") != 0) return line;
+        size_t close = line.find(')', 4);
+        if (close == string::npos || close == 4) return line;
+        size_t net = 0;
+        for (size_t i = 4; i < close; ++i) {
+            if (!isdigit((unsigned char)line[i])) return line;
+            net = net * 10 + (size_t)(line[i] - '0');
+        }
+        if (net == 0 || net >= netNames.size()) return line;
+        return "V(" + netNames[net] + line.substr(close);
+    }
+
+    // کارها یکی‌یکی اجرا می‌شوند چون موتور تحلیل حالت سراسری دارد (Wire::allNodes و data/log.txt)؛
+    // موازی‌سازی داخل هر تحلیل (نقاط AC و اجراهای .step) روی Tasks::Pool است
+    class Worker {
+    public:
+        // تا پایان برنامه برنمی‌گردد مگر سرور باز نشود
+        int serve(int port) {
+            for (uint8_t type : {JobMessage, SweepMessage}) {
+                server.on(type, [this, type](Net::ClientId client, Net::Message &m) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    jobs.push_back({client, type, versionOf(m.payload), m.payload.size() >= 8 ? m.payload.substr(8) : string()});
+                    wake.notify_one();
+                });
+            }
+            server.onConnect([](Net::ClientId client) { std::cout << "Worker: client " << client << " connected\n"; });
+            if (!server.start(port)) {
+                std::cerr << "Worker: could not listen on port " << port << "\n";
+                return 1;
+            }
+            std::cout << "Worker: listening on port " << port << "\n";
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    wake.wait(lock, [this]() { return !jobs.empty(); });
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                if (job.type == SweepMessage) runBatch(job);
+                else run(job);
+            }
+        }
+
+    private:
+        struct Job {
+            Net::ClientId client = 0;
+            uint8_t type = JobMessage;
+            uint64_t id = 0;
+            string netlist;         // در SweepMessage بعد از اولین اجرا و تعداد
+        };
+
+        Net::Server server;
+        std::mutex mtx;
+        std::condition_variable wake;
+        std::deque<Job> jobs;
+
+        void run(const Job &job) {
+            auto start = chrono::steady_clock::now();
+            string status(1, '\0'), text;
             try {
-                std::vector<std::string> tokens = tokenize_expression(key);
-                std::vector<std::string> signal_names;
-                bool all_data_available = true;
-
-                for (const std::string& token : tokens) {
-                    if (token[0] == 'V' || token[0] == 'I') {
-                        if (std::find(signal_names.begin(), signal_names.end(), token) == signal_names.end()) {
-                            signal_names.push_back(token);
-                        }
+                Netlist::NetlistCircuit c = Netlist::parse(job.netlist);
+                if (c.analysis.type.empty()) throw runtime_error("netlist has no analysis card");
+                Measurements::Session measures = Netlist::measuresFor(c);
+                Sweeps::Plan plan;
+                for (auto &st : c.steps) plan.add(st);
+                vector<Sweeps::Run> runs = Netlist::run(c, plan, measures);
+                if (plan.empty()) {
+                    stream(job, "data/log.txt", c.netNames);
+                    if (!measures.empty()) text = measures.summary();
+                }
+                else {
+                    stream(job, "data/sweep.csv", {});
+                    text = Sweeps::summary(runs);
+                }
+                std::cout << "Worker: job " << job.id << " (" << c.analysis.type << ") done in "
+                          << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms\n";
+            }
+            catch (const exception &e) {
+                status[0] = 1;
+                text = e.what();
+                std::cerr << "Worker: job " << job.id << " failed: " << text << "\n";
+            }
+            server.send(job.client, JobDoneMessage, versioned(job.id, status + text));
+        }
+
+        // یک دسته از اجراهای .step برای SweepCoordinator؛ نتیجه به جای فایل، خود اجراها
+        void runBatch(const Job &job) {
+            try {
+                if (job.netlist.size() < 16) throw runtime_error("bad sweep batch");
+                uint64_t first = versionOf(job.netlist), count = versionOf(job.netlist.substr(8));
+                Netlist::NetlistCircuit c = Netlist::parse(string_view(job.netlist).substr(16));
+                Sweeps::Plan plan;
+                for (auto &st : c.steps) plan.add(st);
+                const Netlist::AnalysisCard &a = c.analysis;
+                if (plan.empty() || a.type != "Transient") throw runtime_error("distributed sweep needs .step and .tran cards");
+                Wire::allNodes = c.nodes;
+                vector<Sweeps::Run> runs = sweepTransient(plan, Netlist::measuresFor(c), a.values[0], a.values[1], a.values[2],
+                                                          c.elements, Tasks::Pool::instance(), (size_t)first, (size_t)count);
+                server.send(job.client, RunsMessage, versioned(job.id, Sweeps::encode(runs)));
+            }
+            catch (const exception &e) {
+                std::cerr << "Worker: sweep batch " << job.id << " failed: " << e.what() << "\n";
+                server.send(job.client, JobDoneMessage, versioned(job.id, string(1, '\1') + e.what()));
+            }
+        }
+
+        // فایل نتیجه خط به خط و در تکه‌های chunkSize؛ netNames خالی یعنی بدون تبدیل نام شبکه
+        void stream(const Job &job, const string &path, const vector<string> &netNames) {
+            ifstream in(path, ios::binary);
+            string chunk, line;
+            while (getline(in, line)) {
+                chunk += netNames.empty() ? line : clientNames(line, netNames);
+                chunk += '\n';
+                if (chunk.size() >= chunkSize) {
+                    server.send(job.client, ResultMessage, versioned(job.id, chunk));
+                    chunk.clear();
+                }
+            }
+            if (!chunk.empty()) server.send(job.client, ResultMessage, versioned(job.id, chunk));
+        }
+    };
+
+    // جاروب .step روی چند کارگر: اجراها دسته‌دسته پخش می‌شوند و هر کارگر صف دسته‌های خودش را دارد؛ کارگری که صفش
+    // تمام شود از انتهای صف پرترین کارگر برمی‌دارد (work stealing). دسته‌های کارگری که قطع شود به بقیه داده می‌شود
+    // (هر دسته حداکثر maxAttempts بار). نتیجه همان جاروب محلی است چون مقدار هر اجرا فقط به seed و شماره اجرا بستگی دارد
+    class SweepCoordinator {
+    public:
+        struct Endpoint {
+            string host;
+            int port = WORKER_PORT;
+        };
+
+        struct Report {
+            size_t batches = 0, stolen = 0, retried = 0, workersLost = 0;
+        };
+
+        const size_t maxAttempts = 3;
+        const size_t pipeline = 2;      // دسته‌های در راه هر کارگر تا کارگر بین دو دسته بیکار نماند
+        // کارگری که این مدت بعد از پاسخ قبلی (یا ارسال دسته) چیزی نفرستد مثل قطع شده حساب می‌شود،
+        // تا کارگر متصل ولی گیر کرده run را برای همیشه معطل نکند
+        std::chrono::milliseconds batchTimeout = std::chrono::minutes(2);
+
+        // "host:port,host" (پورت پیش‌فرض WORKER_PORT)
+        static vector<Endpoint> endpoints(const string &list) {
+            vector<Endpoint> result;
+            for (const string &item : split(list, ',')) {
+                if (item.empty()) continue;
+                Endpoint e;
+                size_t colon = item.find(':');
+                e.host = item.substr(0, colon);
+                if (colon != string::npos) e.port = stoi(item.substr(colon + 1));
+                result.push_back(e);
+            }
+            return result;
+        }
+
+        // batchSize صفر یعنی حدود ۱۶ دسته برای هر کارگر؛ اجرای دسته‌ای که هیچ کارگری تمامش نکند error دارد
+        vector<Sweeps::Run> run(const string &netlist, const vector<Endpoint> &workers, size_t batchSize = 0) {
+            Netlist::NetlistCircuit c = Netlist::parse(netlist);
+            plan = Sweeps::Plan();
+            for (auto &st : c.steps) plan.add(st);
+            if (plan.empty() || c.analysis.type != "Transient") throw runtime_error("distributed sweep needs .step and .tran cards");
+            if (workers.empty()) throw runtime_error("no sweep workers");
+            nominal = sweepNominal(plan, c.elements);
+
+            size_t total = plan.size();
+            if (!batchSize) batchSize = max<size_t>(1, total / (workers.size() * 16));
+            batches.clear();
+            for (size_t first = 0; first < total; first += batchSize) batches.push_back({first, min(batchSize, total - first)});
+            // پخش اولیه: بخش پیوسته برابر برای هر کارگر
+            queues.assign(workers.size(), deque<size_t>());
+            for (size_t b = 0; b < batches.size(); ++b) queues[b * workers.size() / batches.size()].push_back(b);
+            alive.assign(workers.size(), true);
+            retry.clear();
+            runs.assign(total, Sweeps::Run());
+            remaining = batches.size();
+            stats = Report();
+
+            vector<std::thread> threads;
+            for (size_t w = 0; w < workers.size(); ++w) threads.emplace_back([this, w, &workers, &netlist]() { serve(w, workers[w], netlist); });
+            for (auto &t : threads) t.join();
+            return runs;
+        }
+
+        const Report &report() const { return stats; }
+
+    private:
+        struct Batch {
+            size_t first = 0, count = 0;
+            size_t attempts = 0;
+        };
+
+        std::mutex mtx;
+        std::condition_variable changed;
+        Sweeps::Plan plan;
+        vector<double> nominal;
+        vector<Batch> batches;              // بعد از شروع فقط attempts (زیر قفل) تغییر می‌کند
+        vector<deque<size_t>> queues;       // دسته‌های هر کارگر
+        vector<bool> alive;
+        deque<size_t> retry;                // دسته‌های کارگرهای قطع شده
+        vector<Sweeps::Run> runs;
+        size_t remaining = 0;
+        Report stats;
+
+        // یک رشته برای هر کارگر؛ کارگر دسته‌ها را به ترتیب رسیدن اجرا می‌کند
+        void serve(size_t w, const Endpoint &endpoint, const string &netlist) {
+            Net::Client client;
+            client.setReceiveTimeout(batchTimeout);
+            deque<size_t> inFlight;
+            if (!client.connect(endpoint.host, endpoint.port)) {
+                std::cerr << "Coordinator: could not reach worker " << endpoint.host << ":" << endpoint.port << "\n";
+                lost(w, inFlight);
+                return;
+            }
+            while (true) {
+                size_t b;
+                while (inFlight.size() < pipeline && next(w, inFlight.empty(), b)) {
+                    inFlight.push_back(b);
+                    const Batch &batch = batches[b];
+                    if (!client.send(SweepMessage, versioned(b, versioned(batch.first, versioned(batch.count, netlist))))) break;
+                }
+                if (inFlight.empty()) return;
+                Net::Message m;
+                if (!client.connected() || !client.receive(m)) {
+                    std::cerr << "Coordinator: lost worker " << endpoint.host << ":" << endpoint.port
+                              << " (disconnected or no reply in " << batchTimeout.count() / 1000 << " s)\n";
+                    lost(w, inFlight);
+                    return;
+                }
+                if (m.payload.size() < 8) continue;
+                auto it = find(inFlight.begin(), inFlight.end(), (size_t)versionOf(m.payload));
+                if (it == inFlight.end()) continue;
+                b = *it;
+                inFlight.erase(it);
+                if (m.type == RunsMessage) {
+                    vector<Sweeps::Run> got;
+                    try {
+                        got = Sweeps::decode(m.payload.substr(8));
+                    }
+                    catch (const exception &) {
+                        got.clear();
                     }
+                    if (got.size() == batches[b].count) complete(b, std::move(got));
+                    else fail(b, "bad results from worker");
+                }
+                else if (m.type == JobDoneMessage) fail(b, m.payload.size() > 9 ? m.payload.substr(9) : "worker error");
+            }
+        }
+
+        // دسته بعدی: اول صف خودش، بعد دسته‌های کارگرهای قطع شده، بعد انتهای پرترین صف؛ wait یعنی تا پیدا شدن کار یا پایان جاروب صبر کند
+        bool next(size_t w, bool wait, size_t &b) {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true) {
+                if (!queues[w].empty()) {
+                    b = queues[w].front();
+                    queues[w].pop_front();
+                    return true;
+                }
+                if (!retry.empty()) {
+                    b = retry.front();
+                    retry.pop_front();
+                    return true;
+                }
+                size_t victim = w;
+                for (size_t v = 0; v < queues.size(); ++v) {
+                    if (queues[v].size() > queues[victim].size()) victim = v;
+                }
+                if (!queues[victim].empty()) {
+                    b = queues[victim].back();
+                    queues[victim].pop_back();
+                    ++stats.stolen;
+                    return true;
+                }
+                if (!wait || remaining == 0) return false;
+                changed.wait(lock);
+            }
+        }
+
+        void complete(size_t b, vector<Sweeps::Run> got) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (size_t i = 0; i < got.size(); ++i) runs[batches[b].first + i] = std::move(got[i]);
+            ++stats.batches;
+            --remaining;
+            changed.notify_all();
+        }
+
+        void fail(size_t b, const string &error) {
+            std::lock_guard<std::mutex> lock(mtx);
+            failLocked(b, error);
+            changed.notify_all();
+        }
+
+        void failLocked(size_t b, const string &error) {
+            for (size_t i = 0; i < batches[b].count; ++i) {
+                Sweeps::Run &run = runs[batches[b].first + i];
+                run.values = plan.point(batches[b].first + i, nominal);
+                run.error = error;
+            }
+            --remaining;
+        }
+
+        // دسته‌های در راه و صف کارگر قطع شده به بقیه می‌رسد؛ بدون هیچ کارگر زنده همه دسته‌های باقی‌مانده خطا می‌گیرند
+        void lost(size_t w, deque<size_t> &inFlight) {
+            std::lock_guard<std::mutex> lock(mtx);
+            alive[w] = false;
+            ++stats.workersLost;
+            bool anyAlive = find(alive.begin(), alive.end(), true) != alive.end();
+            for (size_t b : inFlight) {
+                if (++batches[b].attempts >= maxAttempts || !anyAlive) failLocked(b, "worker lost");
+                else {
+                    retry.push_back(b);
+                    ++stats.retried;
                 }
+            }
+            inFlight.clear();
+            retry.insert(retry.end(), queues[w].begin(), queues[w].end());
+            queues[w].clear();
+            if (!anyAlive) {
+                for (size_t b : retry) failLocked(b, "no sweep workers left");
+                retry.clear();
+                for (auto &q : queues) {
+                    for (size_t b : q) failLocked(b, "no sweep workers left");
+                    q.clear();
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    // سمت رابط گرافیکی: کار روی رشته جدا فرستاده و نتیجه در فایل موقت نوشته می‌شود؛ حلقه اصلی با take نتیجه را می‌گیرد
+    class WorkerClient {
+    public:
+        struct Outcome {
+            bool ok = false;
+            string text;            // خلاصه .meas/جاروب یا پیام خطا
+            string resultPath;      // فایل موقت محتوای data/log.txt (یا data/sweep.csv)
+            size_t bytes = 0;
+        };
+
+        ~WorkerClient() { cancel(); }
+
+        bool busy() const { return current && !current->finished; }
+
+        // اتصال و کار روی رشته جدا (مثل Follower)، پس رابط منتظر کارگر نمی‌ماند؛ کار قبلی رها می‌شود.
+        // کارگر در دسترس نبودن هم به صورت Outcome ناموفق به take می‌رسد
+        void submit(const string &host, int port, const string &netlist, const string &resultPath) {
+            cancel();
+            auto job = std::make_shared<Job>();
+            job->id = ++jobId;
+            current = job;
+            std::thread([job, host, port, netlist, resultPath]() {
+                Outcome outcome;
+                outcome.resultPath = resultPath;
+                bool ok = job->client.connect(host, port) && job->client.send(JobMessage, versioned(job->id, netlist));
+                if (!ok) std::cerr << "Client: could not reach worker " << host << ":" << port << "\n";
+                outcome.text = ok ? "worker connection lost" : "could not reach worker " + host + ":" + to_string(port);
+                {
+                    std::lock_guard<std::mutex> lock(job->mtx);
+                    job->open = ok = ok && !job->cancelled;
+                }
+                ofstream out;
+                if (ok) out.open(resultPath, ios::binary | ios::trunc);
+                Net::Message m;
+                while (out.is_open() && job->client.receive(m)) {
+                    if (m.payload.size() < 8 || versionOf(m.payload) != job->id) continue;
+                    if (m.type == ResultMessage) {
+                        out.write(m.payload.data() + 8, (streamsize)(m.payload.size() - 8));
+                        outcome.bytes += m.payload.size() - 8;
+                    }
+                    else if (m.type == JobDoneMessage && m.payload.size() >= 9) {
+                        outcome.ok = m.payload[8] == 0 && (bool)out.flush();
+                        outcome.text = m.payload.substr(9);
+                        break;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(job->mtx);
+                job->open = false;
+                job->client.close();
+                job->outcome = std::move(outcome);
+                job->finished = true;
+            }).detach();
+        }
+
+        // کار در حال اجرا رها می‌شود؛ کارگر نتیجه را به اتصال بسته شده نمی‌فرستد
+        void cancel() {
+            if (current) {
+                std::lock_guard<std::mutex> lock(current->mtx);
+                current->cancelled = true;
+                if (current->open) current->client.shutdown();
+            }
+            current.reset();
+        }
+
+        bool take(Outcome &outcome) {
+            if (!current || !current->finished) return false;
+            std::shared_ptr<Job> job = std::move(current);
+            std::lock_guard<std::mutex> lock(job->mtx);
+            outcome = std::move(job->outcome);
+            return true;
+        }
+
+    private:
+        struct Job {
+            uint64_t id = 0;
+            Net::Client client;
+            std::mutex mtx;
+            std::atomic<bool> finished{false};
+            bool open = false;
+            bool cancelled = false;
+            Outcome outcome;
+        };
+        std::shared_ptr<Job> current;
+        uint64_t jobId = 0;
+    };
+}
+
+//////---------------------------------------
+// بنچمارک موتور تحلیل (فقط در بیلد CircuNetBench)
+#ifdef CIRCUNET_BENCHMARK
+namespace Benchmark{
+    using BenchClock = chrono::steady_clock;
+
+    double elapsedMs(BenchClock::time_point start) {
+        return chrono::duration<double, milli>(BenchClock::now() - start).count();
+    }
+
+    struct BenchConfig {
+        vector<int> sizes{10, 50, 100};
+        int tranSteps = 200;
+        int acPoints = 100;
+        int dcPoints = 50;
+        int repeat = 5;
+        string outPath = "benchmark.json";
+        string tracePath;
+        string netlistPath;
+        bool saveProbesOnly = false;    // --save probes: فقط سیگنال‌های پروب در log.txt
+        unsigned threads = 0;           // --threads: رشته‌های Tasks::Pool برای جاروب .step (0 یعنی همه هسته‌ها)
+        string workers;                 // --workers host:port,...: جاروب .step روی کارگرهای شبیه‌سازی به جای این پردازه
+        int batchTimeout = 120;         // --batch-timeout: ثانیه‌های انتظار برای پاسخ کارگر قبل از حساب کردن آن به عنوان قطع شده
+    };
+
+    // مدار تولید شده: هر ترمینال المان یک Node جدا با نام شبکه دارد (مثل نودهای شبکه در رابط گرافیکی)
+    struct BenchCircuit {
+        string kind;
+        int size = 0;
+        bool linear = true;
+        int componentId = 0;
+        vector<shared_ptr<Element>> elements;
+        vector<shared_ptr<Node>> nodes;
+        vector<string> probes;
+
+        shared_ptr<Node> terminal(int net) {
+            auto node = make_shared<Node>();
+            node->name = "N0" + to_string(net);
+            node->setIsGround(net == 0);
+            nodes.push_back(node);
+            componentId = max(componentId, net);
+            return node;
+        }
+    };
+
+    struct BenchResult {
+        string kind;
+        int size = 0;
+        size_t elements = 0;
+        int nets = 0;
+        int matrixSize = 0;
+        double buildMs = 0;
+        double factorMs = 0;
+        double tranMs = 0;
+        double tranStepsPerSec = 0;
+        double acMs = -1;
+        double acPointsPerSec = -1;
+        double dcMs = -1;
+        double dcPointsPerSec = -1;
+        double ioMs = 0;
+        long long logBytes = 0;
+    };
+
+    // نردبان RC با n طبقه: V1 -> R1 -> (C1 به زمین) -> R2 -> ...
+    BenchCircuit rcLadder(int n) {
+        BenchCircuit c;
+        c.kind = "rc_ladder";
+        c.size = n;
+        c.elements.push_back(make_shared<VoltageSource>(0, 0, "V1", 1.0, c.terminal(0), c.terminal(1)));
+        for (int k = 1; k <= n; ++k) {
+            c.elements.push_back(make_shared<Resistor>(0, 0, "R" + to_string(k), 1e3, c.terminal(k), c.terminal(k + 1)));
+            c.elements.push_back(make_shared<Capacitor>(0, 0, "C" + to_string(k), 1e-6, c.terminal(0), c.terminal(k + 1)));
+        }
+        c.probes = {"V(N02)", "V(N0" + to_string(n + 1) + ")", "I(R1)"};
+        return c;
+    }
+
+    // شبکه مقاومتی side*side با منبع در یک گوشه و بار در گوشه مقابل
+    BenchCircuit resistorMesh(int n) {
+        BenchCircuit c;
+        c.kind = "resistor_mesh";
+        c.size = n;
+        int side = max(2, (int)ceil(sqrt((double)n)));
+        auto net = [side](int r, int col) { return r * side + col + 1; };
+        int count = 0;
+        for (int r = 0; r < side; ++r) {
+            for (int col = 0; col < side; ++col) {
+                if (col + 1 < side)
+                    c.elements.push_back(make_shared<Resistor>(0, 0, "R" + to_string(++count), 100.0,
+                                                               c.terminal(net(r, col)), c.terminal(net(r, col + 1))));
+                if (r + 1 < side)
+                    c.elements.push_back(make_shared<Resistor>(0, 0, "R" + to_string(++count), 100.0,
+                                                               c.terminal(net(r, col)), c.terminal(net(r + 1, col))));
+            }
+        }
+        int last = net(side - 1, side - 1);
+        c.elements.push_back(make_shared<VoltageSource>(0, 0, "V1", 5.0, c.terminal(0), c.terminal(net(0, 0))));
+        c.elements.push_back(make_shared<Resistor>(0, 0, "RL", 1e3, c.terminal(0), c.terminal(last)));
+        c.probes = {"V(N0" + to_string(last) + ")", "I(RL)", "P(RL)"};
+        return c;
+    }
+
+    // n پل دیودی موازی که از یک منبع سینوسی تغذیه می‌شوند
+    BenchCircuit diodeBridge(int n) {
+        BenchCircuit c;
+        c.kind = "diode_bridge";
+        c.size = n;
+        c.linear = false;
+        c.elements.push_back(make_shared<SinVoltageSource>(0, 0, "V1", 0.0, 10.0, 50.0, c.terminal(0), c.terminal(1)));
+        for (int k = 0; k < n; ++k) {
+            int outP = 2 + 2 * k, outN = 3 + 2 * k;
+            string id = to_string(k + 1);
+            c.elements.push_back(make_shared<Diode>(0, 0, "D" + id + "a", "D", 0.7, c.terminal(outP), c.terminal(1)));
+            c.elements.push_back(make_shared<Diode>(0, 0, "D" + id + "b", "D", 0.7, c.terminal(outP), c.terminal(0)));
+            c.elements.push_back(make_shared<Diode>(0, 0, "D" + id + "c", "D", 0.7, c.terminal(1), c.terminal(outN)));
+            c.elements.push_back(make_shared<Diode>(0, 0, "D" + id + "d", "D", 0.7, c.terminal(0), c.terminal(outN)));
+            c.elements.push_back(make_shared<Resistor>(0, 0, "RL" + id, 1e3, c.terminal(outN), c.terminal(outP)));
+            c.elements.push_back(make_shared<Resistor>(0, 0, "RB" + id, 1e6, c.terminal(0), c.terminal(outN)));
+        }
+        c.probes = {"V(N02)-V(N03)", "I(RL1)"};
+        return c;
+    }
+
+    // زنجیره n طبقه VCVS که هر طبقه ولتاژ طبقه قبل را کنترل می‌کند
+    BenchCircuit dependentChain(int n) {
+        BenchCircuit c;
+        c.kind = "dependent_chain";
+        c.size = n;
+        c.elements.push_back(make_shared<VoltageSource>(0, 0, "V1", 1.0, c.terminal(0), c.terminal(1)));
+        c.elements.push_back(make_shared<Resistor>(0, 0, "R0", 1e3, c.terminal(0), c.terminal(1)));
+        for (int k = 1; k <= n; ++k) {
+            string id = to_string(k);
+            c.elements.push_back(make_shared<VCVS>(0, 0, "E" + id, 1.0, c.terminal(k), c.terminal(0),
+                                                   c.terminal(0), c.terminal(k + 1)));
+            c.elements.push_back(make_shared<Resistor>(0, 0, "R" + id, 1e3, c.terminal(0), c.terminal(k + 1)));
+        }
+        c.probes = {"V(N0" + to_string(n + 1) + ")", "I(R1)"};
+        return c;
+    }
+
+    // ماتریس MNA چگال مشابه یک گام transient (دیودها روشن فرض می‌شوند)
+    vector<vector<double>> stampDense(BenchCircuit &c, double step) {
+        map<string, int> nodeIndex;
+        for (auto &node : c.nodes) {
+            if (!node->getIsGround() && !nodeIndex.count(node->getName())) {
+                int next = (int)nodeIndex.size();
+                nodeIndex[node->getName()] = next;
+            }
+        }
+        int n = nodeIndex.size();
+        int m = 0;
+        for (auto &e : c.elements) {
+            if (dynamic_pointer_cast<VoltageSource>(e) || dynamic_pointer_cast<Diode>(e)) m++;
+        }
+        vector<vector<double>> A(n + m, vector<double>(n + m, 0.0));
+        auto indexOf = [&nodeIndex](const shared_ptr<Node> &node) {
+            return node->getIsGround() ? -1 : nodeIndex.at(node->getName());
+        };
+        int k = n;
+        for (auto &e : c.elements) {
+            int pi = indexOf(e->getNodeP());
+            int ni = indexOf(e->getNodeN());
+            double g = 0.0;
+            if (e->getType() == "Resistor") g = 1.0 / e->getValue();
+            else if (e->getType() == "Capacitor") g = e->getValue() / step;
+            if (g != 0.0) {
+                if (pi != -1) A[pi][pi] += g;
+                if (ni != -1) A[ni][ni] += g;
+                if (pi != -1 && ni != -1) { A[pi][ni] -= g; A[ni][pi] -= g; }
+            }
+            if (dynamic_pointer_cast<VoltageSource>(e) || dynamic_pointer_cast<Diode>(e)) {
+                if (pi != -1) { A[pi][k] = 1; A[k][pi] = 1; }
+                if (ni != -1) { A[ni][k] = -1; A[k][ni] = -1; }
+                if (auto vcvs = dynamic_pointer_cast<VCVS>(e)) {
+                    int cpi = indexOf(vcvs->getControlNodeP());
+                    int cni = indexOf(vcvs->getControlNodeN());
+                    if (cpi != -1) A[k][cpi] -= vcvs->getGain();
+                    if (cni != -1) A[k][cni] += vcvs->getGain();
+                }
+                k++;
+            }
+        }
+        return A;
+    }
 
-                for (const std::string& name : signal_names) {
-                    std::string mapped_key = map_signal_key(name); // نگاشت نام به کلید data_map
-                    if (data_map.find(mapped_key) == data_map.end() && name != "V(N00)") {
-                        std::cerr << "Warning: In expression '" << key << "', data for '" << name << "' (mapped to '" << mapped_key << "') not found. Skipping expression." << std::endl;
-                        all_data_available = false;
-                        break;
-                    }
-                }
+    long long fileSize(const string &path) {
+        ifstream in(path, ios::binary | ios::ate);
+        return in.is_open() ? (long long)in.tellg() : 0;
+    }
 
-                if (!all_data_available) continue;
-                if (data_map.empty()) {
-                    std::cerr << "Warning: Cannot process expression '" << key << "' because log data is empty." << std::endl;
-                    continue;
-                }
+    BenchResult runCircuit(BenchCircuit (*generate)(int), int size, const BenchConfig &cfg) {
+        BenchResult r;
+        const double step = 1e-5;
+
+        auto t0 = BenchClock::now();
+        BenchCircuit c = generate(size);
+        Wire::allNodes = c.nodes;
+        r.buildMs = elapsedMs(t0);
+
+        r.kind = c.kind;
+        r.size = c.size;
+        r.elements = c.elements.size();
+        r.nets = c.componentId;
+
+        // فاکتورگیری: میانگین چند بار حل روی کپی ماتریس
+        vector<vector<double>> A = stampDense(c, step);
+        r.matrixSize = A.size();
+        vector<double> rhs(A.size(), 1.0);
+        t0 = BenchClock::now();
+        for (int i = 0; i < cfg.repeat; ++i) {
+            vector<vector<double>> copyA = A;
+            vector<double> copyZ = rhs;
+            solveLinearSystem(copyA, copyZ);
+        }
+        r.factorMs = elapsedMs(t0) / max(1, cfg.repeat);
+
+        string probeExpressions;
+        for (auto &p : c.probes) probeExpressions += p + "\n";
+        SaveList save = cfg.saveProbesOnly ? saveListFromProbes(probeExpressions, c.elements) : SaveList();
+
+        t0 = BenchClock::now();
+        analyzeTransient(0, step * cfg.tranSteps, step, Wire::allNodes, c.elements, nullptr, &save);
+        r.tranMs = elapsedMs(t0);
+        r.tranStepsPerSec = (cfg.tranSteps + 1) / (r.tranMs / 1000.0);
+        r.logBytes = fileSize("data/log.txt");
+
+        // خواندن نتایج و ارزیابی پروب‌ها
+        t0 = BenchClock::now();
+        extract_data(probeExpressions, c.elements);
+        r.ioMs = elapsedMs(t0);
+
+        // تحلیل‌های AC و DC برای مدار دیودی (با 2^n حالت) اجرا نمی‌شوند
+        if (c.linear) {
+            vector<shared_ptr<LabelNet>> labels;
+            t0 = BenchClock::now();
+            analyzeAc("dec", "1", "1k", to_string(cfg.acPoints), c.componentId, c.elements, labels);
+            r.acMs = elapsedMs(t0);
+            r.acPointsPerSec = (cfg.acPoints + 1) / (r.acMs / 1000.0);
+
+            t0 = BenchClock::now();
+            DCSweep(c.componentId, c.elements, "V1", "0", "10", to_string(10.0 / cfg.dcPoints), labels, &save);
+            r.dcMs = elapsedMs(t0);
+            r.dcPointsPerSec = (cfg.dcPoints + 1) / (r.dcMs / 1000.0);
+        }
+        return r;
+    }
 
-                std::vector<std::string> postfix_tokens = infix_to_postfix(tokens);
-                size_t num_points = data_map.begin()->second.size();
-                data_file << key << '\n';
+    void writeJson(ostream &out, const BenchConfig &cfg, const vector<BenchResult> &results) {
+        out << fixed << setprecision(4);
+        out << "{\n";
+        out << "  \"benchmark\": \"CircuNet\",\n";
+        out << "  \"config\": {\"tran_steps\": " << cfg.tranSteps << ", \"ac_points\": " << cfg.acPoints
+            << ", \"dc_points\": " << cfg.dcPoints << ", \"repeat\": " << cfg.repeat
+            << ", \"save\": \"" << (cfg.saveProbesOnly ? "probes" : "all") << "\"},\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult &r = results[i];
+            out << "    {\"circuit\": \"" << r.kind << "\", \"size\": " << r.size
+                << ", \"elements\": " << r.elements << ", \"nets\": " << r.nets
+                << ", \"matrix_size\": " << r.matrixSize
+                << ", \"build_ms\": " << r.buildMs
+                << ", \"factor_ms\": " << r.factorMs
+                << ", \"tran_ms\": " << r.tranMs
+                << ", \"tran_steps_per_sec\": " << r.tranStepsPerSec;
+            if (r.acMs >= 0)
+                out << ", \"ac_ms\": " << r.acMs << ", \"ac_points_per_sec\": " << r.acPointsPerSec;
+            if (r.dcMs >= 0)
+                out << ", \"dc_ms\": " << r.dcMs << ", \"dc_points_per_sec\": " << r.dcPointsPerSec;
+            out << ", \"io_ms\": " << r.ioMs << ", \"log_bytes\": " << r.logBytes << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
 
-                for (size_t i = 0; i < num_points; ++i) {
-                    std::map<std::string, double> current_values;
-                    double t, val;
+    // --netlist: زمان خواندن نت‌لیست و اجرای کارت تحلیل آن به جای مدارهای تولیدی
+    int runNetlist(const BenchConfig &cfg) {
+        auto t0 = BenchClock::now();
+        Netlist::NetlistCircuit c = Netlist::readFile(cfg.netlistPath);
+        double parseMs = elapsedMs(t0);
+        const Netlist::AnalysisCard &a = c.analysis;
+
+        // کارت‌های .meas همین تحلیل و کارت‌های .step (جاروب موازی تحلیل گذرا به جای یک اجرا)
+        Measurements::Session measures = Netlist::measuresFor(c);
+        Measurements::Session *measure = measures.empty() ? nullptr : &measures;
+        Sweeps::Plan plan;
+        for (auto &st : c.steps) plan.add(st);
+
+        t0 = BenchClock::now();
+        // --threads n: صف جدا با n-1 کارگر (رشته فراخوان هم کار می‌کند)
+        unique_ptr<Tasks::Pool> ownPool;
+        if (cfg.threads > 0) ownPool = make_unique<Tasks::Pool>(cfg.threads - 1);
+        Tasks::Pool &pool = ownPool ? *ownPool : Tasks::Pool::instance();
+        vector<Sweeps::Run> runs;
+        Remote::SweepCoordinator coordinator;
+        coordinator.batchTimeout = std::chrono::seconds(max(1, cfg.batchTimeout));
+        vector<Remote::SweepCoordinator::Endpoint> workers = Remote::SweepCoordinator::endpoints(cfg.workers);
+        if (!plan.empty() && !workers.empty()) {
+            rejectStreamSweep(c.elements);
+            ifstream in(cfg.netlistPath, ios::binary);
+            string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            runs = coordinator.run(text, workers);
+            Sweeps::writeCsv("data/sweep.csv", plan, runs);
+        }
+        else runs = Netlist::run(c, plan, measures, pool);
+        double analysisMs = elapsedMs(t0);
+
+        ofstream out(cfg.outPath);
+        if (!out.is_open()) {
+            cerr << "Unable to open " << cfg.outPath << " for writing" << endl;
+            return 1;
+        }
+        out << fixed << setprecision(4);
+        out << "{\n  \"benchmark\": \"CircuNet netlist\",\n";
+        out << "  \"lines\": " << c.lines << ", \"elements\": " << c.elements.size() << ", \"nets\": " << c.componentId << ",\n";
+        out << "  \"parse_ms\": " << parseMs << ", \"lines_per_sec\": " << c.lines / max(parseMs / 1000.0, 1e-9) << ",\n";
+        out << "  \"analysis\": \"" << a.type << "\", \"analysis_ms\": " << analysisMs << ",\n";
+        if (!plan.empty()) {
+            const Remote::SweepCoordinator::Report &report = coordinator.report();
+            out << "  \"sweep\": {\"runs\": " << runs.size();
+            if (workers.empty()) out << ", \"threads\": " << pool.concurrency();
+            else {
+                out << ", \"workers\": " << workers.size() << ", \"batches\": " << report.batches << ", \"stolen\": "
+                    << report.stolen << ", \"retried\": " << report.retried << ", \"workers_lost\": " << report.workersLost;
+            }
+            out << ", \"runs_per_sec\": " << runs.size() / max(analysisMs / 1000.0, 1e-9) << ", \"stats\": {";
+            auto stats = Sweeps::statistics(runs);
+            for (size_t i = 0; i < stats.size(); ++i) {
+                const Sweeps::Statistics &st = stats[i].second;
+                out << (i ? ", " : "") << "\"" << stats[i].first << "\": {\"mean\": " << setprecision(9) << st.mean
+                    << ", \"sd\": " << st.stddev() << ", \"min\": " << st.min << ", \"max\": " << st.max
+                    << setprecision(4) << ", \"failed\": " << st.failed << "}";
+            }
+            out << "}},\n";
+        }
+        out << "  \"measures\": {";
+        vector<Measurements::Result> results = measure && plan.empty() ? measure->results() : vector<Measurements::Result>();
+        for (size_t i = 0; i < results.size(); ++i) {
+            out << (i ? ", " : "") << "\"" << results[i].name << "\": ";
+            if (results[i].ok) out << setprecision(9) << results[i].value << setprecision(4);
+            else out << "null";
+        }
+        out << "}\n}\n";
+        cout << cfg.netlistPath << ": " << c.lines << " lines parsed in " << parseMs << " ms" << endl;
+        if (!plan.empty()) cout << Sweeps::summary(runs) << "written to data/sweep.csv" << endl;
+        else if (measure) cout << measure->summary();
+        return 0;
+    }
 
-                    for (const std::string& name : signal_names) {
-                        if (name == "V(N00)") {
-                            current_values[name] = 0.0;
-                        } else {
-                            std::string mapped_key = map_signal_key(name); // نگاشت نام برای خواندن داده
-                            sscanf(data_map.at(mapped_key)[i].c_str(), "%lf,%lf", &t, &val);
-                            current_values[name] = val; // ذخیره با نام اصلی برای ارزیابی
-                        }
-                    }
+    // --sizes 10,50,100 --steps 200 --points 100 --dc-points 50 --repeat 5 --out benchmark.json [--trace trace.json] [--save probes|all]
+    // --netlist circuit.cir --out benchmark.json [--threads n] [--workers host:port,...] [--batch-timeout seconds]
+    int run(int argc, char **argv) {
+        BenchConfig cfg;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            string flag = argv[i];
+            string value = argv[i + 1];
+            if (flag == "--sizes") {
+                cfg.sizes.clear();
+                for (auto &s : split(value, ',')) cfg.sizes.push_back(stoi(s));
+            }
+            else if (flag == "--steps") cfg.tranSteps = stoi(value);
+            else if (flag == "--points") cfg.acPoints = stoi(value);
+            else if (flag == "--dc-points") cfg.dcPoints = stoi(value);
+            else if (flag == "--repeat") cfg.repeat = stoi(value);
+            else if (flag == "--out") cfg.outPath = value;
+            else if (flag == "--trace") cfg.tracePath = value;
+            else if (flag == "--netlist") cfg.netlistPath = value;
+            else if (flag == "--save") cfg.saveProbesOnly = (value == "probes");
+            else if (flag == "--threads") cfg.threads = stoi(value);
+            else if (flag == "--workers") cfg.workers = value;
+            else if (flag == "--batch-timeout") cfg.batchTimeout = stoi(value);
+            else {
+                cerr << "Unknown option: " << flag << endl;
+                return 1;
+            }
+        }
 
-                    double current_time, dummy_val;
-                    sscanf(data_map.begin()->second[i].c_str(), "%lf,%lf", &current_time, &dummy_val);
+        if (!cfg.netlistPath.empty()) {
+            try {
+                return runNetlist(cfg);
+            }
+            catch (const exception &e) {
+                cerr << "Benchmark failed: " << e.what() << endl;
+                return 1;
+            }
+        }
 
-                    double result = evaluate_postfix(postfix_tokens, current_values);
-                    data_file << current_time << "," << result << "\n";
+        vector<pair<BenchCircuit (*)(int), bool>> generators = {
+                {rcLadder, true}, {resistorMesh, true}, {diodeBridge, false}, {dependentChain, true}
+        };
+        if (!cfg.tracePath.empty()) Tracing::Tracer::instance().start();
+        vector<BenchResult> results;
+        for (int size : cfg.sizes) {
+            for (auto &g : generators) {
+                // پل دیودی در هر گام تا ۵۰ تکرار همگرایی دارد؛ هر پل ۶ المان است
+                int n = g.second ? size : max(1, size / 10);
+                try {
+                    results.push_back(runCircuit(g.first, n, cfg));
+                    cout << results.back().kind << " n=" << n << " done" << endl;
+                }
+                catch (const exception &e) {
+                    cerr << "Benchmark failed (n=" << n << "): " << e.what() << endl;
                 }
-            } catch (const std::exception& e) {
-                std::cerr << "Warning: Could not evaluate expression '" << key << "'. It may be an unknown key or an invalid expression. Error: " << e.what() << std::endl;
             }
         }
-    }
 
-    data_file.close();
-    cout << "Data extracted successfully to data.txt" << endl;
+        ofstream out(cfg.outPath);
+        if (!out.is_open()) {
+            cerr << "Unable to open " << cfg.outPath << " for writing" << endl;
+            return 1;
+        }
+        writeJson(out, cfg, results);
+        cout << "Benchmark results written to " << cfg.outPath << endl;
+        if (!cfg.tracePath.empty()) {
+            Tracing::Tracer::instance().stop();
+            Tracing::Tracer::instance().writeJson(cfg.tracePath);
+        }
+        return 0;
+    }
 }
+#endif
 
-int main(int, char**) {
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--worker") {
+            int port = WORKER_PORT;
+            if (i + 1 < argc) {
+                char *end;
+                long value = strtol(argv[i + 1], &end, 10);
+                if (*argv[i + 1] == '\0' || *end != '\0' || value < 1 || value > 65535) {
+                    cerr << "Usage: " << argv[0] << " --worker [port]   (port 1-65535, default " << WORKER_PORT << ")" << endl;
+                    return 1;
+                }
+                port = (int)value;
+            }
+            Remote::Worker worker;
+            return worker.serve(port);
+        }
+    }
+#ifdef CIRCUNET_BENCHMARK
+    return Benchmark::run(argc, argv);
+#endif
     SDL_Init(SDL_INIT_VIDEO);
     TTF_Init();
     SDL_Window* win = SDL_CreateWindow("CircuNet", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WindowW, WindowH, 0);
@@ -8496,8 +11094,42 @@ int main(int, char**) {
     SDL_StartTextInput();
     bool running = true;
     SDL_Event e;
+
+    // ضبط timeline با --trace <file> یا Ctrl+T
+    string tracePath = "data/trace.json";
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--trace") {
+            tracePath = argv[i + 1];
+            Tracing::Tracer::instance().start();
+        }
+    }
 /////------------------------------------------------------------
     messageBox errorBox=messageBox(100, 100, 400, 200, font, font, "there is an error", "error");
+    // خلاصه زمان‌بندی آخرین تحلیل (گزارش کامل در data/profile.json)
+    messageBox profileBox=messageBox(WindowW-470, 100, 450, 280, font, font, "", "Profile");
+    auto showProfile = [&]() {
+        profileBox.setMessage(Profiling::Profiler::instance().lastReport().summary());
+        profileBox.show();
+    };
+    // نتیجه ذخیره trace با Ctrl+T (جدا از errorBox تا عنوان آن عوض نشود)
+    messageBox traceBox=messageBox(WindowW-470, 100, 450, 120, font, font, "", "Trace");
+    // دستورات .meas (از نت‌لیست یا Ctrl+M) که در تحلیل گذرا و AC همراه شبیه‌سازی حساب می‌شوند
+    string measureCommands;
+    messageBox measureBox=messageBox(WindowW-470, 400, 450, 200, font, font, "", "Measurements");
+    auto measurementsFor = [&](const string &analysis) {
+        Measurements::Session session;
+        session.addLines(measureCommands);
+        return session.forAnalysis(analysis);
+    };
+    auto showMeasurements = [&](const Measurements::Session &session) {
+        if (session.empty()) return;
+        session.writeFile("data/measure.txt");
+        measureBox.setMessage(session.summary());
+        measureBox.show();
+    };
+    // دستورات .step (از نت‌لیست یا Ctrl+B) برای جاروب پارامتر و مونت‌کارلو روی تحلیل گذرا
+    string sweepCommands;
+    messageBox sweepBox=messageBox(WindowW-470, 400, 450, 250, font, font, "", "Sweep");
     vector<Button> buttonsToolbar = createToolbar();
     vector<Button> buttonsLibrary = createLibrary();
     PopupMenu saveMenu= createSaveMenu();
@@ -8515,17 +11147,39 @@ int main(int, char**) {
     LabelDialog labelDialog(200, 200, font);
     vector<shared_ptr<LabelNet>> labels;
     // ایجاد نودها با فاصله مناسب
-    for (int y = stepY/2; y < WindowH; y += stepY) {
-        for (int x = stepX/2; x < WindowW; x += stepX) {
-            wire.allNodes.push_back(make_shared<Node>(x, y));
-        }
-    }
+    Wire::resetGrid();
 
     // لیست المان‌های مداری
     vector<shared_ptr<Element>> elements;
 
     vector<shared_ptr<GNDSymbol>>gndSymbols;
 
+    // بازیابی بعد از crash: تغییرات مدار در هر فریم (Editing::Tracker) در data/autosave-N.journal ثبت می‌شوند
+    // و هر autosaveRecords رکورد یا autosaveInterval میلی‌ثانیه یک snapshot در data/autosave-N.shirali جای آن‌ها را می‌گیرد
+    // N مال همین نمونه برنامه است (قفل data/autosave-N.lock)؛ نمونه دوم به دفتر نمونه اول دست نمی‌زند
+    Journaling::InstanceSlot autosaveSlot("data/autosave");
+    const string autosavePath = autosaveSlot.snapshotPath();
+    const string journalPath = autosaveSlot.journalPath();
+    const size_t autosaveRecords = 200;
+    const Uint32 autosaveInterval = 30000;
+    Scene scene{elements, labels, gndSymbols};
+    Tracker tracker;
+    History history;
+    // مدار زنده روی شبکه: میزبان تغییرات هر فریم را منتشر می‌کند و دنبال‌کننده آن‌ها را اعمال می‌کند
+    bool sharingCircuit = false;
+    const size_t liveSnapshotEvery = 200;     // بعد از این تعداد تغییر snapshot تازه برای مشترک‌های جدید
+    Follower follower(SubscribeMessage);
+    // نتیجه‌های گذرای سرور در حین اجرا؛ با پایان اجرا جای data/log.txt را می‌گیرند
+    Follower resultFollower(ResultSubscribeMessage);
+    ResultCollector followedResults;
+    // تحلیل روی کارگر شبیه‌سازی (CircuNet --worker)؛ نتیجه تا پایان کار در data/worker.tmp نوشته می‌شود
+    Remote::WorkerClient workerClient;
+    // wire.newCircuit فقط بعد از تغییر مدار (ویرایش ثبت شده یا اثر انگشت تازه)؛ برچسبی که قرار داده یا کشیده می‌شود هر فریم نام نودها را عوض می‌کند
+    bool topologyDirty = true;
+    // دفتر جا مانده تا تصمیم کاربر دست نمی‌خورد؛ رکوردهای تازه بعد از آخرین شماره آن شماره می‌گیرند
+    vector<Journaling::Record> crashRecords = Journaling::Journal::read(journalPath);
+    Journaling::Journal journal(journalPath, crashRecords.empty() ? 0 : crashRecords.back().seq);
+    Uint32 lastAutosave = 0;
 
 
     // وضعیت قرار دادن المان جدید
@@ -8577,6 +11231,48 @@ int main(int, char**) {
 
     vector<Probe> probes;
     string probeExpressions; // رشته ذخیره دستورات پروب
+    // نتیجه پروژه باز شده تا وقتی نمودار یا ذخیره در فایل دیگری لازمش نکند در data/log.txt نوشته نمی‌شود
+    string pendingResults;
+    std::filesystem::file_time_type pendingSince;     // زمان تغییر data/log.txt خالی شده هنگام باز کردن
+    // اگر بعد از باز کردن تحلیلی (محلی، جاروب، کارگر یا نتیجه دنبال شده) data/log.txt را نوشته، نتیجه فایل کهنه است
+    auto dropStaleResults = [&]() {
+        if (pendingResults.empty()) return;
+        std::error_code sizeError, timeError;
+        auto size = std::filesystem::file_size("data/log.txt", sizeError);
+        auto time = std::filesystem::last_write_time("data/log.txt", timeError);
+        if (!sizeError && !timeError && (size > 0 || time != pendingSince)) pendingResults.clear();
+    };
+    auto loadPendingResults = [&]() {
+        dropStaleResults();
+        if (pendingResults.empty()) return;
+        journal.wait();
+        Project::Container project;
+        if (!project.open(pendingResults) || !project.extract("RSLT", "data/log.txt")) {
+            cerr << "Failed to read results from " << pendingResults << "\n";
+        }
+        pendingResults.clear();
+    };
+
+    // ذخیره همه سیگنال‌ها یا فقط سیگنال‌های پروب‌ها در تحلیل گذرا و DC Sweep
+    bool saveAllSignals = true;
+    auto saveList = [&]() {
+        return saveAllSignals ? SaveList() : saveListFromProbes(probeExpressions, elements);
+    };
+    // تحلیل گذرای رابط گرافیکی؛ اگر مشترک نتیجه‌ای باشد نمونه‌ها در حین اجرا منتشر می‌شوند
+    auto runTransient = [&](Measurements::Session &measures) {
+        SaveList save = saveList();
+        CollabServer &collab = CollabServer::instance();
+        ResultStream stream = collab.beginResults();
+        try {
+            cout<<analyzeTransient(unitHandlerNonNegative(transientStart,"StartTime"),unitHandlerNonNegative(transientStop,"StopTime"),unitHandlerNonNegative(transientStep,"Time Step")
+                    ,Wire::allNodes,elements,&measures,&save,&stream);
+        }
+        catch (const exception &e) {
+            collab.endResults(save.logPath, e.what());
+            throw;
+        }
+        collab.endResults(save.logPath);
+    };
     Probe::ProbeType currentProbeType;
 
 
@@ -8755,6 +11451,13 @@ int main(int, char**) {
         elementDialog.show("PWLVoltageSource");
         //کد مربوط به منبع ولتاژ PWL
     };
+    componentMenu.items[19].onClick=[&]() {
+        deactivateOtherModes();
+        buttonsLibrary[0].bgColor = {237, 149, 100, 255};
+        elementDialog.setPosition(1366/2 - elementDialog.rect.w/2, 768/2 - elementDialog.rect.h/2);
+        elementDialog.show("StreamVoltageSource");
+        // منبع ولتاژ جریانی (فایل یا tcp:host:port)
+    };
     // Set wire button click handler
     buttonsLibrary[1].onClick = [&]() {
         if (buttonsLibrary[1].bgColor.r == 237) { // اگر از قبل فعال است
@@ -8794,6 +11497,7 @@ int main(int, char**) {
         analyzeType="OP";
         try{
             analyzeOp(errorBox, wire.componentId, elements,labels);
+            showProfile();
         }
         catch (const exception &e){
             errorBox.setMessage(e.what());
@@ -8829,6 +11533,10 @@ int main(int, char**) {
         analyzeDialog.show("Phase Sweep");
         //کد مربوط به منبع PHASE
     };
+    AnalyzeMenu.items[5].onClick=[&]() {
+        saveAllSignals = !saveAllSignals;
+        AnalyzeMenu.items[5].text = saveAllSignals ? "Save: all" : "Save: probes";
+    };
     // Set GND button click handler
     buttonsLibrary[4].onClick = [&]() {
         deactivateOtherModes(&buttonsLibrary[4]);
@@ -8877,6 +11585,7 @@ int main(int, char**) {
     };
     buttonsLibrary[9].onClick = [&]() {
         deactivateOtherModes(&buttonsLibrary[9]);
+        loadPendingResults();
         extract_data(probeExpressions,elements);
         DataVisualizer visualizer("data.txt");
         visualizer.run();
@@ -8915,6 +11624,9 @@ int main(int, char**) {
         else if(elementTypeToPlace == "PWLVoltageSource") {
             elementValueToPlace = "data/PWL.txt";
         }
+        else if(elementTypeToPlace == "StreamVoltageSource") {
+            elementValueToPlace = values[1];
+        }
         else if(elementTypeToPlace == "Diode") {
             elementModelToplace = values[1];
         }
@@ -8956,28 +11668,6 @@ int main(int, char**) {
     analyzeDialog.onOK = [&](const std::vector<std::string>& values){
         analyzeType=analyzeDialog.currentAnalyzeType;
         if(analyzeDialog.currentAnalyzeType == "Transient") {
-            auto unitHandler=[](string input, string type)->double {
-                regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-                smatch match;
-                if (regex_match(input, match, pattern)) {
-                    double value = stod(match[1]);
-                    string unit = match[2].str();
-                    double multiplier = 1.0;
-                    if (unit == "n") multiplier = 1e-9;
-                    else if (unit == "u") multiplier = 1e-6;
-                    else if (unit == "m") multiplier = 1e-3;
-                    else if (unit == "k") multiplier = 1e3;
-                    else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-                    else if (unit == "G") multiplier = 1e9;
-                    if (value < 0) {
-                        throw invalidValue(type);
-                    }
-                    return value * multiplier;
-                } else {
-                    throw invalidValue(type);
-                }
-                return -1.0;
-            };
             transientStart = values[0];
             transientStop = values[1];
             transientStep = values[2];
@@ -8985,8 +11675,10 @@ int main(int, char**) {
                     transientStart.c_str(), transientStop.c_str(), transientStep.c_str());
 
             try{
-                cout<<analyzeTransient(unitHandler(transientStart,"StartTime"),unitHandler(transientStop,"StopTime"),unitHandler(transientStep,"Time Step")
-                        ,Wire::allNodes,elements);
+                Measurements::Session measures = measurementsFor("tran");
+                runTransient(measures);
+                showProfile();
+                showMeasurements(measures);
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9001,7 +11693,9 @@ int main(int, char**) {
             SDL_Log("DC Sweep set: Source=%s, Start=%s, End=%s, Step=%s",
                     dcSource.c_str(), dcStart.c_str(), dcEnd.c_str(), dcStep.c_str());
             try{
-                cout<<DCSweep(wire.componentId,elements,dcSource,dcStart,dcEnd,dcStep,labels);
+                SaveList save = saveList();
+                cout<<DCSweep(wire.componentId,elements,dcSource,dcStart,dcEnd,dcStep,labels,&save);
+                showProfile();
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9017,7 +11711,10 @@ int main(int, char**) {
                     acSweepType.c_str(), acStartFreq.c_str(), acStopFreq.c_str(), acPoints.c_str());
 
             try{
-                cout<<analyzeAc(acSweepType,acStartFreq,acStopFreq,acPoints,wire.componentId,elements,labels);
+                Measurements::Session measures = measurementsFor("ac");
+                cout<<analyzeAc(acSweepType,acStartFreq,acStopFreq,acPoints,wire.componentId,elements,labels,&measures);
+                showProfile();
+                showMeasurements(measures);
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9034,6 +11731,7 @@ int main(int, char**) {
 
             try{
                 cout<<analyzePhase(phaseStart,phaseStop,phasePoints,wire.componentId,phaseBaseFreq,elements,labels);
+                showProfile();
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9048,7 +11746,9 @@ int main(int, char**) {
     ///مربوط به Toolbar
     //file
     // --- Load lambda ---
-    auto loadAll = [&](const std::string& filename) {
+    // فایل‌های قدیمی: یک آرشیو با کل شبکه نودها و log کنار فایل، با قالب Schema::Layout::Legacy
+    // ذخیره بعدی همان فایل را به قالب جدید تبدیل می‌کند
+    auto loadLegacy = [&](const std::string& filename) {
 
         std::ifstream is(filename, std::ios::binary);
         if (!is.is_open()) {
@@ -9056,6 +11756,29 @@ int main(int, char**) {
             return;
         }
 
+        size_t pos = filename.find_last_of("/\\");
+        string dir;
+        if (pos != string::npos)
+            dir = filename.substr(0, pos); // فقط مسیر
+        else
+            dir = "."; // اگر مسیر نبود، پوشه جاری
+
+        string logPath = dir + "/log";
+
+        // کپی log همزمان با خواندن آرشیو روی Tasks::Pool
+        Tasks::TaskGroup io;
+        io.run([logPath]() {
+            ifstream fin(logPath, ios::in);
+            ofstream fout("data/log.txt",ios::out);
+
+            if (!fin.is_open() || !fout.is_open()) {
+                cerr << "Error opening files\n";
+                return;
+            }
+            fout<<fin.rdbuf();
+        });
+
+        Schema::Scope layout(Schema::Layout::Legacy);
         cereal::BinaryInputArchive archive(is);
 
         // بارگذاری داده‌ها
@@ -9075,74 +11798,303 @@ int main(int, char**) {
                 Wire::allNodes,
                 Wire::Lines
         );
+        io.wait();
+    };
 
-        size_t pos = filename.find_last_of("/\\");
-        string dir;
-        if (pos != string::npos)
-            dir = filename.substr(0, pos); // فقط مسیر
-        else
-            dir = "."; // اگر مسیر نبود، پوشه جاری
-
-        string logPath = dir + "/log";
-
-
-        ifstream fin(logPath, ios::in);
-        ofstream fout("data/log.txt",ios::out);
-
-        if (!fin.is_open() || !fout.is_open()) {
-            cerr << "Error opening files\n";
+    // فایل پروژه تکه‌ای (include/project.h):
+    //   META تنظیمات تحلیل، عبارت پروب‌ها و دستورات .meas/.step   CIRC مدار و فقط نودهای استفاده شده شبکه
+    //   PROB پروب‌ها   RSLT محتوای data/log.txt
+    // شبکه نودها باید قبل از صدا زدن تازه ساخته شده باشد (مثل New)؛ نودهای ذخیره شده جای نود هم‌مکان را می‌گیرند
+    auto loadAll = [&](const std::string& filename) {
+        Tracing::ScopedEvent openTrace("open project", "file");
+        journal.wait();
+        Project::Container project;
+        if (!project.open(filename)) {
+            loadLegacy(filename);
             return;
         }
-        fout<<fin.rdbuf();
-
+        pendingResults.clear();
+        // تکه‌ای که نیست یا hash آن نمی‌خواند کل باز کردن را متوقف می‌کند
+        auto chunk = [&project, &filename](const char *tag) {
+            std::string data;
+            if (!project.read(tag, data)) throw runtime_error(string("section ") + tag + " of " + filename + " is missing or damaged");
+            return data;
+        };
+        {
+            std::istringstream is(chunk("META"));
+            cereal::BinaryInputArchive archive(is);
+            archive(analyzeType,
+                    transientStart, transientStop, transientStep,
+                    dcSource, dcStart, dcEnd, dcStep,
+                    acSweepType, acStartFreq, acStopFreq, acPoints,
+                    phaseBaseFreq, phaseStart, phaseStop, phasePoints,
+                    probeExpressions, measureCommands, sweepCommands,
+                    liine::count);
+        }
+        {
+            // نسخه ۱ فایل پروژه هنوز قالب Legacy مدار را داشت
+            Schema::Scope layout(project.formatVersion() < 2 ? Schema::Layout::Legacy : Schema::Layout::Compact);
+            std::istringstream is(chunk("CIRC"));
+            cereal::BinaryInputArchive archive(is);
+            vector<shared_ptr<Node>> usedNodes;
+            archive(wire, labels, elements, gndSymbols, Wire::Lines, usedNodes);
+            Wire::restoreNodes(usedNodes);
+        }
+        {
+            std::istringstream is(chunk("PROB"));
+            cereal::BinaryInputArchive archive(is);
+            archive(probes);
+        }
+        // data/log.txt خالی می‌ماند تا loadPendingResults
+        ofstream("data/log.txt", ios::trunc);
+        if (project.has("RSLT") && project.find("RSLT")->length > 0) {
+            std::error_code ec;
+            pendingSince = std::filesystem::last_write_time("data/log.txt", ec);
+            if (!ec) pendingResults = filename;
+            else if (!project.extract("RSLT", "data/log.txt")) cerr << "Failed to read results from " << filename << "\n";
+        }
     };
     // --- Save lambda ---
-    auto saveAll = [&](const std::string& filename) {
-        std::ofstream os(filename, std::ios::binary);
-        if (!os.is_open()) {
-            std::cerr << "Failed to open file for saving: " << filename << "\n";
-            return;
+    // هر تکه یک آرشیو cereal جدا؛ Project::Container::save فقط تکه‌های تغییر کرده را به فایل اضافه می‌کند
+    // تکه‌های META، CIRC و PROB با برچسب‌ها و زمین‌های داده شده
+    // هر تکه مستقیم در رشته خودش نوشته می‌شود (Bytes::OutputBuffer، بدون کپی ostringstream::str)
+    auto archiveChunk = [](const auto &... values) {
+        Bytes::OutputBuffer buffer;
+        buffer.begin();
+        {
+            std::ostream out(&buffer);
+            cereal::BinaryOutputArchive archive(out);
+            archive(values...);
         }
-        cereal::BinaryOutputArchive archive(os);
-        // کلاس ها و vector ها
-        archive(wire);
-        archive(labels);
-        archive(elements);
-        archive(gndSymbols);
-        archive(probes);
-        archive(probeExpressions);
-
-        // متغیرهای تحلیل
-        archive(analyzeType,
-                transientStart, transientStop, transientStep,
-                dcSource, dcStart, dcEnd, dcStep,
-                acSweepType, acStartFreq, acStopFreq, acPoints,
-                phaseBaseFreq, phaseStart, phaseStop, phasePoints);
-
-        // متغیرهای استاتیک
-        archive(liine::count);
-        archive(Wire::allNodes);
-        archive(Wire::Lines);
-
-        size_t pos = filename.find_last_of("/\\");
-        string dir;
-        if (pos != string::npos)
-            dir = filename.substr(0, pos); // فقط مسیر
-        else
-            dir = "."; // اگر مسیر نبود، پوشه جاری
-
-        string logPath = dir + "/log";
+        return buffer.take();
+    };
+    auto projectChunks = [&](const vector<shared_ptr<LabelNet>>& savedLabels, const vector<shared_ptr<GNDSymbol>>& savedGrounds) {
+        std::vector<std::pair<std::string, std::string>> chunks;
+        chunks.push_back({"META", archiveChunk(analyzeType,
+                                               transientStart, transientStop, transientStep,
+                                               dcSource, dcStart, dcEnd, dcStep,
+                                               acSweepType, acStartFreq, acStopFreq, acPoints,
+                                               phaseBaseFreq, phaseStart, phaseStop, phasePoints,
+                                               probeExpressions, measureCommands, sweepCommands,
+                                               liine::count)});
+        chunks.push_back({"CIRC", archiveChunk(wire, savedLabels, elements, savedGrounds, Wire::Lines, Wire::usedNodes())});
+        chunks.push_back({"PROB", archiveChunk(probes)});
+        return chunks;
+    };
+    // سریالایز روی رشته رابط کاربر و نوشتن فایل روی رشته دفتر، به ترتیب autosave ها
+    auto saveAll = [&](const std::string& filename) {
+        Tracing::ScopedEvent saveTrace("save project", "file");
 
+        // خواندن نتیجه همزمان با سریالایز مدار روی Tasks::Pool؛ اگر نتیجه همین فایل هنوز باز نشده تکه RSLT دست نمی‌خورد
+        dropStaleResults();
+        if (pendingResults != filename) loadPendingResults();
+        bool keepResults = pendingResults == filename;
+        string results;
+        Tasks::TaskGroup io;
+        if (!keepResults) {
+            io.run([&results]() {
+                ifstream fin("data/log.txt", ios::binary);
+                if (fin.is_open()) results.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+            });
+        }
 
-        ifstream fin("data/log.txt", ios::in);
-        ofstream fout(logPath, ios::out);
+        auto chunks = projectChunks(labels, gndSymbols);
+        io.wait();
+        if (!keepResults) chunks.push_back({"RSLT", std::move(results)});
 
-        if (!fin.is_open() || !fout.is_open()) {
-            cerr << "Error opening files\n";
-            return;
+        journal.post([filename, chunks = std::move(chunks)]() {
+            if (Project::Container::save(filename, chunks) < 0) {
+                std::cerr << "Failed to open file for saving: " << filename << "\n";
+            }
+        });
+    };
+    // snapshot بدون نتیجه تحلیل؛ برچسب و زمینی که هنوز در حال قرار گرفتن است مثل Tracker کنار گذاشته می‌شود
+    // JSEQ شماره آخرین رکورد دفتر که در snapshot آمده و NAME فایل پروژه باز
+    auto autosave = [&]() {
+        Tracing::ScopedEvent autosaveTrace("autosave", "file");
+        auto chunks = projectChunks(placed(labels), placed(gndSymbols));
+        chunks.push_back({"NAME", archiveChunk(nameFile, isOnceSave)});
+        string path = autosavePath;
+        journal.checkpoint([path, chunks = std::move(chunks)](uint64_t seq) mutable {
+            std::ostringstream os;
+            {
+                cereal::BinaryOutputArchive archive(os);
+                archive(seq);
+            }
+            chunks.push_back({"JSEQ", os.str()});
+            return Project::Container::save(path, chunks) >= 0;
+        });
+        lastAutosave = SDL_GetTicks();
+    };
+    // مثل Tracker بدون برچسب و زمینی که در حال قرار گرفتن است
+    auto shareSnapshot = [&]() {
+        auto placedLabels = placed(labels);
+        auto placedGrounds = placed(gndSymbols);
+        publishCircuit(wire, placedLabels, elements, placedGrounds);
+    };
+    // بعد از New و Open: مدار فعلی حالت پایه دفتر و undo است
+    auto resetEditing = [&]() {
+        tracker.reset(scene);
+        history.clear();
+        topologyDirty = true;
+        autosave();
+        if (sharingCircuit) shareSnapshot();
+    };
+    // تغییرات مدار از آخرین بار به دفتر و مشترک‌های شبکه؛ record=false برای تغییری که undo/redo یا میزبان ساخته
+    auto trackEdits = [&](bool record) {
+        vector<Edit> edits = tracker.changes(scene);
+        if (edits.empty()) return;
+        string encoded = encode(edits);
+        if (sharingCircuit) {
+            if (CollabServer::instance().deltasSinceSnapshot() >= liveSnapshotEvery) shareSnapshot();
+            else CollabServer::instance().publishDelta(encoded);
+        }
+        journal.append(std::move(encoded));
+        if (record) history.record(std::move(edits));
+        topologyDirty = true;
+    };
+    // اثر انگشت آنچه نام‌گذاری نودها به آن بسته است؛ تغییری که Tracker نمی‌بیند (متن برچسب، نودهای المان) هم مدار را کهنه می‌کند
+    uint64_t topologySeen = 0;
+    auto topologySignature = [&]() {
+        uint64_t h = Project::hashBasis;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+        for (auto &line : Wire::Lines) {
+            mix((uint64_t)(uintptr_t)line.get());
+            if (line) for (auto &node : line->Nodes) mix((uint64_t)(uintptr_t)node.get());
+        }
+        for (auto &e : elements) {
+            mix((uint64_t)(uintptr_t)e->getNodeP().get());
+            mix((uint64_t)(uintptr_t)e->getNodeN().get());
+        }
+        for (auto &label : labels) {
+            h = Project::hash(label->text.data(), label->text.size(), h);
+            mix(((uint64_t)(uint32_t)label->baseRect.x << 32) | (uint32_t)label->baseRect.y);
+            mix(label->isPlacing);
+        }
+        for (auto &gnd : gndSymbols) {
+            mix(((uint64_t)(uint32_t)gnd->baseRect.x << 32) | (uint32_t)gnd->baseRect.y);
+            mix(gnd->isPlacing);
+        }
+        return h;
+    };
+    // پیام‌های دنبال‌کننده: snapshot کل مدار را عوض می‌کند و هر تغییر باید نسخه بعدی باشد، وگرنه دوباره مشترک می‌شود
+    auto applyFollowed = [&]() {
+        for (Net::Message &m : follower.take()) {
+            if (m.payload.size() < 8) continue;     // بدون نسخه؛ پیام خراب
+            if (m.type == CircuitMessage) {
+                LabelNet::placingInstance = nullptr;
+                GNDSymbol::placingInstance = nullptr;
+                if (!loadCircuit(string_view(m.payload).substr(8), wire, labels, elements, gndSymbols)) continue;
+                follower.expected = versionOf(m.payload) + 1;
+                resetEditing();
+            }
+            else if (m.type == DeltaMessage && follower.expected) {
+                if (versionOf(m.payload) != follower.expected) {
+                    follower.start();
+                    return;
+                }
+                ++follower.expected;
+                try {
+                    for (auto &edit : decode(string_view(m.payload).substr(8))) Editing::apply(edit, scene);
+                }
+                catch (const exception &ex) {
+                    std::cerr << "Client: bad circuit change: " << ex.what() << "\n";
+                    follower.start();
+                    return;
+                }
+                trackEdits(false);
+            }
+        }
+    };
+    auto undoRedo = [&](bool redo) {
+        if (LabelNet::placingInstance || GNDSymbol::placingInstance) return false;
+        trackEdits(true);
+        if (!(redo ? history.redo(scene) : history.undo(scene))) return false;
+        trackEdits(false);
+        return true;
+    };
+    // کارت تحلیل نت‌لیست <-> متغیرهای تحلیل رابط گرافیکی
+    auto currentAnalysisCard = [&]() {
+        Netlist::AnalysisCard card;
+        card.type = analyzeType;
+        try {
+            if (analyzeType == "Transient") {
+                card.values = {unitHandler3(transientStart, "start time"), unitHandler3(transientStop, "stop time"),
+                               unitHandler3(transientStep, "time steps")};
+            }
+            else if (analyzeType == "DC Sweep") {
+                card.source = dcSource;
+                card.values = {unitHandler3(dcStart, "start"), unitHandler3(dcEnd, "end"), unitHandler3(dcStep, "step")};
+            }
+            else if (analyzeType == "AC Sweep") {
+                card.values = {unitHandler3(acStartFreq, "start frequency"), unitHandler3(acStopFreq, "stop frequency"),
+                               unitHandler3(acPoints, "points")};
+            }
+        }
+        catch (const exception &) {
+            card.values.clear(); // کارت ناقص در نت‌لیست نوشته نمی‌شود
+        }
+        return card;
+    };
+    auto applyAnalysisCard = [&](const Netlist::AnalysisCard &card) {
+        analyzeType = card.type;
+        const vector<double> &v = card.values;
+        if (card.type == "Transient") {
+            transientStart = Netlist::formatValue(v[0]);
+            transientStop = Netlist::formatValue(v[1]);
+            transientStep = Netlist::formatValue(v[2]);
+        }
+        else if (card.type == "DC Sweep") {
+            dcSource = card.source;
+            dcStart = Netlist::formatValue(v[0]);
+            dcEnd = Netlist::formatValue(v[1]);
+            dcStep = Netlist::formatValue(v[2]);
+        }
+        else if (card.type == "AC Sweep") {
+            acSweepType = "dec";
+            acStartFreq = Netlist::formatValue(v[0]);
+            acStopFreq = Netlist::formatValue(v[1]);
+            acPoints = Netlist::formatValue(v[2]);
+        }
+    };
+    // نتیجه کارگر مثل اجرای محلی جای data/log.txt را می‌گیرد
+    auto applyRemote = [&]() {
+        Remote::WorkerClient::Outcome outcome;
+        while (workerClient.take(outcome)) {
+            if (!outcome.ok) {
+                std::remove(outcome.resultPath.c_str());
+                errorBox.setMessage("worker: " + outcome.text);
+                errorBox.show();
+                continue;
+            }
+            journal.wait();     // ذخیره پس‌زمینه ممکن است هنوز data/log.txt را بخواند
+            std::remove("data/log.txt");
+            if (std::rename(outcome.resultPath.c_str(), "data/log.txt") != 0) {
+                errorBox.setMessage("worker: could not write data/log.txt");
+                errorBox.show();
+                continue;
+            }
+            SDL_Log("worker results: %zu bytes", outcome.bytes);
+            if (!outcome.text.empty()) {
+                measureBox.setMessage(outcome.text);
+                measureBox.show();
+            }
+        }
+    };
+    auto applyFollowedResults = [&]() {
+        for (Net::Message &m : resultFollower.take()) {
+            string log, error;
+            if (!followedResults.add(m, log, error)) continue;
+            if (!error.empty()) {
+                errorBox.setMessage("server: " + error);
+                errorBox.show();
+                continue;
+            }
+            journal.wait();     // ذخیره پس‌زمینه ممکن است هنوز data/log.txt را بخواند
+            ofstream out("data/log.txt", ios::binary);
+            out << log;
+            SDL_Log("server results: %zu bytes", log.size());
         }
-        fout<<fin.rdbuf();
-
     };
     buttonsToolbar[0].onClick = [&]() {
         SDL_Rect r = buttonsToolbar[0].rect;
@@ -9205,12 +12157,7 @@ int main(int, char**) {
 
         // حالا مدار را پاک کرده و فایل جدید باز کنیم
         liine::count = 1;
-        Wire::allNodes.clear();
-        for (int y = stepY/2; y < WindowH; y += stepY) {
-            for (int x = stepX/2; x < WindowW; x += stepX) {
-                wire.allNodes.push_back(make_shared<Node>(x, y));
-            }
-        }
+        Wire::resetGrid();
         Wire::Lines.clear();
         LabelNet::placingInstance = nullptr;
         GNDSymbol::placingInstance = nullptr;
@@ -9222,6 +12169,8 @@ int main(int, char**) {
         isDeleteModel = false;
         probes.clear();
         probeExpressions = "";
+        measureCommands = "";
+        sweepCommands = "";
         placingProbe = false;
 
         SDL_SysWMinfo wmInfo;
@@ -9234,13 +12183,23 @@ int main(int, char**) {
 
         std::string filename = ShowOpenFileDialog(wmInfo.info.win.window);
         if (!filename.empty()) {
-            loadAll(filename);
-            nameFile = filename;
-            isOnceSave = true;
+            try {
+                loadAll(filename);
+                nameFile = filename;
+                isOnceSave = true;
+            }
+            catch (const exception &ex) {
+                nameFile = "firstRun";
+                isOnceSave = false;
+                errorBox.setTitle("error");
+                errorBox.setMessage(ex.what());
+                errorBox.show();
+            }
         } else {
             nameFile = "firstRun";
             isOnceSave = false;
         }
+        resetEditing();
     };
 
     fileMenu.items[1].onClick = [&]() {
@@ -9298,12 +12257,7 @@ int main(int, char**) {
 
         // حالا مدار جدید ایجاد کنیم
         liine::count = 1;
-        Wire::allNodes.clear();
-        for (int y = stepY/2; y < WindowH; y += stepY) {
-            for (int x = stepX/2; x < WindowW; x += stepX) {
-                wire.allNodes.push_back(make_shared<Node>(x, y));
-            }
-        }
+        Wire::resetGrid();
         Wire::Lines.clear();
         LabelNet::placingInstance = nullptr;
         GNDSymbol::placingInstance = nullptr;
@@ -9315,9 +12269,48 @@ int main(int, char**) {
         isDeleteModel = false;
         probes.clear();
         probeExpressions = "";
+        measureCommands = "";
+        sweepCommands = "";
         placingProbe = false;
+        pendingResults.clear();
         nameFile = "firstRun";
         isOnceSave = false;
+        resetEditing();
+    };
+
+    fileMenu.items[2].onClick = [&]() {
+        // مثل New مدار فعلی (با پرسش ذخیره) پاک می‌شود؛ اگر کاربر لغو کند مدار دست نمی‌خورد
+        fileMenu.items[1].onClick();
+        if (!elements.empty()) return;
+
+        SDL_SysWMinfo wmInfo;
+        SDL_VERSION(&wmInfo.version);
+        if (!SDL_GetWindowWMInfo(win, &wmInfo)) {
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error",
+                                     "Failed to get window info", win);
+            return;
+        }
+
+        std::string filename = ShowOpenFileDialog(wmInfo.info.win.window, netlistFileFilter);
+        if (filename.empty()) return;
+        try {
+            Netlist::NetlistCircuit c = Netlist::readFile(filename);
+            Netlist::placeOnCanvas(c, elements, labels, gndSymbols, font);
+            applyAnalysisCard(c.analysis);
+            for (auto &m : c.measures) measureCommands += m + "\n";
+            for (auto &st : c.steps) sweepCommands += st + "\n";
+            errorBox.setTitle("Netlist");
+            errorBox.setMessage(c.title + "\n" + to_string(c.elements.size()) + " elements, " + to_string(c.componentId) + " nets"
+                                + (c.analysis.type.empty() ? "" : ", " + c.analysis.type));
+        }
+        catch (const exception &e) {
+            elements.clear();
+            labels.clear();
+            gndSymbols.clear();
+            errorBox.setTitle("error");
+            errorBox.setMessage(e.what());
+        }
+        errorBox.show();
     };
 
     buttonsToolbar[1].onClick = [&]() {
@@ -9377,7 +12370,22 @@ int main(int, char**) {
 
     saveMenu.items[1].setShortcut(SDLK_s, KMOD_LSHIFT);
     saveMenu.items[2].onClick=[&](){
+        if (elements.empty()) return;
+        SDL_SysWMinfo wmInfo;
+        SDL_VERSION(&wmInfo.version);
+        if (!SDL_GetWindowWMInfo(win, &wmInfo)) {
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error",
+                                     "Failed to get window info", win);
+            return;
+        }
 
+        std::string filename = ShowSaveDialog(wmInfo.info.win.window, netlistFileFilter);
+        if (filename.empty()) return;
+        bool saved = Netlist::writeFile(filename, elements, currentAnalysisCard(), split(measureCommands, '\n'),
+                                           split(sweepCommands, '\n'));
+        errorBox.setTitle("Netlist");
+        errorBox.setMessage(saved ? "Netlist exported to " + filename : "Unable to write " + filename);
+        errorBox.show();
     };
     //libFolder
     buttonsToolbar[2].onClick = [&](){};
@@ -9401,17 +12409,20 @@ int main(int, char**) {
         for (auto &i:elements) {
             x = dynamic_pointer_cast<SinVoltageSource>(i);
             if(x){
-                thread serverVThread(startServerSendVoltageSource,x);
-                serverVThread.detach();
+                publishVoltageSource(x);
                 break;
             }
         }
     };
+    // از این به بعد هر تغییر مدار به مشترک‌ها فرستاده می‌شود
     serverMenu.items[1].onClick=[&](){
-        thread serverC([&](){
-            startServerSendCircuit(wire, labels, elements, gndSymbols);
-        });
-        serverC.detach();
+        trackEdits(true);
+        sharingCircuit = true;
+        shareSnapshot();
+    };
+    // تحلیل‌های گذرای بعدی در حین اجرا به مشترک‌های نتیجه فرستاده می‌شوند
+    serverMenu.items[3].onClick=[&](){
+        CollabServer::instance().shareResults();
     };
     serverMenu.items[2].onClick=[&](){
         vector<string>v;
@@ -9430,8 +12441,7 @@ int main(int, char**) {
                 phasePoints
         });
 
-        thread serverA(startServerSendAnalyze,v);
-        serverA.join();
+        publishAnalyze(v);
 
     };
     networkMenu.items[1].onClick=[&](){
@@ -9443,68 +12453,62 @@ int main(int, char**) {
 //        clientThread.detach();
 
     };
+    // دریافت از سرور روی Executor؛ مدار فقط در completion و روی رشته UI عوض می‌شود
     clientMenu.items[0].onClick=[&](){
-        shared_ptr<SinVoltageSource> x;
-        for (auto &i:elements) {
-            x = dynamic_pointer_cast<SinVoltageSource>(i);
-            if(x){
-                thread clientVThread(startClientReceiveVoltageSource,x);
-                clientVThread.detach();
-                break;
-            }
-        }
+        Executor::instance().post([&]() -> Executor::Completion {
+            vector<double> v = fetchVoltageSource();
+            return [&, v]() {
+                if (v.size() < 3) return;
+                for (auto &i:elements) {
+                    shared_ptr<SinVoltageSource> x = dynamic_pointer_cast<SinVoltageSource>(i);
+                    if(x){
+                        x->setOffset(v[0]);
+                        x->setAmplitude(v[1]);
+                        x->setFrequency(v[2]);
+                        break;
+                    }
+                }
+            };
+        });
     };
     clientMenu.items[1].onClick=[&](){
-        thread t1([&](){
-            startClientReceiveCircuit(wire, labels, elements, gndSymbols);
-        });
-        t1.detach();
+        follower.start();
     };
-    clientMenu.items[2].onClick=[&](){
-        thread t([&](){
-            vector<string> receivedData = startClientReceiveAnalyze();
-            analyzeType=receivedData[0],
-            transientStart=receivedData[1],
-            transientStop=receivedData[2],
-            transientStep=receivedData[3],
-            acSweepType=receivedData[4],
-            acStartFreq=receivedData[5],
-            acStopFreq=receivedData[6],
-            acPoints=receivedData[7],
-            phaseBaseFreq=receivedData[8],
-            phaseStart=receivedData[9],
-            phaseStop=receivedData[10],
-            phasePoints=receivedData[11];
-        });
-        t.join();
+    clientMenu.items[4].onClick=[&](){
+        resultFollower.start();
+    };
+    clientMenu.items[3].onClick=[&](){
+        Netlist::AnalysisCard card = currentAnalysisCard();
+        if (card.type.empty() || (card.type != "OP" && card.values.empty())) {
+            errorBox.setMessage("set a Transient, DC Sweep, AC Sweep or OP analysis first");
+            errorBox.show();
+            return;
+        }
+        string netlist = Netlist::write(elements, card, split(measureCommands, '\n'));
+        workerClient.submit(IP, WORKER_PORT, netlist, "data/worker.tmp");      // خطای اتصال با applyRemote می‌رسد
+    };
+    auto runReceivedAnalyze=[&](const vector<string> &receivedData){
+        if (receivedData.size() < 12) return;
+        analyzeType=receivedData[0],
+        transientStart=receivedData[1],
+        transientStop=receivedData[2],
+        transientStep=receivedData[3],
+        acSweepType=receivedData[4],
+        acStartFreq=receivedData[5],
+        acStopFreq=receivedData[6],
+        acPoints=receivedData[7],
+        phaseBaseFreq=receivedData[8],
+        phaseStart=receivedData[9],
+        phaseStop=receivedData[10],
+        phasePoints=receivedData[11];
         if(analyzeType == "Transient") {
-            auto unitHandler=[](string input, string type)->double {
-                regex pattern(R"(^\s*([+-]?[\d]*\.?[\d]+(?:[eE][+-]?[\d]+)?)\s*(Meg|[numkMG])?\s*$)");
-                smatch match;
-                if (regex_match(input, match, pattern)) {
-                    double value = stod(match[1]);
-                    string unit = match[2].str();
-                    double multiplier = 1.0;
-                    if (unit == "n") multiplier = 1e-9;
-                    else if (unit == "u") multiplier = 1e-6;
-                    else if (unit == "m") multiplier = 1e-3;
-                    else if (unit == "k") multiplier = 1e3;
-                    else if (unit == "M" || unit == "Meg") multiplier = 1e6;
-                    else if (unit == "G") multiplier = 1e9;
-                    if (value < 0) {
-                        throw invalidValue(type);
-                    }
-                    return value * multiplier;
-                } else {
-                    throw invalidValue(type);
-                }
-                return -1.0;
-            };
             SDL_Log("Transient analysis set: Start=%s, Stop=%s, Step=%s",
                     transientStart.c_str(), transientStop.c_str(), transientStep.c_str());
             try{
-                cout<<analyzeTransient(unitHandler(transientStart,"StartTime"),unitHandler(transientStop,"StopTime"),unitHandler(transientStep,"Time Step")
-                        ,Wire::allNodes,elements);
+                Measurements::Session measures = measurementsFor("tran");
+                runTransient(measures);
+                showProfile();
+                showMeasurements(measures);
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9516,7 +12520,10 @@ int main(int, char**) {
                     acSweepType.c_str(), acStartFreq.c_str(), acStopFreq.c_str(), acPoints.c_str());
 
             try{
-                cout<<analyzeAc(acSweepType,acStartFreq,acStopFreq,acPoints,wire.componentId,elements,labels);
+                Measurements::Session measures = measurementsFor("ac");
+                cout<<analyzeAc(acSweepType,acStartFreq,acStopFreq,acPoints,wire.componentId,elements,labels,&measures);
+                showProfile();
+                showMeasurements(measures);
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9529,6 +12536,7 @@ int main(int, char**) {
 
             try{
                 cout<<analyzePhase(acStartFreq,acStopFreq,acPoints,wire.componentId,phaseBaseFreq,elements,labels);
+                showProfile();
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9539,6 +12547,7 @@ int main(int, char**) {
             SDL_Log("op");
             try{
                 analyzeOp(errorBox, wire.componentId, elements,labels);
+                showProfile();
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9549,7 +12558,9 @@ int main(int, char**) {
             SDL_Log("DC Sweep set: Source=%s, Start=%s, End=%s, Step=%s",
                     dcSource.c_str(), dcStart.c_str(), dcEnd.c_str(), dcStep.c_str());
             try{
-                cout<<DCSweep(wire.componentId,elements,dcSource,dcStart,dcEnd,dcStep,labels);
+                SaveList save = saveList();
+                cout<<DCSweep(wire.componentId,elements,dcSource,dcStart,dcEnd,dcStep,labels,&save);
+                showProfile();
             }
             catch (const exception &e){
                 errorBox.setMessage(e.what());
@@ -9557,10 +12568,69 @@ int main(int, char**) {
             }
         }
     };
+    clientMenu.items[2].onClick=[&](){
+        Executor::instance().post([&]() -> Executor::Completion {
+            vector<string> receivedData = fetchAnalyze();
+            return [&, receivedData]() { runReceivedAnalyze(receivedData); };
+        });
+    };
+    // اجرای قبلی بسته نشده: snapshot خودکار و رکوردهای دفتر بعد از آن
+    if (!crashRecords.empty() || ifstream(autosavePath).good()) {
+        const SDL_MessageBoxButtonData buttons[] = {
+                { SDL_MESSAGEBOX_BUTTON_RETURNKEY_DEFAULT, 1, "recover" },
+                { SDL_MESSAGEBOX_BUTTON_ESCAPEKEY_DEFAULT, 0, "discard" },
+        };
+        const SDL_MessageBoxData messageboxdata = {
+                SDL_MESSAGEBOX_WARNING,
+                win,
+                "Recover circuit",
+                "CircuNet was not closed normally. Do you want to recover the last circuit?",
+                SDL_arraysize(buttons),
+                buttons,
+                nullptr
+        };
+        int buttonid;
+        if (SDL_ShowMessageBox(&messageboxdata, &buttonid) >= 0 && buttonid == 1) {
+            try {
+                uint64_t savedSeq = 0;
+                Project::Container snapshot;
+                if (snapshot.open(autosavePath)) {
+                    loadAll(autosavePath);
+                    std::istringstream seqIn(snapshot.read("JSEQ"));
+                    cereal::BinaryInputArchive seqArchive(seqIn);
+                    seqArchive(savedSeq);
+                    std::istringstream nameIn(snapshot.read("NAME"));
+                    cereal::BinaryInputArchive nameArchive(nameIn);
+                    nameArchive(nameFile, isOnceSave);
+                }
+                for (auto &record : crashRecords) {
+                    if (record.seq <= savedSeq) continue;
+                    for (auto &edit : decode(record.payload)) Editing::apply(edit, scene);
+                }
+            }
+            catch (const exception &ex) {
+                errorBox.setTitle("error");
+                errorBox.setMessage(string("Recovery stopped: ") + ex.what());
+                errorBox.show();
+            }
+        }
+        else {
+            std::remove(journalPath.c_str());
+        }
+        crashRecords.clear();
+    }
+    // snapshot مدار فعلی (بازیابی شده یا خالی) و بعد از نوشتن آن خالی شدن دفتر قبلی
+    resetEditing();
 //------------------------------------------------
     while (running) {
+        Tracing::ScopedEvent frameTrace("frame", "ui");
+        Tracing::ScopedEvent eventsTrace("handle events", "ui");
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) running = false;
+            if (Executor::instance().owns(e)) {
+                Executor::instance().dispatch(e);
+                continue;
+            }
 
             bool eventHandled = false;
 
@@ -9577,6 +12647,10 @@ int main(int, char**) {
             if (!eventHandled) eventHandled = analyzeDialog.handleEvent(e);
             if (!eventHandled) eventHandled = labelDialog.handleEvent(e);
             if (!eventHandled) eventHandled = errorBox.handleEvent(e);
+            if (!eventHandled) eventHandled = profileBox.handleEvent(e);
+            if (!eventHandled) eventHandled = traceBox.handleEvent(e);
+            if (!eventHandled) eventHandled = measureBox.handleEvent(e);
+            if (!eventHandled) eventHandled = sweepBox.handleEvent(e);
 
             // هندلر کلیک روی دکمه‌ها
             if (!eventHandled){
@@ -9799,9 +12873,29 @@ int main(int, char**) {
                         }
                     }
                 }
-                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_z &&
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_t &&
                     (e.key.keysym.mod & KMOD_CTRL)) {
-                    if (!probes.empty()) {
+                    Tracing::Tracer &tracer = Tracing::Tracer::instance();
+                    if (!tracer.isEnabled()) {
+                        tracer.start();
+                        SDL_Log("Trace recording started");
+                    } else {
+                        tracer.stop();
+                        bool saved = tracer.writeJson(tracePath);
+                        traceBox.setMessage(saved ? to_string(tracer.eventCount()) + " events saved to " + tracePath
+                                                  : "Could not write " + tracePath);
+                        traceBox.show();
+                    }
+                }
+                // Ctrl+Z آخرین تغییر مدار و اگر نبود آخرین پروب؛ Ctrl+Y یا Ctrl+Shift+Z دوباره انجام
+                bool redoKey = e.type == SDL_KEYDOWN && (e.key.keysym.mod & KMOD_CTRL) &&
+                               (e.key.keysym.sym == SDLK_y || (e.key.keysym.sym == SDLK_z && (e.key.keysym.mod & KMOD_SHIFT)));
+                if (redoKey) undoRedo(true);
+                else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_z &&
+                    (e.key.keysym.mod & KMOD_CTRL)) {
+                    trackEdits(true);
+                    if (history.canUndo()) undoRedo(false);
+                    else if (!probes.empty()) {
                         probes.pop_back(); // حذف آخرین پروب
                         probeExpressions.clear();
                         for (const auto& probe : probes) {
@@ -9825,6 +12919,54 @@ int main(int, char**) {
                     }
                     probeExpressions = in;
                 }
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_m &&
+                    e.key.keysym.mod & KMOD_CTRL){
+                    cout<<"Enter measurements (e.g. .meas tran rise TRIG V(out) VAL=0.1 RISE=1 TARG V(out) VAL=0.9 RISE=1), end to finish"<<endl;
+                    string in="";
+                    string line;
+                    while (getline(cin, line) && line != "end") {
+                        if (!line.empty()) in += line + "\n";
+                    }
+                    try {
+                        Measurements::Session check;
+                        check.addLines(in);
+                        measureCommands = in;
+                    }
+                    catch (const exception &ex) {
+                        errorBox.setTitle("error");
+                        errorBox.setMessage(ex.what());
+                        errorBox.show();
+                    }
+                }
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_b &&
+                    e.key.keysym.mod & KMOD_CTRL){
+                    cout<<"Enter sweep (e.g. .step R1 list 1k 2k, .step C1 gauss 5%, .step runs 500), end to finish; empty keeps the last sweep"<<endl;
+                    string in="";
+                    string line;
+                    while (getline(cin, line) && line != "end") {
+                        if (!line.empty()) in += line + "\n";
+                    }
+                    if (!in.empty()) sweepCommands = in;
+                    try {
+                        Sweeps::Plan plan;
+                        plan.addLines(sweepCommands);
+                        if (plan.empty()) throw runtime_error("no .step commands");
+                        Measurements::Session measures = measurementsFor("tran");
+                        if (measures.empty()) throw runtime_error("sweep results are .meas tran values; add them with Ctrl+M");
+                        vector<Sweeps::Run> runs = sweepTransient(plan, measures, unitHandlerNonNegative(transientStart,"StartTime"),
+                                                                  unitHandlerNonNegative(transientStop,"StopTime"),
+                                                                  unitHandlerNonNegative(transientStep,"Time Step"), elements);
+                        bool saved = Sweeps::writeCsv("data/sweep.csv", plan, runs);
+                        sweepBox.setMessage(Sweeps::summary(runs) + (saved ? "runs written to data/sweep.csv" : ""));
+                        sweepBox.show();
+                        showProfile();
+                    }
+                    catch (const exception &ex) {
+                        errorBox.setTitle("error");
+                        errorBox.setMessage(ex.what());
+                        errorBox.show();
+                    }
+                }
                 // به‌روزرسانی موقعیت ماوس برای خط موقت
                 if (wire.isActive) {
                     int mouseX, mouseY;
@@ -9834,6 +12976,8 @@ int main(int, char**) {
             }
         }
 
+        eventsTrace.end();
+
         // رسم
         SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
         SDL_RenderClear(ren);
@@ -9842,7 +12986,31 @@ int main(int, char**) {
         // رسم خطوط (هم کامل شده و هم موقت)
         wire.draw(ren);
         wire.deleteline();
-        wire.newCircuit();
+        {
+            // تغییرات این فریم در دفتر و undo؛ نوشتن فایل در پس‌زمینه
+            Tracing::ScopedEvent trace("journal", "ui");
+            applyRemote();
+            applyFollowedResults();
+            applyFollowed();
+            trackEdits(true);
+            // مدار بدون رکورد تازه از آخرین snapshot دوباره سریالایز نمی‌شود
+            if (journal.sinceCheckpoint() >= autosaveRecords || SDL_GetTicks() - lastAutosave >= autosaveInterval) {
+                if (journal.sinceCheckpoint() > 0) autosave();
+                else lastAutosave = SDL_GetTicks();
+            }
+        }
+        for (auto &label : labels) {
+            if (label->isPlacing || label->isDragging) topologyDirty = true;
+        }
+        uint64_t topologyNow = topologySignature();
+        if (topologyNow != topologySeen) topologyDirty = true;
+        topologySeen = topologyNow;
+        if (topologyDirty) {
+            Tracing::ScopedEvent trace("wire.newCircuit", "ui");
+            wire.newCircuit();
+            topologyDirty = false;
+        }
+        Tracing::ScopedEvent renameTrace("rename nodes", "ui");
         for (auto &gnd : gndSymbols) {
             if (!gnd->isPlacing) { // فقط نمادهای قرار داده شده را پردازش کنیم
                 gnd->RenameNode();
@@ -9851,6 +13019,7 @@ int main(int, char**) {
         for (auto &i:labels) {
             i->RenameNodes();
         }
+        renameTrace.end();
 
 
         // رسم المان‌ها، دکمه‌ها و سایر عناصر
@@ -9915,6 +13084,10 @@ int main(int, char**) {
         elementDialog.draw(ren);
         analyzeDialog.draw(ren);
         labelDialog.draw(ren);
+        profileBox.draw(ren);
+        traceBox.draw(ren);
+        measureBox.draw(ren);
+        sweepBox.draw(ren);
         errorBox.draw(ren);
 
         networkMenu.draw(ren);
@@ -9923,6 +13096,13 @@ int main(int, char**) {
 
         SDL_RenderPresent(ren);
     }
+    if (Tracing::Tracer::instance().isEnabled()) {
+        Tracing::Tracer::instance().stop();
+        Tracing::Tracer::instance().writeJson(tracePath);
+    }
+    // خروج عادی: ذخیره‌های در صف تمام می‌شوند و چیزی برای بازیابی نمی‌ماند
+    journal.discard();
+    std::remove(autosavePath.c_str());
     wire.clear();
     SDL_StopTextInput();
     //TTF_CloseFont(font);